@@ -195,38 +195,20 @@ class ess01
 {
     public :
 
-    double operator () (const vsmc::Particle<T> &particle,
-            const double *mul_weight) const
-    {return particle.weight_set().ess(mul_weight, false);}
-};
-
-template <typename T>
-class cess01
-{
-    public :
-
-    double operator () (const vsmc::Particle<T> &particle,
-            const double *mul_weight) const
-    {return particle.weight_set().cess(mul_weight, false);}
-};
-
-template <typename T, typename ESS> class ess_new;
+    static const bool use_cess = false;
 
-template <typename T>
-class ess_new<T, ess01<T> >
-{
-    public :
-
-    double operator () (const vsmc::Particle<T> &particle, double drop) const
+    double operator() (const vsmc::Particle<T> &particle, double drop) const
     {return (1 - drop) * particle.weight_set().ess();}
 };
 
 template <typename T>
-class ess_new<T, cess01<T> >
+class cess01
 {
     public :
 
-    double operator () (const vsmc::Particle<T> &, double drop) const
+    static const bool use_cess = true;
+
+    double operator() (const vsmc::Particle<T> &, double drop) const
     {return 1 - drop;}
 };
 
@@ -241,49 +223,23 @@ class alpha_ess
 
     void alpha_iter (std::size_t, vsmc::Particle<T> &particle)
     {
-        using std::exp;
-
         log_likelihood_.resize(particle.size());
-        mul_weight_.resize(particle.size());
         for (typename vsmc::Particle<T>::size_type i = 0;
                 i != particle.size(); ++i)
             log_likelihood_[i] = particle.value().state(i,0).log_likelihood();
 
-        double ess_new = ess_new_(particle, ess_drop_);
-
         double e = 1e-10 > 1e-3 * ess_drop_ ? 1e-10 : 1e-3 * ess_drop_;
         double l = particle.value().state(0, 0).alpha();
-        double u = 1.05;
-        double a = l + 0.05;
-        double a_old = l;
-        double ess = 0;
-        while (std::abs(u - l) > e && l <= 1) {
-            double a_diff = a - a_old;
-            for (typename vsmc::Particle<T>::size_type i = 0;
-                    i != particle.size(); ++i) {
-                mul_weight_[i] = a_diff * log_likelihood_[i];
-            }
-            for (typename vsmc::Particle<T>::size_type i = 0;
-                    i != particle.size(); ++i)
-                mul_weight_[i] = exp(mul_weight_[i]);
-            ess = ess_(particle, &mul_weight_[0]);
-            if (ess < ess_new) {
-                u = a;
-                a = 0.5 * (a + l);
-            } else {
-                l = a;
-                a = 0.5 * (a + u);
-            }
-        }
+        double a = l + particle.weight_set().ess_bisect(
+                log_likelihood_.begin(), 0, 1 - l, ess_(particle, ess_drop_),
+                ESS::use_cess, e);
         particle.value().alpha(a);
     }
 
     private :
 
     std::vector<double> log_likelihood_;
-    std::vector<double> mul_weight_;
     ESS ess_;
-    ess_new<T, ESS> ess_new_;
     double ess_drop_;
 };
 
@@ -66,6 +66,8 @@
     PF_CV_DO(Systematic);                                                    \
     PF_CV_DO(ResidualStratified);                                            \
     PF_CV_DO(ResidualSystematic);                                            \
+    PF_CV_DO(Metropolis);                                                    \
+    PF_CV_DO(Rejection);                                                     \
     return 0;
 
 #define PF_MAIN_MPI vsmc::MPIEnvironment env(argc, argv); PF_MAIN;
@@ -94,6 +94,8 @@ int main (int argc, char **argv)
     PF_CV_DO(Systematic);
     PF_CV_DO(ResidualStratified);
     PF_CV_DO(ResidualSystematic);
+    PF_CV_DO(Metropolis);
+    PF_CV_DO(Rejection);
 
     return 0;
 }
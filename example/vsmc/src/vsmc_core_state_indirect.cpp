@@ -0,0 +1,165 @@
+//============================================================================
+// vSMC/example/vsmc/src/vsmc_core_state_indirect.cpp
+//----------------------------------------------------------------------------
+//                         vSMC: Scalable Monte Carlo
+//----------------------------------------------------------------------------
+// Copyright (c) 2013-2015, Yan Zhou
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//   Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+//   Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//============================================================================
+
+#include <vsmc/core/state_indirect.hpp>
+#include <vsmc/resample/common.hpp>
+#include <vsmc/smp/backend_std.hpp>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+typedef vsmc::StateMatrix<vsmc::RowMajor, 2, double> base_type;
+typedef vsmc::StateIndirect<base_type> serial_type;
+typedef vsmc::StateIndirect<vsmc::StateSTD<base_type> > parallel_type;
+typedef base_type::size_type size_type;
+
+// Mutate the particles with nonzero flags in a range, such that the new
+// state depends on both the old one and the particle
+template <typename State>
+class Mutate
+{
+    public :
+
+    Mutate (State *state, const std::vector<int> *flag, double r) :
+        state_(state), flag_(flag), r_(r) {}
+
+    void operator() (const vsmc::BlockedRange<size_type> &range) const
+    {
+        for (size_type i = range.begin(); i != range.end(); ++i) {
+            if ((*flag_)[i] == 0)
+                continue;
+            const double x = state_->state(i, 0);
+            state_->state(i, 0) = 0.5 * x + static_cast<double>(i) + r_;
+            state_->state(i, 1) += x;
+        }
+    }
+
+    private :
+
+    State *const state_;
+    const std::vector<int> *const flag_;
+    const double r_;
+}; // class Mutate
+
+template <typename State>
+inline int check_state (const State &state, const base_type &ref,
+        const char *name, std::size_t r)
+{
+    const size_type N = ref.size();
+    std::vector<double> x(N * 2);
+    std::vector<double> y(N * 2);
+    state.template read_state_matrix<vsmc::RowMajor>(x.begin());
+    ref.read_state_matrix<vsmc::RowMajor>(y.begin());
+    if (x != y) {
+        std::cout << "ERROR: " << name << ": states differ after round "
+            << r << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+// Drive a StateIndirect and a plain StateMatrix with the same resampling
+// and mutations, and compare their states after each round. The resampling
+// has many duplicates, and a random subset of particles is mutated in each
+// round, such that some particles sharing a slot are copied and others
+// take the slot over or are never copied at all
+template <typename State, typename MutateFunc>
+inline int check_state_indirect (const char *name, MutateFunc mutate)
+{
+    const size_type N = 1000;
+    const std::size_t R = 20;
+    State state(N);
+    base_type ref(N);
+    for (size_type i = 0; i != N; ++i) {
+        state.state(i, 0) = ref.state(i, 0) = static_cast<double>(i);
+        state.state(i, 1) = ref.state(i, 1) = 0;
+    }
+
+    vsmc::cxx11::mt19937 eng;
+    vsmc::cxx11::uniform_int_distribution<size_type> rsrc(0, N / 4);
+    vsmc::cxx11::uniform_int_distribution<int> rflag(0, 2);
+    std::vector<size_type> replication(N);
+    std::vector<size_type> copy_from(N);
+    std::vector<int> flag(N);
+    int err = 0;
+    for (std::size_t r = 0; r != R; ++r) {
+        // Every fifth round compacts the storage during the resampling,
+        // and the round after that calls compact after the mutations
+        state.compact_threshold(r % 5 == 4 ? 0 :
+                VSMC_STATE_INDIRECT_COMPACT_THRESHOLD);
+        std::fill(replication.begin(), replication.end(), 0);
+        for (size_type i = 0; i != N; ++i)
+            ++replication[rflag(eng) == 0 ? i : rsrc(eng) * 3 % N];
+        vsmc::internal::cfrp_trans(N, N, &replication[0], &copy_from[0]);
+        state.copy(N, &copy_from[0]);
+        ref.copy(N, &copy_from[0]);
+        err += check_state(state, ref, name, r);
+
+        for (size_type i = 0; i != N; ++i)
+            flag[i] = rflag(eng) != 0;
+        const double shift = static_cast<double>(r);
+        mutate(vsmc::BlockedRange<size_type>(0, N),
+                Mutate<State>(&state, &flag, shift));
+        mutate(vsmc::BlockedRange<size_type>(0, N),
+                Mutate<base_type>(&ref, &flag, shift));
+        if (r % 5 == 0)
+            state.compact();
+        err += check_state(state, ref, name, r);
+    }
+
+    return err;
+}
+
+struct MutateSerial
+{
+    template <typename WorkType>
+    void operator() (const vsmc::BlockedRange<size_type> &range,
+            const WorkType &work) const
+    {work(range);}
+};
+
+struct MutateParallel
+{
+    template <typename WorkType>
+    void operator() (const vsmc::BlockedRange<size_type> &range,
+            const WorkType &work) const
+    {vsmc::parallel_for(range, work);}
+};
+
+int main ()
+{
+    int err = 0;
+    err += check_state_indirect<serial_type>("Serial", MutateSerial());
+    err += check_state_indirect<parallel_type>("STD", MutateParallel());
+
+    return err == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
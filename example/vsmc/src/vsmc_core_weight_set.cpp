@@ -0,0 +1,93 @@
+//============================================================================
+// vSMC/example/vsmc/src/vsmc_core_weight_set.cpp
+//----------------------------------------------------------------------------
+//                         vSMC: Scalable Monte Carlo
+//----------------------------------------------------------------------------
+// Copyright (c) 2013-2015, Yan Zhou
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//   Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+//   Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//============================================================================
+
+#include <vsmc/core/weight_set.hpp>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+// The exponent found by ess_bisect shall not exceed the true solution by
+// more than the tolerance, and it shall be the upper bound only if the ESS
+// at the upper bound is not smaller than the target
+inline int check_ess_bisect (const vsmc::WeightSet &ws,
+        const std::vector<double> &ll, double alpha, double tol)
+{
+    const std::size_t N = ll.size();
+    std::vector<double> inc(N);
+    for (std::size_t i = 0; i != N; ++i)
+        inc[i] = alpha * ll[i];
+    // Allow for rounding differences between ess and ess_bisect
+    const double target = ws.ess(inc.begin(), true) * (1 - 1e-12);
+    const double a = ws.ess_bisect(ll.begin(), 0, 1, target, false, tol);
+    for (std::size_t i = 0; i != N; ++i)
+        inc[i] = a * ll[i];
+    const double ess = ws.ess(inc.begin(), true);
+
+    std::cout << "Exponent: " << alpha << ", Found: " << a
+        << ", ESS: " << ess << ", Target: " << target << std::endl;
+    if (alpha < 1 && !(a < 1)) {
+        std::cout << "ERROR: the upper bound is returned" << std::endl;
+        return 1;
+    }
+    if (std::fabs(a - alpha) > tol) {
+        std::cout << "ERROR: the exponent is not within tolerance"
+            << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+int main ()
+{
+    const std::size_t N = 1000;
+    std::vector<double> ll(N);
+    for (std::size_t i = 0; i != N; ++i)
+        ll[i] = -10 * static_cast<double>(i) / static_cast<double>(N);
+    vsmc::WeightSet ws(N);
+    ws.set_equal_weight();
+
+    const double tol = 1e-6;
+    int err = 0;
+    // The first sweep keeps the last grid cell, which ends at the upper bound
+    err += check_ess_bisect(ws, ll, 0.9, tol);
+    // The second sweep keeps its last grid cell as well
+    err += check_ess_bisect(ws, ll, 0.995, tol);
+    err += check_ess_bisect(ws, ll, 0.9999, tol);
+    // Interior solutions
+    err += check_ess_bisect(ws, ll, 0.5, tol);
+    err += check_ess_bisect(ws, ll, 0.01, tol);
+    // The solution is the upper bound itself
+    err += check_ess_bisect(ws, ll, 1, tol);
+
+    return err == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
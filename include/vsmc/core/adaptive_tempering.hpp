@@ -0,0 +1,231 @@
+//============================================================================
+// vSMC/include/vsmc/core/adaptive_tempering.hpp
+//----------------------------------------------------------------------------
+//                         vSMC: Scalable Monte Carlo
+//----------------------------------------------------------------------------
+// Copyright (c) 2013-2015, Yan Zhou
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//   Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+//   Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//============================================================================
+
+#ifndef VSMC_CORE_ADAPTIVE_TEMPERING_HPP
+#define VSMC_CORE_ADAPTIVE_TEMPERING_HPP
+
+#include <vsmc/internal/common.hpp>
+#include <vsmc/core/weight_set.hpp>
+#include <vsmc/utility/aligned_memory.hpp>
+
+#define VSMC_RUNTIME_ASSERT_CORE_ADAPTIVE_TEMPERING_FUNCTOR(func, caller) \
+    VSMC_RUNTIME_ASSERT(static_cast<bool>(func),                             \
+            ("**AdaptiveTempering::"#caller"** INVALID EVALUATION OBJECT"))
+
+namespace vsmc {
+
+/// \brief Adaptive tempering of the likelihood
+/// \ingroup Core
+///
+/// \details
+/// The target distribution at temperature \f$\alpha\in[0,1]\f$ is
+/// \f$\pi_\alpha(x)\propto\pi_0(x)L(x)^\alpha\f$. Each call to
+/// `operator()`, which has the signature of `Sampler<T>::move_type`, evaluates
+/// the log-likelihoods \f$\ell_i = \log L(X_i)\f$ of all particles once and
+/// caches them, finds the next temperature such that the ESS (or CESS) drops
+/// by a given proportion, updates the logarithm weights in place by adding
+/// \f$(\alpha_{\mathrm{new}} - \alpha)\ell_i\f$ and accumulates the
+/// logarithm of the ratio of normalizing constants.
+///
+/// The next temperature is found by `WeightSet::ess_bisect`, which evaluates
+/// a group of candidate temperatures in each pass over the cached
+/// log-likelihoods with vectorized exponentiation (`math::vExp`).
+///
+/// The current temperature is needed by the MCMC moves that follow. Since
+/// Sampler stores a copy of a move, add a reference to the object instead,
+/// for example,
+/// ~~~{.cpp}
+/// AdaptiveTempering<T> tempering(log_likelihood);
+/// sampler.move(std::ref(tempering), false).mcmc(mcmc, false);
+/// ~~~
+/// (or `boost::ref` without C++11), and then the MCMC moves can read
+/// `tempering.alpha()`. The sampler can be iterated until
+/// `tempering.alpha()` reaches one.
+template <typename T>
+class AdaptiveTempering
+{
+    public :
+
+    typedef T value_type;
+    typedef cxx11::function<
+        void (std::size_t, const Particle<T> &, double *)> eval_type;
+
+    /// \brief Construct an AdaptiveTempering with an evaluation object
+    ///
+    /// \param eval The evaluation object of type AdaptiveTempering::eval_type
+    /// \param drop The proportion of the ESS (or CESS) to drop in each
+    /// iteration
+    /// \param use_cess Use the CESS instead of the ESS
+    /// \param tol The tolerance of the temperature
+    ///
+    /// The evaluation object has the signature
+    /// ~~~{.cpp}
+    /// void eval (std::size_t iter, const Particle<T> &particle,
+    ///     double *log_likelihood)
+    /// ~~~
+    /// and it shall write the log-likelihoods of all particles to the output
+    /// array `log_likelihood` of length `particle.size()`.
+    ///
+    /// With the ESS, the next temperature is such that the ESS after the
+    /// update of weights is `(1 - drop)` times the current ESS. With the
+    /// CESS, it is such that the CESS is `(1 - drop)`.
+    explicit AdaptiveTempering (const eval_type &eval, double drop = 0.1,
+            bool use_cess = false, double tol = 1e-10) :
+        eval_(eval), drop_(drop), use_cess_(use_cess), tol_(tol),
+        alpha_(0), alpha_inc_(0), log_zconst_(0) {}
+
+    /// \brief The proportion of the ESS (or CESS) to drop in each iteration
+    double drop () const {return drop_;}
+
+    /// \brief Set the proportion of the ESS (or CESS) to drop
+    void drop (double d) {drop_ = d;}
+
+    /// \brief If the CESS is used instead of the ESS
+    bool use_cess () const {return use_cess_;}
+
+    /// \brief The current temperature
+    double alpha () const {return alpha_;}
+
+    /// \brief The increment of the temperature in the last iteration
+    double alpha_inc () const {return alpha_inc_;}
+
+    /// \brief The logarithm of the ratio of normalizing constants between
+    /// the current temperature and zero
+    double log_zconst () const {return log_zconst_;}
+
+    /// \brief The number of iterations has been recorded
+    std::size_t iter_size () const {return index_.size();}
+
+    /// \brief Read the iteration numbers through an output iterator
+    template <typename OutputIter>
+    void read_index (OutputIter first) const
+    {std::copy(index_.begin(), index_.end(), first);}
+
+    /// \brief Read the temperatures of each iteration through an output
+    /// iterator
+    template <typename OutputIter>
+    void read_alpha (OutputIter first) const
+    {std::copy(alpha_history_.begin(), alpha_history_.end(), first);}
+
+    /// \brief Read only access to the log-likelihoods cached in the last
+    /// iteration
+    const double *log_likelihood_data () const
+    {return log_likelihood_.size() == 0 ? VSMC_NULLPTR : &log_likelihood_[0];}
+
+    /// \brief Reset the temperature, normalizing constant and records
+    void reset ()
+    {
+        alpha_ = 0;
+        alpha_inc_ = 0;
+        log_zconst_ = 0;
+        index_.clear();
+        alpha_history_.clear();
+    }
+
+    /// \brief Find the next temperature and update the weights
+    std::size_t operator() (std::size_t iter, Particle<T> &particle)
+    {
+        VSMC_RUNTIME_ASSERT_CORE_ADAPTIVE_TEMPERING_FUNCTOR(
+                eval_, operator());
+
+        const std::size_t N = static_cast<std::size_t>(particle.size());
+        log_likelihood_.resize(N);
+        inc_weight_.resize(N);
+        double *const llptr = N == 0 ? VSMC_NULLPTR : &log_likelihood_[0];
+        eval_(iter, particle, llptr);
+
+        const double target = use_cess_ ?
+            1 - drop_ : (1 - drop_) * particle.weight_set().ess();
+        double a = particle.weight_set().ess_bisect(llptr, 0, 1 - alpha_,
+                target, use_cess_, tol_);
+        if (a < 0)
+            a = 0;
+        alpha_inc_ = a;
+        alpha_ = alpha_ + a < 1 ? alpha_ + a : 1;
+        log_zconst_ += update_weight(particle, llptr, a);
+        index_.push_back(iter);
+        alpha_history_.push_back(alpha_);
+
+        return 0;
+    }
+
+    private :
+
+    eval_type eval_;
+    double drop_;
+    bool use_cess_;
+    double tol_;
+    double alpha_;
+    double alpha_inc_;
+    double log_zconst_;
+    std::vector<std::size_t> index_;
+    std::vector<double> alpha_history_;
+    std::vector<double, AlignedAllocator<double> > log_likelihood_;
+    std::vector<double, AlignedAllocator<double> > inc_weight_;
+
+    // Add a * ll to the logarithm weights and return the logarithm of the
+    // sum of W_i * exp(a * ll_i), where W_i are the normalized weights
+    // before the update, or zero if there are no particles
+    double update_weight (Particle<T> &particle, const double *llptr,
+            double a)
+    {
+        using std::log;
+
+        const std::size_t N = inc_weight_.size();
+        double *const iptr = N == 0 ? VSMC_NULLPTR : &inc_weight_[0];
+        const double *const wptr = particle.weight_set().weight_data();
+        double dmax = -std::numeric_limits<double>::max VSMC_MNE ();
+        for (std::size_t i = 0; i != N; ++i) {
+            iptr[i] = a * llptr[i];
+            if (dmax < iptr[i])
+                dmax = iptr[i];
+        }
+
+        const std::size_t B = VSMC_WEIGHT_SET_BLOCK_SIZE;
+        double buffer[B];
+        double sum = 0;
+        for (std::size_t b = 0; b < N; b += B) {
+            const std::size_t n = N - b < B ? N - b : B;
+            for (std::size_t i = 0; i != n; ++i)
+                buffer[i] = iptr[b + i] - dmax;
+            math::vExp(n, buffer, buffer);
+            for (std::size_t i = 0; i != n; ++i)
+                sum += wptr[b + i] * buffer[i];
+        }
+        particle.weight_set().add_log_weight(iptr);
+
+        return N == 0 ? 0 : log(sum) + dmax;
+    }
+}; // class AdaptiveTempering
+
+} // namespace vsmc
+
+#endif // VSMC_CORE_ADAPTIVE_TEMPERING_HPP
@@ -33,6 +33,7 @@
 #define VSMC_CORE_CORE_HPP
 
 #include <vsmc/core/adapter.hpp>
+#include <vsmc/core/adaptive_tempering.hpp>
 #include <vsmc/core/monitor.hpp>
 #include <vsmc/core/particle.hpp>
 #include <vsmc/core/path.hpp>
@@ -46,4 +47,8 @@
 #include <vsmc/core/state_tuple.hpp>
 #endif
 
+#if VSMC_HAS_CXX11LIB_ATOMIC
+#include <vsmc/core/state_indirect.hpp>
+#endif
+
 #endif // VSMC_CORE_CORE_HPP
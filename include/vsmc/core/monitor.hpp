@@ -36,6 +36,10 @@
 #include <vsmc/integrate/is_integrate.hpp>
 #include <vsmc/utility/aligned_memory.hpp>
 
+#define VSMC_STATIC_ASSERT_CORE_MONITOR_MATRIX_ORDER(Order) \
+    VSMC_STATIC_ASSERT((Order == RowMajor || Order == ColMajor),             \
+            USE_RowMajor_OR_ColMajor_WITH_Monitor_read_record_matrix)
+
 #define VSMC_RUNTIME_ASSERT_CORE_MONITOR_ID(func) \
     VSMC_RUNTIME_ASSERT((id < dim()),                                        \
             ("**Monitor::"#func"** INVALID ID NUMBER ARGUMENT"))
@@ -61,6 +65,8 @@ class Monitor
     typedef cxx11::function<
         void (std::size_t, std::size_t, const Particle<T> &, double *)>
         eval_type;
+    typedef cxx11::function<void (std::size_t, std::size_t,
+            const Particle<T> &, const double *, double *)> integrate_type;
 
     /// \brief Construct a Monitor with an evaluation object
     ///
@@ -132,8 +138,10 @@ class Monitor
         record_.reserve(dim_ * num);
     }
 
-    /// \brief Whether the evaluation object is valid
-    bool empty () const {return !static_cast<bool>(eval_);}
+    /// \brief Whether neither the evaluation object nor the integration
+    /// object is valid
+    bool empty () const
+    {return !static_cast<bool>(eval_) && !static_cast<bool>(integrate_);}
 
     /// \brief Read and write access to the names of variables
     ///
@@ -242,10 +250,13 @@ class Monitor
     /// ColMajor`, then, `first[j * iter_size() + i] == record(i, j)`.
     /// Otherwise, if `order == RowMajor`, then `first[i * dim() + j] ==
     /// record(i, j)`. That is, the output is an `iter_size()` by `dim()`
-    /// matrix, with the usual meaning of column or row major order.
+    /// matrix, with the usual meaning of column or row major order. Other
+    /// orders, such as `Blocked`, are not supported.
     template <MatrixOrder Order, typename OutputIter>
     void read_record_matrix (OutputIter first) const
     {
+        VSMC_STATIC_ASSERT_CORE_MONITOR_MATRIX_ORDER(Order);
+
         const std::size_t N = iter_size();
         if (Order == ColMajor) {
             for (std::size_t d = 0; d != dim_; ++d) {
@@ -262,6 +273,31 @@ class Monitor
     /// \brief Set a new evaluation object of type eval_type
     void set_eval (const eval_type &new_eval) {eval_ = new_eval;}
 
+    /// \brief Set a new integration object of type integrate_type
+    ///
+    /// \details
+    /// The integration object has the signature
+    /// ~~~{.cpp}
+    /// void integrate (std::size_t iter, std::size_t dim,
+    ///     const Particle<T> &particle, const double *weight, double *result)
+    /// ~~~
+    /// where `weight` is the vector of the normalized weights. It evaluates
+    /// the particles and integrates the results against the weights, and the
+    /// output parameter `result` shall contain the `dim` importance sampling
+    /// estimates, which are recorded. If an integration object is set, it is
+    /// used instead of the evaluation object, regardless of `record_only()`,
+    /// and the `N` by `dim` matrix of results is never allocated. The
+    /// `MonitorEval` classes of the SMP and OpenCL backends provide such an
+    /// integration, for example,
+    /// ~~~{.cpp}
+    /// Monitor<T> monitor(dim, Monitor<T>::eval_type());
+    /// monitor.set_integrate(MyMonitorEval());
+    /// sampler.monitor("name", monitor);
+    /// ~~~
+    /// An empty object removes the integration object.
+    void set_integrate (const integrate_type &new_integrate)
+    {integrate_ = new_integrate;}
+
     /// \brief Perform the evaluation for a given iteration and a Particle<T>
     /// object.
     ///
@@ -280,10 +316,18 @@ class Monitor
         if (stage != stage_)
             return;
 
-        VSMC_RUNTIME_ASSERT_CORE_MONITOR_FUNCTOR(eval_, eval, EVALUATION);
-
         result_.resize(dim_);
         double *const rptr = &result_[0];
+        if (static_cast<bool>(integrate_)) {
+            integrate_(iter, dim_, particle,
+                    particle.weight_set().weight_data(), rptr);
+            push_back(iter);
+
+            return;
+        }
+
+        VSMC_RUNTIME_ASSERT_CORE_MONITOR_FUNCTOR(eval_, eval, EVALUATION);
+
         if (record_only_) {
             eval_(iter, dim_, particle, rptr);
             push_back(iter);
@@ -321,6 +365,7 @@ class Monitor
 
     std::size_t dim_;
     eval_type eval_;
+    integrate_type integrate_;
     bool recording_;
     bool record_only_;
     MonitorStage stage_;
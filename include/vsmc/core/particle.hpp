@@ -227,22 +227,20 @@ class Particle
     ///     traits::ResamplePostCopyTypeTrait)
     ///     * `post(weight_set)`
     /// 8. `return resampled`
+    ///
+    /// If traits::ResampleLocalTypeTrait of the value collection type is
+    /// `cxx11::true_type` and `value.resample_local()` returns `true`, then
+    /// Step 2 to 6 are replaced by
+    /// `value.resample_copy(op, resample_rng, weight_set.weight_data())`,
+    /// which computes the replication numbers of the particles of this node
+    /// and copies them. See StateMPI::resample_copy.
     bool resample (const resample_type &op, double threshold)
     {
         std::size_t N = static_cast<std::size_t>(weight_set_.resample_size());
         bool resampled = weight_set_.ess() < threshold * N;
         if (resampled) {
-            size_type *cptr = VSMC_NULLPTR;
-            const double *const wptr = weight_set_.resample_weight_data();
-            if (wptr != VSMC_NULLPTR) {
-                copy_from_.resize(N);
-                replication_.resize(N);
-                cptr = &copy_from_[0];
-                size_type *const rptr = &replication_[0];
-                op(N, N, resample_rng_, wptr, rptr);
-                internal::cfrp_trans(N, N, rptr, cptr);
-            }
-            value_.copy(N, cptr);
+            resample_copy(op, N,
+                    typename traits::ResampleLocalTypeTrait<T>::type());
             weight_set_.set_equal_weight();
         }
 
@@ -259,6 +257,31 @@ class Particle
 
     std::vector<size_type, AlignedAllocator<size_type> > copy_from_;
     std::vector<size_type, AlignedAllocator<size_type> > replication_;
+
+    void resample_copy (const resample_type &op, std::size_t N,
+            cxx11::false_type)
+    {
+        size_type *cptr = VSMC_NULLPTR;
+        const double *const wptr = weight_set_.resample_weight_data();
+        if (wptr != VSMC_NULLPTR) {
+            copy_from_.resize(N);
+            replication_.resize(N);
+            cptr = &copy_from_[0];
+            size_type *const rptr = &replication_[0];
+            op(N, N, resample_rng_, wptr, rptr);
+            internal::cfrp_trans(N, N, rptr, cptr);
+        }
+        value_.copy(N, cptr);
+    }
+
+    void resample_copy (const resample_type &op, std::size_t N,
+            cxx11::true_type)
+    {
+        if (value_.resample_local())
+            value_.resample_copy(op, resample_rng_, weight_set_.weight_data());
+        else
+            resample_copy(op, N, cxx11::false_type());
+    }
 }; // class Particle
 
 } // namespace vsmc
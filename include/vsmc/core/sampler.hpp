@@ -37,6 +37,10 @@
 #include <vsmc/core/particle.hpp>
 #include <vsmc/core/path.hpp>
 
+#define VSMC_STATIC_ASSERT_CORE_SAMPLER_MATRIX_ORDER(Order) \
+    VSMC_STATIC_ASSERT((Order == RowMajor || Order == ColMajor),             \
+            USE_RowMajor_OR_ColMajor_WITH_Sampler_summary_data)
+
 #define VSMC_RUNTIME_ASSERT_CORE_SAMPLER_MONITOR_NAME(iter, map, func) \
     VSMC_RUNTIME_ASSERT((iter != map.end()),                                 \
             ("**Sampler::"#func"** INVALID MONITOR NAME"))
@@ -258,6 +262,12 @@ class Sampler
             case ResidualSystematic :
                 resample_op_ = ResampleType<ResidualSystematic>::type();
                 break;
+            case Metropolis :
+                resample_op_ = ResampleType<Metropolis>::type();
+                break;
+            case Rejection :
+                resample_op_ = ResampleType<Rejection>::type();
+                break;
         }
 
         return *this;
@@ -649,9 +659,14 @@ class Sampler
     {return summary_header_size() * iter_size();}
 
     /// \brief Sampler summary data (integer data)
+    ///
+    /// \details
+    /// `Order` shall be either `RowMajor` or `ColMajor`.
     template <MatrixOrder Order, typename OutputIter>
     void summary_data_int (OutputIter first) const
     {
+        VSMC_STATIC_ASSERT_CORE_SAMPLER_MATRIX_ORDER(Order);
+
         if (summary_data_size_int() == 0)
             return;
 
@@ -663,9 +678,14 @@ class Sampler
     }
 
     /// \brief Sampler summary data (floating point data)
+    ///
+    /// \details
+    /// `Order` shall be either `RowMajor` or `ColMajor`.
     template <MatrixOrder Order, typename OutputIter>
     void summary_data (OutputIter first) const
     {
+        VSMC_STATIC_ASSERT_CORE_SAMPLER_MATRIX_ORDER(Order);
+
         if (summary_data_size() == 0)
             return;
 
@@ -0,0 +1,555 @@
+//============================================================================
+// vSMC/include/vsmc/core/state_indirect.hpp
+//----------------------------------------------------------------------------
+//                         vSMC: Scalable Monte Carlo
+//----------------------------------------------------------------------------
+// Copyright (c) 2013-2015, Yan Zhou
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//   Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+//   Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//============================================================================
+
+
+#ifndef VSMC_CORE_STATE_INDIRECT_HPP
+#define VSMC_CORE_STATE_INDIRECT_HPP
+
+#include <vsmc/internal/common.hpp>
+#include <vsmc/core/state_matrix.hpp>
+#include <atomic>
+#if VSMC_HAS_CXX11LIB_THREAD
+#include <thread>
+#endif
+
+/// \brief Default fraction of duplicated particles above which
+/// `StateIndirect` copies particles upon resampling
+/// \ingroup Config
+#ifndef VSMC_STATE_INDIRECT_COMPACT_THRESHOLD
+#define VSMC_STATE_INDIRECT_COMPACT_THRESHOLD 0.9
+#endif
+
+#define VSMC_RUNTIME_ASSERT_CORE_STATE_INDIRECT_COPY_SIZE_MISMATCH \
+    VSMC_RUNTIME_ASSERT((N == static_cast<size_type>(this->size())),         \
+            ("**StateIndirect::copy** SIZE MISMATCH"))
+
+namespace vsmc {
+
+namespace internal {
+
+// An atomic counter that can be stored in a copyable std::vector
+class StateIndirectCounter
+{
+    public :
+
+    StateIndirectCounter () : count_(0) {}
+
+    StateIndirectCounter (const StateIndirectCounter &other) :
+        count_(other.count_.load()) {}
+
+    StateIndirectCounter &operator= (const StateIndirectCounter &other)
+    {
+        count_.store(other.count_.load());
+
+        return *this;
+    }
+
+    std::size_t load () const
+    {return count_.load(std::memory_order_acquire);}
+
+    void reset () {count_.store(0, std::memory_order_relaxed);}
+
+    std::size_t fetch_add () {return count_.fetch_add(1);}
+
+    private :
+
+    std::atomic<std::size_t> count_;
+}; // class StateIndirectCounter
+
+} // namespace vsmc::internal
+
+/// \brief Particle::value_type subtype with copy-on-write resampling
+/// \ingroup Core
+///
+/// \details
+/// `BaseState` is a `StateMatrix` or `StateTuple` (possibly within an SMP
+/// backend, such as `StateSTD<StateMatrix<RowMajor, Dynamic, double> >`).
+/// The states are stored in `size()` slots of `BaseState`, and each particle
+/// refers to a slot through an index map. Upon resampling, `copy` only
+/// updates the map. Particles duplicated by resampling share the same slot
+/// until one of them is first accessed through a non-const member function
+/// (`state`, `operator()`, `row_data` or `state_unpack`), at which time its
+/// state is copied to a slot no longer referred to by any particle,
+/// preferably its own. The last particle sharing a slot takes it over without
+/// copying. Thus particles not mutated before the next resampling, for
+/// example those rejected by a Metropolis move, are never copied, and those
+/// mutated are copied by the thread that mutates them, right before the
+/// state is used.
+///
+/// Over iterations, the states of particles may be moved to slots other than
+/// their own, and a pass over all particles may access the memory less
+/// sequentially. If the fraction of duplicated particles in a resampling
+/// exceeds `compact_threshold()`, the states are copied to their own slots
+/// immediately, as `BaseState::copy` does, and the map becomes the identity.
+/// The same happens when `compact` is called. The const member functions
+/// `read_state`, `read_state_matrix` and `print` read the particles through
+/// the map. Other direct access to the storage of `BaseState`, such as
+/// `data`, `col_data` or `tile_data` of `StateMatrix` and `hdf5store`, sees
+/// the slots instead of the particles unless `compact` is called first.
+///
+/// Different particles can be accessed concurrently, as with `BaseState`.
+/// Use `StateIndirect` as the outermost layer of the value type, such that
+/// `Particle::resample` calls its `copy`.
+///
+/// `BaseState` can be a `StateTuple` only if the compiler supports C++11
+/// `auto`, `decltype`, trailing return types and default template arguments
+/// of function templates. Otherwise, it shall be a `StateMatrix`.
+template <typename BaseState>
+class StateIndirect : public BaseState
+{
+    public :
+
+    typedef typename traits::SizeTypeTrait<BaseState>::type size_type;
+
+    explicit StateIndirect (size_type N) :
+        BaseState(N), compact_threshold_(
+                VSMC_STATE_INDIRECT_COMPACT_THRESHOLD),
+        slot_(N), owned_(N, 1), group_size_(N), offset_(N), dest_(N),
+        dest_group_(N), index_(N), claim_(N), done_(N), cursor_(N),
+        taken_(N)
+    {
+        for (size_type i = 0; i != N; ++i)
+            slot_[i] = i;
+    }
+
+    /// \brief The fraction of duplicated particles above which `copy`
+    /// compacts the storage
+    double compact_threshold () const {return compact_threshold_;}
+
+    /// \brief Set the fraction of duplicated particles above which `copy`
+    /// compacts the storage
+    void compact_threshold (double threshold)
+    {compact_threshold_ = threshold;}
+
+    /// \brief Always `false`, such that an SMP backend wrapping this class
+    /// copies particles through `copy_particle` instead of gathering them
+    /// directly into the back buffer of a double buffered `BaseState`
+    bool double_buffer () const {return false;}
+
+    /// \brief The slot of `BaseState` where the state of a particle is
+    /// currently stored
+    size_type slot (size_type id) const {return slot_[id];}
+
+#if VSMC_HAS_CXX11_AUTO_TYPE && VSMC_HAS_CXX11_DECLTYPE && \
+    VSMC_HAS_CXX11_TRAILING_RETURN && \
+    VSMC_HAS_CXX11_DEFAULT_FUNCTION_TEMPLATE_ARGS
+    template <typename P>
+    auto state (size_type id, P pos) ->
+        decltype(cxx11::declval<BaseState &>().state(id, pos))
+    {return BaseState::state(write_slot(id), pos);}
+
+    template <typename P>
+    auto state (size_type id, P pos) const ->
+        decltype(cxx11::declval<const BaseState &>().state(id, pos))
+    {return BaseState::state(slot_[id], pos);}
+
+    template <std::size_t Pos>
+    auto state (size_type id) ->
+        decltype(cxx11::declval<BaseState &>().template state<Pos>(id))
+    {return BaseState::template state<Pos>(write_slot(id));}
+
+    template <std::size_t Pos>
+    auto state (size_type id) const ->
+        decltype(cxx11::declval<const BaseState &>().template state<Pos>(id))
+    {return BaseState::template state<Pos>(slot_[id]);}
+
+    template <typename P>
+    auto operator() (size_type id, P pos) ->
+        decltype(cxx11::declval<BaseState &>().state(id, pos))
+    {return state(id, pos);}
+
+    template <typename P>
+    auto operator() (size_type id, P pos) const ->
+        decltype(cxx11::declval<const BaseState &>().state(id, pos))
+    {return state(id, pos);}
+
+    template <typename S = BaseState>
+    auto row_data (size_type id) ->
+        decltype(cxx11::declval<S &>().row_data(id))
+    {return BaseState::row_data(write_slot(id));}
+
+    template <typename S = BaseState>
+    auto row_data (size_type id) const ->
+        decltype(cxx11::declval<const S &>().row_data(id))
+    {return BaseState::row_data(slot_[id]);}
+#else // VSMC_HAS_CXX11_AUTO_TYPE etc.
+    typename BaseState::state_type &state (size_type id, std::size_t pos)
+    {return BaseState::state(write_slot(id), pos);}
+
+    const typename BaseState::state_type &state (size_type id,
+            std::size_t pos) const
+    {return BaseState::state(slot_[id], pos);}
+
+    template <std::size_t Pos>
+    typename BaseState::state_type &state (size_type id, Position<Pos>)
+    {return BaseState::state(write_slot(id), Pos);}
+
+    template <std::size_t Pos>
+    const typename BaseState::state_type &state (size_type id,
+            Position<Pos>) const
+    {return BaseState::state(slot_[id], Pos);}
+
+    template <std::size_t Pos>
+    typename BaseState::state_type &state (size_type id)
+    {return BaseState::state(write_slot(id), Pos);}
+
+    template <std::size_t Pos>
+    const typename BaseState::state_type &state (size_type id) const
+    {return BaseState::state(slot_[id], Pos);}
+
+    typename BaseState::state_type &operator() (size_type id,
+            std::size_t pos)
+    {return state(id, pos);}
+
+    const typename BaseState::state_type &operator() (size_type id,
+            std::size_t pos) const
+    {return state(id, pos);}
+
+    typename BaseState::state_type *row_data (size_type id)
+    {return BaseState::row_data(write_slot(id));}
+
+    const typename BaseState::state_type *row_data (size_type id) const
+    {return BaseState::row_data(slot_[id]);}
+#endif // VSMC_HAS_CXX11_AUTO_TYPE etc.
+
+    typename BaseState::state_pack_type state_pack (size_type id) const
+    {return BaseState::state_pack(slot_[id]);}
+
+    void state_unpack (size_type id,
+            const typename BaseState::state_pack_type &pack)
+    {BaseState::state_unpack(write_slot(id), pack);}
+
+#if VSMC_HAS_CXX11_RVALUE_REFERENCES
+    void state_unpack (size_type id,
+            typename BaseState::state_pack_type &&pack)
+    {BaseState::state_unpack(write_slot(id), cxx11::move(pack));}
+#endif
+
+    template <typename IntType>
+    void copy (size_type N, const IntType *copy_from)
+    {
+        VSMC_RUNTIME_ASSERT_CORE_STATE_INDIRECT_COPY_SIZE_MISMATCH;
+
+        for (size_type i = 0; i != N; ++i)
+            index_[i] = slot_[static_cast<size_type>(copy_from[i])];
+        slot_.swap(index_);
+
+        std::fill(group_size_.begin(), group_size_.end(), 0);
+        for (size_type i = 0; i != N; ++i)
+            ++group_size_[slot_[i]];
+        size_type dup = 0;
+        for (size_type s = 0; s != N; ++s)
+            if (group_size_[s] == 0)
+                ++dup;
+
+        if (static_cast<double>(dup) >
+                compact_threshold_ * static_cast<double>(N)) {
+            compact();
+            return;
+        }
+
+        // Each slot s shared by k > 1 particles is given k - 1 free slots,
+        // first those of the particles sharing it and then any others
+        std::vector<size_type> &fill = index_;
+        size_type next = 0;
+        for (size_type s = 0; s != N; ++s) {
+            fill[s] = 0;
+            dest_group_[s] = N;
+            if (group_size_[s] > 1) {
+                offset_[s] = next;
+                next += group_size_[s] - 1;
+                claim_[s].reset();
+                done_[s].reset();
+                cursor_[s].reset();
+            }
+        }
+        for (size_type i = 0; i != N; ++i) {
+            const size_type s = slot_[i];
+            if (group_size_[i] == 0 && fill[s] + 1 < group_size_[s]) {
+                dest_[offset_[s] + fill[s]++] = i;
+                dest_group_[i] = s;
+            }
+        }
+        size_type s = 0;
+        for (size_type t = 0; t != N; ++t) {
+            if (group_size_[t] != 0 || dest_group_[t] != N)
+                continue;
+            while (fill[s] + 1 >= group_size_[s])
+                ++s;
+            dest_[offset_[s] + fill[s]++] = t;
+            dest_group_[t] = s;
+        }
+        for (size_type t = 0; t != N; ++t)
+            if (group_size_[t] == 0)
+                taken_[t].reset();
+
+        for (size_type i = 0; i != N; ++i)
+            owned_[i] = group_size_[slot_[i]] == 1;
+    }
+
+    void copy_particle (size_type from, size_type to)
+    {
+        if (from == to)
+            return;
+
+        const size_type s = slot_[from];
+        BaseState::copy_particle(s, write_slot(to));
+    }
+
+    /// \brief Copy the states of all particles to their own slots, such that
+    /// the map from particles to slots becomes the identity
+    void compact ()
+    {
+        const size_type N = static_cast<size_type>(this->size());
+        bool identity = true;
+        bool direct = true;
+        for (size_type i = 0; i != N; ++i) {
+            identity = identity && slot_[i] == i;
+            direct = direct && slot_[slot_[i]] == slot_[i];
+        }
+
+        if (!identity) {
+            if (direct)
+                BaseState::copy(N, &slot_[0]);
+            else
+                compact_permute();
+            for (size_type i = 0; i != N; ++i)
+                slot_[i] = i;
+        }
+        std::fill(owned_.begin(), owned_.end(), 1);
+    }
+
+    template <typename P, typename OutputIter>
+    void read_state (P pos, OutputIter first) const
+    {
+        const size_type N = static_cast<size_type>(this->size());
+        for (size_type i = 0; i != N; ++i, ++first)
+            *first = state(i, pos);
+    }
+
+    template <std::size_t Pos, typename OutputIter>
+    void read_state (OutputIter first) const
+    {
+        const size_type N = static_cast<size_type>(this->size());
+        for (size_type i = 0; i != N; ++i, ++first)
+            *first = state<Pos>(i);
+    }
+
+    template <typename OutputIterIter>
+    void read_state_matrix (OutputIterIter first) const
+    {
+        for (std::size_t d = 0; d != this->dim(); ++d, ++first)
+            read_state(d, *first);
+    }
+
+    template <MatrixOrder ROrder, typename OutputIter>
+    void read_state_matrix (OutputIter first) const
+    {
+        const size_type N = static_cast<size_type>(this->size());
+        const std::size_t dim = this->dim();
+        if (ROrder == RowMajor) {
+            for (size_type i = 0; i != N; ++i)
+                for (std::size_t d = 0; d != dim; ++d, ++first)
+                    *first = BaseState::state(slot_[i], d);
+        } else if (ROrder == ColMajor) {
+            for (std::size_t d = 0; d != dim; ++d)
+                for (size_type i = 0; i != N; ++i, ++first)
+                    *first = BaseState::state(slot_[i], d);
+        } else {
+            const size_type W = VSMC_STATE_MATRIX_BLOCK_WIDTH;
+            for (size_type t = 0; t < N; t += W) {
+                for (std::size_t d = 0; d != dim; ++d) {
+                    for (size_type i = t; i != t + W; ++i, ++first) {
+                        *first = i < N ? BaseState::state(slot_[i], d) :
+                            typename BaseState::state_type();
+                    }
+                }
+            }
+        }
+    }
+
+    template <typename CharT, typename Traits>
+    std::basic_ostream<CharT, Traits> &print (
+            std::basic_ostream<CharT, Traits> &os, char sepchar = '\t') const
+    {
+        const size_type N = static_cast<size_type>(this->size());
+        if (this->dim() == 0 || N == 0 || !os.good())
+            return os;
+
+        for (size_type i = 0; i != N; ++i) {
+            print_particle(os, slot_[i], sepchar,
+                    static_cast<const BaseState *>(this));
+        }
+
+        return os;
+    }
+
+    private :
+
+    double compact_threshold_;
+    std::vector<size_type> slot_;
+    std::vector<char> owned_;
+    std::vector<size_type> group_size_;
+    std::vector<size_type> offset_;
+    std::vector<size_type> dest_;
+    std::vector<size_type> dest_group_;
+    std::vector<size_type> index_;
+    std::vector<internal::StateIndirectCounter> claim_;
+    std::vector<internal::StateIndirectCounter> done_;
+    std::vector<internal::StateIndirectCounter> cursor_;
+    std::vector<internal::StateIndirectCounter> taken_;
+
+    size_type write_slot (size_type id)
+    {
+        if (!owned_[id])
+            acquire_slot(id);
+
+        return slot_[id];
+    }
+
+    // All but the last of the k particles sharing slot s copy from it to one
+    // of the k - 1 free slots given to s, their own one if it is not taken
+    // yet. The last one takes over s after all others have copied from it
+    void acquire_slot (size_type id)
+    {
+        const size_type s = slot_[id];
+        const size_type k = group_size_[s];
+        if (claim_[s].fetch_add() + 1 < k) {
+            size_type t = id;
+            if (dest_group_[id] != s || taken_[id].fetch_add() != 0) {
+                do t = dest_[offset_[s] + cursor_[s].fetch_add()];
+                while (taken_[t].fetch_add() != 0);
+            }
+            BaseState::copy_particle(s, t);
+            done_[s].fetch_add();
+            slot_[id] = t;
+        } else {
+            while (done_[s].load() + 1 < k) {
+#if VSMC_HAS_CXX11LIB_THREAD
+                std::this_thread::yield();
+#endif
+            }
+        }
+        owned_[id] = 1;
+    }
+
+    template <typename CharT, typename Traits,
+             MatrixOrder Order, std::size_t Dim, typename T>
+    void print_particle (std::basic_ostream<CharT, Traits> &os, size_type s,
+            char sepchar, const StateMatrix<Order, Dim, T> *) const
+    {
+        const std::size_t dim = this->dim();
+        for (std::size_t d = 0; d != dim - 1; ++d)
+            os << BaseState::state(s, d) << sepchar;
+        os << BaseState::state(s, dim - 1) << '\n';
+    }
+
+#if VSMC_HAS_CXX11LIB_TUPLE
+    template <typename CharT, typename Traits,
+             MatrixOrder Order, typename T, typename... Types>
+    void print_particle (std::basic_ostream<CharT, Traits> &os, size_type s,
+            char sepchar, const StateTuple<Order, T, Types...> *) const
+    {
+        print_tuple<0, sizeof...(Types)>(os, s, sepchar,
+                cxx11::integral_constant<bool, sizeof...(Types) == 0>());
+    }
+
+    template <std::size_t Pos, std::size_t Last,
+             typename CharT, typename Traits>
+    void print_tuple (std::basic_ostream<CharT, Traits> &os, size_type s,
+            char sepchar, cxx11::false_type) const
+    {
+        os << BaseState::state(s, Position<Pos>()) << sepchar;
+        print_tuple<Pos + 1, Last>(os, s, sepchar,
+                cxx11::integral_constant<bool, Pos + 1 == Last>());
+    }
+
+    template <std::size_t Pos, std::size_t Last,
+             typename CharT, typename Traits>
+    void print_tuple (std::basic_ostream<CharT, Traits> &os, size_type s,
+            char, cxx11::true_type) const
+    {os << BaseState::state(s, Position<Pos>()) << '\n';}
+#endif
+
+    // Copy the state in slot_[i] to slot i for all i. A slot is overwritten
+    // only after all particles referring to it have copied from it. What
+    // remains are cycles, which are rotated through a temporary state pack
+    void compact_permute ()
+    {
+        const size_type N = static_cast<size_type>(this->size());
+        std::vector<size_type> &ref = group_size_;
+        std::vector<size_type> &ready = index_;
+        std::fill(ref.begin(), ref.end(), 0);
+        for (size_type i = 0; i != N; ++i)
+            if (slot_[i] != i)
+                ++ref[slot_[i]];
+
+        size_type head = 0;
+        size_type tail = 0;
+        for (size_type i = 0; i != N; ++i)
+            if (slot_[i] != i && ref[i] == 0)
+                ready[tail++] = i;
+        while (head != tail) {
+            const size_type i = ready[head++];
+            const size_type s = slot_[i];
+            BaseState::copy_particle(s, i);
+            slot_[i] = i;
+            if (--ref[s] == 0 && slot_[s] != s)
+                ready[tail++] = s;
+        }
+
+        for (size_type i = 0; i != N; ++i) {
+            if (slot_[i] == i)
+                continue;
+            typename BaseState::state_pack_type pack(
+                    BaseState::state_pack(i));
+            size_type j = i;
+            while (slot_[j] != i) {
+                const size_type s = slot_[j];
+                BaseState::copy_particle(s, j);
+                slot_[j] = j;
+                j = s;
+            }
+            BaseState::state_unpack(j, pack);
+            slot_[j] = j;
+        }
+    }
+}; // class StateIndirect
+
+template <typename CharT, typename Traits, typename BaseState>
+inline std::basic_ostream<CharT, Traits> &operator<< (
+        std::basic_ostream<CharT, Traits> &os,
+        const StateIndirect<BaseState> &state)
+{return state.print(os);}
+
+} // namespace vsmc
+
+#endif // VSMC_CORE_STATE_INDIRECT_HPP
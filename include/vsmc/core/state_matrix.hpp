@@ -36,6 +36,13 @@
 #include <vsmc/core/single_particle.hpp>
 #include <vsmc/utility/aligned_memory.hpp>
 #include <vsmc/utility/array.hpp>
+#include <vsmc/utility/cstring.hpp>
+
+/// \brief Number of particles in each tile of `StateMatrix<Blocked, Dim, T>`
+/// \ingroup Config
+#ifndef VSMC_STATE_MATRIX_BLOCK_WIDTH
+#define VSMC_STATE_MATRIX_BLOCK_WIDTH 8
+#endif
 
 #define VSMC_STATIC_ASSERT_CORE_STATE_MATRIX_DYNAMIC_DIM_RESIZE(Dim) \
     VSMC_STATIC_ASSERT((Dim == Dynamic),                                     \
@@ -115,9 +122,42 @@ class StateMatrixBase : public traits::DimTrait<Dim>
         VSMC_RUNTIME_ASSERT_CORE_STATE_MATRIX_DIM_SIZE(dim);
 
         traits::DimTrait<Dim>::resize_dim(dim);
-        data_.resize(size_ * dim);
+        data_.resize(data_size(size_, dim));
+        if (double_buffer_)
+            back_.resize(data_.size());
+    }
+
+    /// \brief If `copy` gathers particles into a back buffer
+    bool double_buffer () const {return double_buffer_;}
+
+    /// \brief Enable or disable double buffering
+    ///
+    /// \details
+    /// When enabled, a back buffer of the same size as the storage is
+    /// allocated. Then `copy` gathers all particles into the back buffer by
+    /// `copy_gather` and swaps the two buffers by `swap_buffer`. As the
+    /// gather does not depend on the order of `copy_from`, the SMP backends
+    /// (`StateSTD`, `StateTBB`, etc.) perform it in parallel over blocks of
+    /// particles. For arithmetic types, rows of `StateMatrix<RowMajor, Dim,
+    /// T>` are copied with non-temporal stores (see `memcpy_nt`) if they are
+    /// aligned. Pointers obtained from `data` etc. are invalidated by `copy`.
+    ///
+    /// All particles are written by the gather while an in place `copy`
+    /// only writes those replaced by others. Thus double buffering pays off
+    /// when most particles are replaced or when `copy` runs on many threads.
+    void double_buffer (bool flag)
+    {
+        double_buffer_ = flag;
+        if (flag)
+            back_.resize(data_.size());
+        else
+            data_type().swap(back_);
     }
 
+    /// \brief Swap the storage and the back buffer after all particles are
+    /// gathered by `copy_gather`
+    void swap_buffer () {data_.swap(back_);}
+
     size_type size () const {return size_;}
 
     state_type &operator() (std::size_t i, std::size_t pos)
@@ -182,6 +222,16 @@ class StateMatrixBase : public traits::DimTrait<Dim>
                         ++first;
                     }
                 }
+            } else {
+                const size_type W = VSMC_STATE_MATRIX_BLOCK_WIDTH;
+                for (size_type t = 0; t < size_; t += W) {
+                    for (std::size_t d = 0; d != this->dim(); ++d) {
+                        for (size_type i = t; i != t + W; ++i) {
+                            *first = i < size_ ? sptr->state(i, d) : T();
+                            ++first;
+                        }
+                    }
+                }
             }
         }
     }
@@ -206,7 +256,25 @@ class StateMatrixBase : public traits::DimTrait<Dim>
 
     protected :
 
-    explicit StateMatrixBase (size_type N) : size_(N), data_(N * Dim) {}
+    explicit StateMatrixBase (size_type N) :
+        size_(N), double_buffer_(false), data_(data_size(N, Dim)) {}
+
+    T *back_data () {return &back_[0];}
+
+    // Copy a row of n elements, with non-temporal stores if possible
+    static void copy_row (const T *src, T *dst, std::size_t n)
+    {
+        copy_row_dispatch(src, dst, n,
+                cxx11::integral_constant<bool,
+                cxx11::is_arithmetic<T>::value>());
+    }
+
+    static void copy_fence ()
+    {
+#if VSMC_HAS_SSE2
+        _mm_sfence();
+#endif
+    }
 
     state_pack_type create_pack () const
     {
@@ -216,10 +284,40 @@ class StateMatrixBase : public traits::DimTrait<Dim>
 
     private :
 
+    typedef typename cxx11::conditional<cxx11::is_arithmetic<T>::value,
+            std::vector<T, AlignedAllocator<T> >,
+            std::vector<T> >::type data_type;
+
     size_type size_;
-    typename cxx11::conditional<cxx11::is_arithmetic<T>::value,
-             std::vector<T, AlignedAllocator<T> >,
-             std::vector<T> >::type data_;
+    bool double_buffer_;
+    data_type data_;
+    data_type back_;
+
+    static size_type data_size (size_type N, std::size_t dim)
+    {
+        if (Order != Blocked)
+            return N * dim;
+
+        const size_type W = VSMC_STATE_MATRIX_BLOCK_WIDTH;
+
+        return (N + W - 1) / W * W * dim;
+    }
+
+    static void copy_row_dispatch (const T *src, T *dst, std::size_t n,
+            cxx11::true_type)
+    {
+        const std::size_t alignment = traits::SIMDTrait<AVX>::alignment;
+        if (reinterpret_cast<uintptr_t>(src) % alignment == 0 &&
+                reinterpret_cast<uintptr_t>(dst) % alignment == 0) {
+            ::vsmc::memcpy_nt(dst, src, sizeof(T) * n);
+        } else {
+            std::copy(src, src + n, dst);
+        }
+    }
+
+    static void copy_row_dispatch (const T *src, T *dst, std::size_t n,
+            cxx11::false_type)
+    {std::copy(src, src + n, dst);}
 
     std::vector<T> create_pack_dispatch (cxx11::true_type) const
     {return std::vector<T>(this->dim());}
@@ -287,6 +385,12 @@ class StateMatrix<RowMajor, Dim, T> : public StateMatrixBase<RowMajor, Dim, T>
     {
         VSMC_RUNTIME_ASSERT_CORE_STATE_MATRIX_COPY_SIZE_MISMATCH;
 
+        if (this->double_buffer()) {
+            copy_gather(0, N, copy_from);
+            this->swap_buffer();
+            return;
+        }
+
         for (size_type to = 0; to != N; ++to)
             copy_particle(copy_from[to], to);
     }
@@ -299,6 +403,21 @@ class StateMatrix<RowMajor, Dim, T> : public StateMatrixBase<RowMajor, Dim, T>
         std::copy(row_data(from), row_data(from + 1), row_data(to));
     }
 
+    /// \brief Copy particles `copy_from[to]` to the back buffer at `to`, for
+    /// `to` in `[first, last)`
+    template <typename IntType>
+    void copy_gather (size_type first, size_type last,
+            const IntType *copy_from)
+    {
+        const std::size_t dim = this->dim();
+        T *dst = this->back_data() + first * dim;
+        for (size_type to = first; to != last; ++to, dst += dim) {
+            this->copy_row(row_data(static_cast<size_type>(copy_from[to])),
+                    dst, dim);
+        }
+        this->copy_fence();
+    }
+
     state_pack_type state_pack (size_type id) const
     {
         state_pack_type pack(this->create_pack());
@@ -380,6 +499,12 @@ class StateMatrix<ColMajor, Dim, T> : public StateMatrixBase<ColMajor, Dim, T>
     {
         VSMC_RUNTIME_ASSERT_CORE_STATE_MATRIX_COPY_SIZE_MISMATCH;
 
+        if (this->double_buffer()) {
+            copy_gather(0, N, copy_from);
+            this->swap_buffer();
+            return;
+        }
+
         for (size_type to = 0; to != N; ++to)
             copy_particle(copy_from[to], to);
     }
@@ -393,6 +518,20 @@ class StateMatrix<ColMajor, Dim, T> : public StateMatrixBase<ColMajor, Dim, T>
             state(to, d) = state(from, d);
     }
 
+    /// \brief Copy particles `copy_from[to]` to the back buffer at `to`, for
+    /// `to` in `[first, last)`
+    template <typename IntType>
+    void copy_gather (size_type first, size_type last,
+            const IntType *copy_from)
+    {
+        for (std::size_t d = 0; d != this->dim(); ++d) {
+            const T *src = col_data(d);
+            T *dst = this->back_data() + d * this->size();
+            for (size_type to = first; to != last; ++to)
+                dst[to] = src[static_cast<size_type>(copy_from[to])];
+        }
+    }
+
     state_pack_type state_pack (size_type id) const
     {
         state_pack_type pack(this->create_pack());
@@ -423,6 +562,163 @@ class StateMatrix<ColMajor, Dim, T> : public StateMatrixBase<ColMajor, Dim, T>
 #endif
 }; // class StateMatrix
 
+/// \brief Particle::value_type subtype
+/// \ingroup Core
+///
+/// \details
+/// The particles are stored in tiles of `tile_width()` particles, which is
+/// configured by `VSMC_STATE_MATRIX_BLOCK_WIDTH`. Within each tile, the states
+/// are stored column by column. That is, the same state of consecutive
+/// particles within a tile are contiguous, and can be processed with vector
+/// loads and stores, while all states of a particle are within a single tile
+/// of `tile_width() * dim()` elements, such that copying a particle only
+/// touches a few cache lines. If the number of particles is not a multiple
+/// of the tile width, the last tile is padded. The padding is also present in
+/// the output of `read_state_matrix<Blocked>`.
+template <std::size_t Dim, typename T>
+class StateMatrix<Blocked, Dim, T> : public StateMatrixBase<Blocked, Dim, T>
+{
+    public :
+
+    typedef StateMatrixBase<Blocked, Dim, T> state_matrix_base_type;
+    typedef typename state_matrix_base_type::size_type size_type;
+    typedef typename state_matrix_base_type::state_pack_type state_pack_type;
+
+    explicit StateMatrix (size_type N) : state_matrix_base_type(N) {}
+
+    /// \brief The number of particles in each tile
+    static VSMC_CONSTEXPR size_type tile_width ()
+    {return VSMC_STATE_MATRIX_BLOCK_WIDTH;}
+
+    /// \brief The number of tiles
+    size_type tile_num () const
+    {return (this->size() + tile_width() - 1) / tile_width();}
+
+    T &state (size_type id, std::size_t pos)
+    {
+        return tile_data(id / tile_width())[
+            pos * tile_width() + id % tile_width()];
+    }
+
+    const T &state (size_type id, std::size_t pos) const
+    {
+        return tile_data(id / tile_width())[
+            pos * tile_width() + id % tile_width()];
+    }
+
+    template <std::size_t Pos>
+    T &state (size_type id, Position<Pos>)
+    {return state(id, Pos);}
+
+    template <std::size_t Pos>
+    const T &state (size_type id, Position<Pos>) const
+    {return state(id, Pos);}
+
+    template <std::size_t Pos>
+    T &state (size_type id)
+    {return state(id, Pos);}
+
+    template <std::size_t Pos>
+    const T &state (size_type id) const
+    {return state(id, Pos);}
+
+    using state_matrix_base_type::data;
+
+    T *data (size_type tile) {return tile_data(tile);}
+
+    const T *data (size_type tile) const {return tile_data(tile);}
+
+    /// \brief The data of a tile, a `dim()` by `tile_width()` row major
+    /// matrix
+    T *tile_data (size_type tile)
+    {return this->data() + tile * this->dim() * tile_width();}
+
+    /// \brief The data of a tile, a `dim()` by `tile_width()` row major
+    /// matrix
+    const T *tile_data (size_type tile) const
+    {return this->data() + tile * this->dim() * tile_width();}
+
+    template <typename IntType>
+    void copy (size_type N, const IntType *copy_from)
+    {
+        VSMC_RUNTIME_ASSERT_CORE_STATE_MATRIX_COPY_SIZE_MISMATCH;
+
+        if (this->double_buffer()) {
+            copy_gather(0, N, copy_from);
+            this->swap_buffer();
+            return;
+        }
+
+        for (size_type to = 0; to != N; ++to)
+            copy_particle(copy_from[to], to);
+    }
+
+    void copy_particle (size_type from, size_type to)
+    {
+        if (from == to)
+            return;
+
+        const T *src = &state(from, 0);
+        T *dst = &state(to, 0);
+        for (std::size_t d = 0; d != this->dim(); ++d) {
+            *dst = *src;
+            src += tile_width();
+            dst += tile_width();
+        }
+    }
+
+    /// \brief Copy particles `copy_from[to]` to the back buffer at `to`, for
+    /// `to` in `[first, last)`
+    template <typename IntType>
+    void copy_gather (size_type first, size_type last,
+            const IntType *copy_from)
+    {
+        T *back = this->back_data();
+        for (size_type to = first; to != last; ++to) {
+            const T *src = &state(static_cast<size_type>(copy_from[to]), 0);
+            T *dst = back + (to / tile_width()) * this->dim() * tile_width() +
+                to % tile_width();
+            for (std::size_t d = 0; d != this->dim(); ++d) {
+                *dst = *src;
+                src += tile_width();
+                dst += tile_width();
+            }
+        }
+    }
+
+    state_pack_type state_pack (size_type id) const
+    {
+        state_pack_type pack(this->create_pack());
+        const T *src = &state(id, 0);
+        for (std::size_t d = 0; d != this->dim(); ++d, src += tile_width())
+            pack[d] = *src;
+
+        return pack;
+    }
+
+    void state_unpack (size_type id, const state_pack_type &pack)
+    {
+        VSMC_RUNTIME_ASSERT_CORE_STATE_MATRIX_UNPACK_SIZE(
+                pack.size(), this->dim());
+
+        T *dst = &state(id, 0);
+        for (std::size_t d = 0; d != this->dim(); ++d, dst += tile_width())
+            *dst = pack[d];
+    }
+
+#if VSMC_HAS_CXX11_RVALUE_REFERENCES
+    void state_unpack (size_type id, state_pack_type &&pack)
+    {
+        VSMC_RUNTIME_ASSERT_CORE_STATE_MATRIX_UNPACK_SIZE(
+                pack.size(), this->dim());
+
+        T *dst = &state(id, 0);
+        for (std::size_t d = 0; d != this->dim(); ++d, dst += tile_width())
+            *dst = cxx11::move(pack[d]);
+    }
+#endif
+}; // class StateMatrix
+
 } // namespace vsmc
 
 #endif // VSMC_CORE_STATE_MATRIX_HPP
@@ -36,10 +36,29 @@
 #include <vsmc/rng/discrete_distribution.hpp>
 #include <vsmc/utility/aligned_memory.hpp>
 
+/// \brief Number of elements in each block of cache blocked weight operations
+/// \ingroup Config
+#ifndef VSMC_WEIGHT_SET_BLOCK_SIZE
+#define VSMC_WEIGHT_SET_BLOCK_SIZE 1024
+#endif
+
+/// \brief Number of candidate exponents evaluated in each sweep of
+/// `WeightSet::ess_bisect`
+/// \ingroup Config
+#ifndef VSMC_WEIGHT_SET_BISECT_NUM
+#define VSMC_WEIGHT_SET_BISECT_NUM 8
+#endif
+
 namespace vsmc {
 
 /// \brief Weight set class
 /// \ingroup Core
+///
+/// \details
+/// Member functions computing ESS and CESS of incremental weights, such as
+/// `ess(first, use_log)`, copy the input into a buffer owned by the object,
+/// which is allocated upon the first call and reused afterwards. Thus they
+/// shall not be called concurrently on the same object.
 class WeightSet
 {
     public :
@@ -124,6 +143,162 @@ class WeightSet
         return 1 / math::dot(N, wptr, wptr);
     }
 
+    /// \brief Normalize logarithm weights such that the maximum is zero,
+    /// compute the normalized weights and return the ESS
+    ///
+    /// \details
+    /// The result is the same as `normalize_log_weight`, followed by
+    /// `math::vExp` and `normalize_weight`, but with fewer passes over the
+    /// data. After the maximum is found, the logarithm weights are shifted
+    /// and exponentiated block by block (of `VSMC_WEIGHT_SET_BLOCK_SIZE`
+    /// elements), while each block is still in cache, the sum and sum of
+    /// squares of the weights are accumulated. A last pass scales the
+    /// weights. The ESS is computed from the two sums directly.
+    static double log_weight2weight_ess (std::size_t N, double *lwptr,
+            double *wptr)
+    {
+        if (N == 0)
+            return 0;
+
+        double dmax = lwptr[0];
+        for (std::size_t i = 0; i != N; ++i)
+            if (dmax < lwptr[i])
+                dmax = lwptr[i];
+
+        const std::size_t B = VSMC_WEIGHT_SET_BLOCK_SIZE;
+        double sum[4] = {0, 0, 0, 0};
+        double sum2[4] = {0, 0, 0, 0};
+        for (std::size_t b = 0; b < N; b += B) {
+            const std::size_t n = N - b < B ? N - b : B;
+            double *const lw = lwptr + b;
+            double *const w = wptr + b;
+            for (std::size_t i = 0; i != n; ++i)
+                lw[i] -= dmax;
+            math::vExp(n, lw, w);
+            const std::size_t m = n - n % 4;
+            for (std::size_t i = 0; i != m; i += 4) {
+                for (std::size_t k = 0; k != 4; ++k) {
+                    sum[k] += w[i + k];
+                    sum2[k] += w[i + k] * w[i + k];
+                }
+            }
+            for (std::size_t i = m; i != n; ++i) {
+                sum[0] += w[i];
+                sum2[0] += w[i] * w[i];
+            }
+        }
+        const double s = (sum[0] + sum[1]) + (sum[2] + sum[3]);
+        const double s2 = (sum2[0] + sum2[1]) + (sum2[2] + sum2[3]);
+        math::scal(N, 1 / s, wptr);
+
+        return s * s / s2;
+    }
+
+    /// \brief Compute the shifts used by `ess_batch_sum`
+    ///
+    /// \details
+    /// Set `shift[0]` to the maximum of `lwptr[i] + alpha * first[i]` (or of
+    /// `alpha * first[i]` if `use_cess`) and `shift[1]` to the maximum of
+    /// `step * first[i]`.
+    static void ess_batch_max (std::size_t N, const double *lwptr,
+            const double *first, double alpha, double step, double *shift,
+            bool use_cess)
+    {
+        double smax = alpha * first[0] + (use_cess ? 0 : lwptr[0]);
+        double dmax = step * first[0];
+        for (std::size_t i = 0; i != N; ++i) {
+            double v = alpha * first[i] + (use_cess ? 0 : lwptr[i]);
+            if (smax < v)
+                smax = v;
+            if (dmax < step * first[i])
+                dmax = step * first[i];
+        }
+        shift[0] = smax;
+        shift[1] = dmax;
+    }
+
+    /// \brief Compute the sums for the ESS (or CESS) of incremental
+    /// logarithm weights `(alpha + k * step) * first[i]` for each `k` in
+    /// `[0, n)`, where `n` is at most `VSMC_WEIGHT_SET_BISECT_NUM`
+    ///
+    /// \details
+    /// Let \f$v_{ki} = \exp(\log W_i + (\alpha + k h)\ell_i - s_0 - k
+    /// s_1)\f$ where \f$s_0\f$ and \f$s_1\f$ are the two shifts computed by
+    /// `ess_batch_max`, then `sum[k]` and `sum2[k]` are the summations of
+    /// \f$v_{ki}\f$ and \f$v_{ki}^2\f$ respectively, and the ESS is
+    /// `sum[k] * sum[k] / sum2[k]`. For the CESS, let \f$u_{ki} = \exp((\alpha
+    /// + k h)\ell_i - s_0 - k s_1)\f$, then `sum[k]` and `sum2[k]` are the
+    /// summations of \f$W_iu_{ki}\f$ and \f$W_iu_{ki}^2\f$. All the
+    /// candidates are computed with two exponentiations of each element, as
+    /// \f$v_{ki} = v_{0i}\exp(h\ell_i - s_1)^k\f$, and each block of
+    /// `VSMC_WEIGHT_SET_BLOCK_SIZE` elements is reused by all candidates
+    /// while it is still in cache. The shifts ensure that there is no
+    /// overflow. However, there could be underflow for large `k` and the
+    /// caller shall check that `sum[k]` is not too small.
+    static void ess_batch_sum (std::size_t N, const double *wptr,
+            const double *lwptr, const double *first, std::size_t n,
+            double alpha, double step, const double *shift,
+            double *sum, double *sum2, bool use_cess)
+    {
+        const std::size_t K = VSMC_WEIGHT_SET_BISECT_NUM;
+        const std::size_t B = VSMC_WEIGHT_SET_BLOCK_SIZE;
+        double s[K];
+        double s2[K];
+        double v0[B];
+        double r[B];
+        for (std::size_t k = 0; k != K; ++k) {
+            s[k] = 0;
+            s2[k] = 0;
+        }
+        for (std::size_t b = 0; b < N; b += B) {
+            const std::size_t m = N - b < B ? N - b : B;
+            const double *const w = wptr + b;
+            const double *const f = first + b;
+            if (use_cess) {
+                for (std::size_t i = 0; i != m; ++i)
+                    v0[i] = alpha * f[i] - shift[0];
+            } else {
+                const double *const lw = lwptr + b;
+                for (std::size_t i = 0; i != m; ++i)
+                    v0[i] = lw[i] + alpha * f[i] - shift[0];
+            }
+            math::vExp(m, v0, v0);
+            if (n > 1) {
+                for (std::size_t i = 0; i != m; ++i)
+                    r[i] = step * f[i] - shift[1];
+                math::vExp(m, r, r);
+            }
+            for (std::size_t i = 0; i != m; ++i) {
+                double v = v0[i];
+                if (use_cess) {
+                    s[0] += w[i] * v;
+                    s2[0] += w[i] * v * v;
+                    for (std::size_t k = 1; k < n; ++k) {
+                        v *= r[i];
+                        s[k] += w[i] * v;
+                        s2[k] += w[i] * v * v;
+                    }
+                } else {
+                    s[0] += v;
+                    s2[0] += v * v;
+                    for (std::size_t k = 1; k < n; ++k) {
+                        v *= r[i];
+                        s[k] += v;
+                        s2[k] += v * v;
+                    }
+                }
+            }
+        }
+        for (std::size_t k = 0; k != n; ++k) {
+            sum[k] = s[k];
+            sum2[k] = s2[k];
+        }
+    }
+
+    /// \brief Smallest sum computed by `ess_batch_sum` that is considered
+    /// accurate
+    static double ess_batch_min () {return 1e-100;}
+
     size_type size () const {return size_;}
 
     /// \brief ESS of the current weights
@@ -132,57 +307,78 @@ class WeightSet
     /// \brief Compute ESS given (log) incremental weights
     template <typename InputIter>
     double ess (InputIter first, bool use_log) const
-    {
-        std::vector<double, AlignedAllocator<double> > buffer(size_);
-        double *const bptr = &buffer[0];
-#if VSMC_HAS_CXX11LIB_ALGORITHM
-        std::copy_n(first, size_, bptr);
-#else
-        for (size_type i = 0; i != size_; ++i, ++first)
-            bptr[i] = *first;
-#endif
-
-        return compute_ess(bptr, use_log);
-    }
+    {return compute_ess(copy_buffer(first), use_log);}
 
     /// \brief Compute ESS given (log) incremental weights
     template <typename RandomIter>
     double ess (RandomIter first, int stride, bool use_log) const
-    {
-        std::vector<double, AlignedAllocator<double> > buffer(size_);
-        double *const bptr = &buffer[0];
-        for (size_type i = 0; i != size_; ++i, first += stride)
-            bptr[i] = *first;
-
-        return compute_ess(bptr, use_log);
-    }
+    {return compute_ess(copy_buffer(first, stride), use_log);}
 
     /// \brief Compute CESS given (log) incremental weights
     template <typename InputIter>
     double cess (InputIter first, bool use_log) const
-    {
-        std::vector<double, AlignedAllocator<double> > buffer(size_);
-        double *const bptr = &buffer[0];
-#if VSMC_HAS_CXX11LIB_ALGORITHM
-        std::copy_n(first, size_, bptr);
-#else
-        for (size_type i = 0; i != size_; ++i, ++first)
-            bptr[i] = *first;
-#endif
-
-        return compute_cess(bptr, use_log);
-    }
+    {return compute_cess(copy_buffer(first), use_log);}
 
     /// \brief Compute CESS given (log) incremental weights
     template <typename RandomIter>
     double cess (RandomIter first, int stride, bool use_log) const
+    {return compute_cess(copy_buffer(first, stride), use_log);}
+
+    /// \brief Find the exponent such that the ESS (or CESS) of incremental
+    /// logarithm weights proportional to the input is equal to a target
+    ///
+    /// \param first Input values, such as log-likelihoods, \f$\ell_i\f$
+    /// \param lower Lower bound of the exponent
+    /// \param upper Upper bound of the exponent
+    /// \param target The target ESS (or CESS, which is within [0, 1])
+    /// \param use_cess Use CESS instead of ESS
+    /// \param tol Tolerance of the exponent
+    ///
+    /// \return The largest exponent \f$\alpha\in[\mathrm{lower},
+    /// \mathrm{upper}]\f$, up to the tolerance, such that the ESS (or CESS)
+    /// of incremental logarithm weights \f$\alpha\ell_i\f$ is not smaller
+    /// than the target. It is assumed that the ESS (or CESS) is a decreasing
+    /// function of the exponent within the bounds. If it is not smaller than
+    /// the target at the upper bound, the upper bound is returned.
+    ///
+    /// \details
+    /// Each sweep through the input evaluates `VSMC_WEIGHT_SET_BISECT_NUM`
+    /// equally spaced candidates within the current bracket (see
+    /// `compute_ess_batch`), and thus shrinks it by a factor of
+    /// `VSMC_WEIGHT_SET_BISECT_NUM + 1` instead of two of a plain bisection.
+    template <typename InputIter>
+    double ess_bisect (InputIter first, double lower, double upper,
+            double target, bool use_cess, double tol) const
     {
-        std::vector<double, AlignedAllocator<double> > buffer(size_);
-        double *const bptr = &buffer[0];
-        for (size_type i = 0; i != size_; ++i, first += stride)
-            bptr[i] = *first;
+        const std::size_t K = VSMC_WEIGHT_SET_BISECT_NUM;
+        const double *const bptr = copy_buffer(first);
+        double res[K];
+        double l = lower;
+        double u = upper;
+        double d = static_cast<double>(K);
+        double width = u - l;
+        bool first_sweep = true;
+        while (width > tol) {
+            const double h = width / d;
+            compute_ess_batch(bptr, K, l + h, h, res, use_cess);
+            std::size_t k = 0;
+            while (k != K && !(res[k] < target))
+                ++k;
+            // Only the first sweep evaluates the upper bound itself. Later
+            // sweeps may keep u == upper, but then upper is known to fail
+            if (k == K && first_sweep)
+                return upper;
+            first_sweep = false;
+            l += h * static_cast<double>(k);
+            if (k != K)
+                u = l + h;
+            d = static_cast<double>(K + 1);
+            if (!(u - l < width))
+                break;
+            width = u - l;
+        }
 
-        return compute_cess(bptr, use_log);
+        return l;
     }
 
     /// \brief Size of the weight set for the purpose of resampling
@@ -365,11 +561,13 @@ class WeightSet
 
     double *mutable_log_weight_data () {return &log_weight_[0];}
 
-    /// \brief Compute unormalized logarithm weights from normalized weights
+    /// \brief Compute unormalized weights from normalized logarithm weights
+    /// after the logarithm weights are changed
     virtual void log_weight2weight ()
     {math::vExp(size_, &log_weight_[0], &weight_[0]);}
 
-    /// \brief Compute unormalized weights from normalized logarithm weights
+    /// \brief Compute unormalized logarithm weights from normalized weights
+    /// after the weights are changed
     virtual void weight2log_weight ()
     {math::vLn(size_, &weight_[0], &log_weight_[0]);}
 
@@ -381,53 +579,237 @@ class WeightSet
     virtual void normalize_weight ()
     {ess_ = normalize_weight(size_, &weight_[0]);}
 
+    /// \brief Normalize logarithm weights, compute normalized weights and
+    /// ESS after the logarithm weights are changed
+    ///
+    /// \details
+    /// The default implementation calls `normalize_log_weight`,
+    /// `log_weight2weight` and `normalize_weight` in turn. If the dynamic
+    /// type of the object is `WeightSet` itself, none of them can be
+    /// overridden and the fused `log_weight2weight_ess` is used instead.
+    virtual void post_set_log_weight ()
+    {
+        if (typeid(*this) == typeid(WeightSet)) {
+            ess_ = log_weight2weight_ess(size_, &log_weight_[0], &weight_[0]);
+        } else {
+            normalize_log_weight();
+            log_weight2weight();
+            normalize_weight();
+        }
+    }
+
     /// \brief Compute ESS given (logarithm) unormalzied incremental weights
     virtual double compute_ess (const double *first, bool use_log) const
     {
-        std::vector<double, AlignedAllocator<double> > buffer(size_);
-        double *const bptr = &buffer[0];
-
+        const double *const wptr = &weight_[0];
+        double s = 0;
+        double s2 = 0;
         if (use_log) {
-            math::vAdd(size_, &log_weight_[0], first, bptr);
-            double dmax = bptr[0];
-            for (size_type i = 0; i != size_; ++i)
-                if (dmax < bptr[i])
-                    dmax = bptr[i];
-            dmax = -dmax;
+            const double *const lwptr = &log_weight_[0];
+            double dmax = lwptr[0] + first[0];
             for (size_type i = 0; i != size_; ++i)
-                bptr[i] += dmax;
-            math::vExp(size_, bptr, bptr);
+                if (dmax < lwptr[i] + first[i])
+                    dmax = lwptr[i] + first[i];
+
+            const std::size_t B = VSMC_WEIGHT_SET_BLOCK_SIZE;
+            double buffer[B];
+            for (std::size_t b = 0; b < size_; b += B) {
+                const std::size_t n = size_ - b < B ? size_ - b : B;
+                for (std::size_t i = 0; i != n; ++i)
+                    buffer[i] = lwptr[b + i] + first[b + i] - dmax;
+                math::vExp(n, buffer, buffer);
+                for (std::size_t i = 0; i != n; ++i) {
+                    s += buffer[i];
+                    s2 += buffer[i] * buffer[i];
+                }
+            }
         } else {
-            math::vMul(size_, &weight_[0], first, bptr);
+            for (size_type i = 0; i != size_; ++i) {
+                double v = wptr[i] * first[i];
+                s += v;
+                s2 += v * v;
+            }
         }
 
-        double coeff = 1 / math::asum(size_, bptr);
-        math::scal(size_, coeff, bptr);
-
-        return 1 / math::dot(size_, bptr, bptr);
+        return s * s / s2;
     }
 
     /// \brief Compute CESS given (logarithm) unormalized incremental weights
     virtual double compute_cess (const double *first, bool use_log) const
     {
-        const double *bptr = first;
         const double *const wptr = &weight_[0];
-        std::vector<double, AlignedAllocator<double> > buffer;
+        double above = 0;
+        double below = 0;
         if (use_log) {
-            buffer.resize(size_);
-            math::vExp(size_, first, &buffer[0]);
-            bptr = &buffer[0];
+            const std::size_t B = VSMC_WEIGHT_SET_BLOCK_SIZE;
+            double buffer[B];
+            for (std::size_t b = 0; b < size_; b += B) {
+                const std::size_t n = size_ - b < B ? size_ - b : B;
+                math::vExp(n, first + b, buffer);
+                for (std::size_t i = 0; i != n; ++i) {
+                    double wb = wptr[b + i] * buffer[i];
+                    above += wb;
+                    below += wb * buffer[i];
+                }
+            }
+        } else {
+            for (size_type i = 0; i != size_; ++i) {
+                double wb = wptr[i] * first[i];
+                above += wb;
+                below += wb * first[i];
+            }
         }
 
-        double above = 0;
-        double below = 0;
+        return above * above / below;
+    }
+
+    /// \brief Compute ESS (or CESS) given incremental logarithm weights
+    /// `(alpha + k * step) * first[i]` for each `k` in `[0, n)`, and write the
+    /// results to `res[k]`
+    ///
+    /// \details
+    /// The default implementation processes the candidates in groups of
+    /// `VSMC_WEIGHT_SET_BISECT_NUM` with `ess_batch_max` and
+    /// `ess_batch_sum`. If the sums of a candidate are too small to be
+    /// accurate, it is evaluated again with its own shift.
+    virtual void compute_ess_batch (const double *first, std::size_t n,
+            double alpha, double step, double *res, bool use_cess) const
+    {
+        const std::size_t K = VSMC_WEIGHT_SET_BISECT_NUM;
+        double shift[2];
+        double sum[K];
+        double sum2[K];
+        for (std::size_t k0 = 0; k0 < n; k0 += K) {
+            const std::size_t m = n - k0 < K ? n - k0 : K;
+            const double a = alpha + step * static_cast<double>(k0);
+            weight_batch_max(first, a, step, shift, use_cess);
+            weight_batch_sum(first, m, a, step, shift, sum, sum2, use_cess);
+            for (std::size_t k = 0; k != m; ++k) {
+                if (!(sum[k] > ess_batch_min())) {
+                    const double ak = a + step * static_cast<double>(k);
+                    weight_batch_max(first, ak, 0, shift, use_cess);
+                    weight_batch_sum(first, 1, ak, 0, shift,
+                            sum + k, sum2 + k, use_cess);
+                }
+                res[k0 + k] = sum[k] * sum[k] / sum2[k];
+            }
+        }
+    }
+
+    /// \brief The maximum of `x[i]`, or `x[i] + y[i]` if `y` is not a null
+    /// pointer, over all particles
+    ///
+    /// \details
+    /// This and the following kernels, which work on arrays of the size of
+    /// the weight set, are the building blocks of weight operations. Weight
+    /// sets that need partial results, such as WeightSetMPI, use them, and
+    /// the SMP weight sets, such as WeightSetTBB, hide them with parallel
+    /// versions. If there are no particles, the maximum is the lowest finite
+    /// value of `double`.
+    double weight_max (const double *x, const double *y) const
+    {
+        double dmax = -std::numeric_limits<double>::max VSMC_MNE ();
+        if (y == VSMC_NULLPTR) {
+            for (size_type i = 0; i != size_; ++i)
+                if (dmax < x[i])
+                    dmax = x[i];
+        } else {
+            for (size_type i = 0; i != size_; ++i)
+                if (dmax < x[i] + y[i])
+                    dmax = x[i] + y[i];
+        }
+
+        return dmax;
+    }
+
+    /// \brief Set `lw[i] -= shift` and `w[i] = exp(lw[i])`, and store the
+    /// sum of `w[i]` and `w[i] * w[i]` in `sum[0]` and `sum[1]`
+    void weight_exp (double shift, double *lw, double *w, double *sum) const
+    {
+        for (size_type i = 0; i != size_; ++i)
+            lw[i] -= shift;
+        math::vExp(size_, lw, w);
+        sum[0] = 0;
+        sum[1] = 0;
         for (size_type i = 0; i != size_; ++i) {
-            double wb = wptr[i] * bptr[i];
-            above += wb;
-            below += wb * bptr[i];
+            sum[0] += w[i];
+            sum[1] += w[i] * w[i];
         }
+    }
 
-        return above * above / below;
+    /// \brief Set `x[i] += shift`
+    void weight_shift (double shift, double *x) const
+    {
+        for (size_type i = 0; i != size_; ++i)
+            x[i] += shift;
+    }
+
+    /// \brief Set `x[i] *= coeff`
+    void weight_scale (double coeff, double *x) const
+    {math::scal(size_, coeff, x);}
+
+    /// \brief Store the sum of `v[i]` in `sum[0]` and that of `v[i] * v[i]`,
+    /// or `v[i] * y[i]` if `cess`, in `sum[1]`
+    ///
+    /// \details
+    /// If `y` is a null pointer, then `v[i] = w[i]`. Otherwise, if `use_log`
+    /// and not `cess`, then `v[i] = exp(w[i] + y[i] - shift)` (`w` shall be
+    /// logarithm weights in this case). Otherwise, `v[i] = w[i] * y[i]`,
+    /// where `y[i]` is replaced by `exp(y[i])` if `use_log`.
+    void weight_sum (const double *w, const double *y, bool use_log,
+            bool cess, double shift, double *sum) const
+    {
+        using std::exp;
+
+        sum[0] = 0;
+        sum[1] = 0;
+        if (y == VSMC_NULLPTR) {
+            for (size_type i = 0; i != size_; ++i) {
+                sum[0] += w[i];
+                sum[1] += w[i] * w[i];
+            }
+            return;
+        }
+
+        for (size_type i = 0; i != size_; ++i) {
+            double v = 0;
+            double u = y[i];
+            if (use_log && cess) {
+                u = exp(y[i]);
+                v = w[i] * u;
+            } else if (use_log) {
+                v = exp(w[i] + y[i] - shift);
+            } else {
+                v = w[i] * u;
+            }
+            sum[0] += v;
+            sum[1] += cess ? v * u : v * v;
+        }
+    }
+
+    /// \brief The shifts computed by `ess_batch_max` over all particles
+    ///
+    /// \details
+    /// If there are no particles, both shifts are the lowest finite value of
+    /// `double`.
+    void weight_batch_max (const double *first, double alpha, double step,
+            double *shift, bool use_cess) const
+    {
+        shift[0] = -std::numeric_limits<double>::max VSMC_MNE ();
+        shift[1] = -std::numeric_limits<double>::max VSMC_MNE ();
+        if (size_ != 0) {
+            ess_batch_max(size_, &log_weight_[0], first, alpha, step, shift,
+                    use_cess);
+        }
+    }
+
+    /// \brief The sums computed by `ess_batch_sum` over all particles
+    void weight_batch_sum (const double *first, std::size_t n, double alpha,
+            double step, const double *shift, double *sum, double *sum2,
+            bool use_cess) const
+    {
+        ess_batch_sum(size_, &weight_[0], &log_weight_[0], first, n, alpha,
+                step, shift, sum, sum2, use_cess);
     }
 
     private :
@@ -436,13 +818,33 @@ class WeightSet
     double ess_;
     std::vector<double, AlignedAllocator<double> > weight_;
     std::vector<double, AlignedAllocator<double> > log_weight_;
+    mutable std::vector<double, AlignedAllocator<double> > buffer_;
     DiscreteDistribution<size_type> draw_;
 
-    void post_set_log_weight ()
+    template <typename InputIter>
+    const double *copy_buffer (InputIter first) const
     {
-        normalize_log_weight();
-        log_weight2weight();
-        normalize_weight();
+        buffer_.resize(size_);
+        double *const bptr = &buffer_[0];
+#if VSMC_HAS_CXX11LIB_ALGORITHM
+        std::copy_n(first, size_, bptr);
+#else
+        for (size_type i = 0; i != size_; ++i, ++first)
+            bptr[i] = *first;
+#endif
+
+        return bptr;
+    }
+
+    template <typename RandomIter>
+    const double *copy_buffer (RandomIter first, int stride) const
+    {
+        buffer_.resize(size_);
+        double *const bptr = &buffer_[0];
+        for (size_type i = 0; i != size_; ++i, first += stride)
+            bptr[i] = *first;
+
+        return bptr;
     }
 
     void post_set_weight ()
@@ -486,6 +888,10 @@ class WeightSetNull
     template <typename RandomIter>
     double cess (RandomIter, int, bool) const {return max_ess();}
 
+    template <typename InputIter>
+    double ess_bisect (InputIter, double, double upper, double, bool,
+            double) const {return upper;}
+
     size_type resample_size () const {return 0;}
 
     void read_resample_weight (double *) const {}
@@ -101,7 +101,9 @@ enum {
 /// \ingroup Definitions
 enum MatrixOrder {
     RowMajor = 101, ///< Data are stored row by row in memory
-    ColMajor = 102  ///< Data are stored column by column in memory
+    ColMajor = 102, ///< Data are stored column by column in memory
+    Blocked  = 103  ///< Data are stored in tiles of rows, column by column
+                    ///< within each tile
 }; // enum MatrixOrder
 
 /// \brief Monitor stage
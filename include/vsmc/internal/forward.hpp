@@ -70,10 +70,12 @@ struct MPIDefault;
 template <typename = MPIDefault> class MPICommunicator;
 template <typename, typename = MPIDefault> class WeightSetMPI;
 template <typename, typename = MPIDefault> class StateMPI;
+template <typename, typename = MPIDefault> class WeightSetIsland;
 
 // OpenCL
 struct CLDefault;
 template <std::size_t, typename, typename = CLDefault> class StateCL;
+template <typename, typename = CLDefault> class WeightSetCL;
 
 } // namesapce vsmc
 
@@ -33,17 +33,71 @@
 #define VSMC_MPI_BACKEND_MPI_HPP
 
 #include <vsmc/internal/common.hpp>
+#include <vsmc/core/particle.hpp>
 #include <vsmc/core/weight_set.hpp>
 #include <vsmc/mpi/mpi_datatype.hpp>
 #include <vsmc/mpi/mpi_manager.hpp>
+#include <vsmc/resample/common.hpp>
 #include <vsmc/utility/aligned_memory.hpp>
 
+#if VSMC_HAS_CXX11LIB_THREAD
+#include <thread>
+#endif
+
 #define VSMC_RUNTIME_ASSERT_MPI_BACKEND_MPI_COPY_SIZE_MISMATCH \
     VSMC_RUNTIME_ASSERT((N == global_size_),                                 \
             ("**StateMPI::copy** SIZE MISMATCH"))
 
+#define VSMC_RUNTIME_ASSERT_MPI_BACKEND_MPI_MOVE_ISLAND_SIZE(nmin, nmax) \
+    VSMC_RUNTIME_ASSERT((nmin == nmax),                                      \
+            ("**MoveIsland::operator()** "                                   \
+             "NODES HAVE DIFFERENT NUMBERS OF PARTICLES"))
+
 namespace vsmc {
 
+namespace internal {
+
+// Combine (max, sum, sum of squares) of two sets of weights, where the sums
+// are relative to the respective maximums, i.e., sum of exp(w - max)
+class WeightSetMPISum
+{
+    public :
+
+    Array<double, 3> operator() (
+            const Array<double, 3> &a, const Array<double, 3> &b) const
+    {
+        using std::exp;
+
+        Array<double, 3> c;
+        c[0] = a[0] < b[0] ? b[0] : a[0];
+        const double sa = exp(a[0] - c[0]);
+        const double sb = exp(b[0] - c[0]);
+        c[1] = a[1] * sa + b[1] * sb;
+        c[2] = a[2] * sa * sa + b[2] * sb * sb;
+
+        return c;
+    }
+}; // class WeightSetMPISum
+
+// Combine (min, max) of two sets of sizes
+template <typename SizeType>
+class MoveIslandSize
+{
+    public :
+
+    Array<SizeType, 2> operator() (
+            const Array<SizeType, 2> &a, const Array<SizeType, 2> &b) const
+    {
+        Array<SizeType, 2> c;
+        c[0] = a[0] < b[0] ? a[0] : b[0];
+        c[1] = a[1] < b[1] ? b[1] : a[1];
+
+        return c;
+    }
+}; // class MoveIslandSize
+
+} // namespace vsmc::internal
+
 /// \brief Particle::weight_set_type subtype using MPI
 /// \ingroup MPI
 template <typename WeightSetBase, typename ID>
@@ -80,9 +134,11 @@ class WeightSetMPI : public WeightSetBase
     const double *resample_weight_data () const
     {
         resample_weight_.resize(resample_size_);
-        read_resample_weight(&resample_weight_[0]);
+        double *const rwptr =
+            resample_size_ == 0 ? VSMC_NULLPTR : &resample_weight_[0];
+        read_resample_weight(rwptr);
 
-        return world_.rank() == 0 ? &resample_weight_[0] : VSMC_NULLPTR;
+        return world_.rank() == 0 ? rwptr : VSMC_NULLPTR;
     }
 
     /// \brief A duplicated MPI communicator for this weight set object
@@ -90,121 +146,130 @@ class WeightSetMPI : public WeightSetBase
 
     protected :
 
+    // The maximum, the sum and the sum of squares of weights are reduced
+    // with one collective, with local sums relative to the local maximum.
+    // Local passes use the kernels of WeightSetBase, which are parallel if
+    // it is an SMP weight set such as WeightSetTBB. A derived class of
+    // WeightSetMPI gets the calls to its (possibly overridden)
+    // normalize_log_weight, log_weight2weight and normalize_weight instead
+    void post_set_log_weight ()
+    {
+        using std::exp;
+
+        if (typeid(*this) != typeid(WeightSetMPI)) {
+            this->normalize_log_weight();
+            this->log_weight2weight();
+            this->normalize_weight();
+            return;
+        }
+
+        double *const wptr = this->mutable_weight_data();
+        double *const lwptr = this->mutable_log_weight_data();
+
+        Array<double, 3> lsum;
+        lsum[0] = this->weight_max(lwptr, VSMC_NULLPTR);
+        this->weight_exp(lsum[0], lwptr, wptr, &lsum[1]);
+
+        Array<double, 3> gsum;
+        ::boost::mpi::all_reduce(world_, lsum, gsum,
+                internal::WeightSetMPISum());
+        const double lshift = lsum[0] - gsum[0];
+        this->weight_shift(lshift, lwptr);
+        this->weight_scale(exp(lshift) / gsum[1], wptr);
+        this->set_ess(gsum[1] * gsum[1] / gsum[2]);
+    }
+
     void normalize_log_weight ()
     {
-        const size_type N = static_cast<size_type>(this->size());
         double *const lwptr = this->mutable_log_weight_data();
 
-        double lmax_weight = lwptr[0];
-        for (size_type i = 0; i != N; ++i)
-            if (lmax_weight < lwptr[i])
-                lmax_weight = lwptr[i];
+        double lmax_weight = this->weight_max(lwptr, VSMC_NULLPTR);
         double gmax_weight = 0;
         ::boost::mpi::all_reduce(world_, lmax_weight, gmax_weight,
                 ::boost::mpi::maximum<double>());
-        for (size_type i = 0; i != N; ++i)
-            lwptr[i] -= gmax_weight;
+        this->weight_shift(-gmax_weight, lwptr);
     }
 
     void normalize_weight ()
     {
-        const size_type N = static_cast<size_type>(this->size());
         double *const wptr = this->mutable_weight_data();
 
-        double lcoeff = 0;
-        for (size_type i = 0; i != N; ++i)
-            lcoeff += wptr[i];
-        double gcoeff = 0;
-        ::boost::mpi::all_reduce(world_, lcoeff, gcoeff, std::plus<double>());
-        gcoeff = 1 / gcoeff;
-        for (size_type i = 0; i != N; ++i)
-            wptr[i] *= gcoeff;
-
-        double less = 0;
-        for (size_type i = 0; i != N; ++i)
-            less += wptr[i] * wptr[i];
-        double gess = 0;
-        ::boost::mpi::all_reduce(world_, less, gess, std::plus<double>());
-        gess = 1 / gess;
-        this->set_ess(gess);
+        double lsum[2] = {0, 0};
+        this->weight_sum(wptr, VSMC_NULLPTR, false, false, 0, lsum);
+        double gsum[2] = {0, 0};
+        ::boost::mpi::all_reduce(world_, lsum, 2, gsum, std::plus<double>());
+        this->weight_scale(1 / gsum[0], wptr);
+        this->set_ess(gsum[0] * gsum[0] / gsum[1]);
     }
 
+    // The maximum, the sum and the sum of squares of incremental weights are
+    // reduced with one collective as in post_set_log_weight
     double compute_ess (const double *first, bool use_log) const
     {
-        using std::exp;
+        const double *const wptr = use_log ?
+            this->log_weight_data() : this->weight_data();
 
-        const size_type N = static_cast<size_type>(this->size());
-        std::vector<double, AlignedAllocator<double> > buffer(N);
-        double *const bptr = &buffer[0];
+        Array<double, 3> lsum;
+        lsum[0] = use_log ? this->weight_max(wptr, first) : 0;
+        this->weight_sum(wptr, first, use_log, false, lsum[0], &lsum[1]);
 
-        if (use_log) {
-            const double *const lwptr = this->log_weight_data();
-            for (size_type i = 0; i != N; ++i)
-                bptr[i] = lwptr[i] + first[i];
-            double lmax_weight = bptr[0];
-            for (size_type i = 0; i != N; ++i)
-                if (lmax_weight < bptr[i])
-                    lmax_weight = bptr[i];
-            double gmax_weight = 0;
-            ::boost::mpi::all_reduce(world_, lmax_weight, gmax_weight,
-                    ::boost::mpi::maximum<double>());
-            for (size_type i = 0; i != N; ++i)
-                bptr[i] -= gmax_weight;
-            for (size_type i = 0; i != N; ++i)
-                bptr[i] = exp(bptr[i]);
-        } else {
-            const double *const wptr = this->weight_data();
-            for (size_type i = 0; i != N; ++i)
-                bptr[i] = wptr[i] * first[i];
-        }
-
-        double lcoeff = 0;
-        for (size_type i = 0; i != N; ++i)
-            lcoeff += bptr[i];
-        double gcoeff = 0;
-        ::boost::mpi::all_reduce(world_, lcoeff, gcoeff, std::plus<double>());
-        gcoeff = 1 / gcoeff;
-        for (size_type i = 0; i != N; ++i)
-            bptr[i] *= gcoeff;
-
-        double less = 0;
-        for (size_type i = 0; i != N; ++i)
-            less += bptr[i] * bptr[i];
-        double gess = 0;
-        ::boost::mpi::all_reduce(world_, less, gess, std::plus<double>());
+        Array<double, 3> gsum;
+        ::boost::mpi::all_reduce(world_, lsum, gsum,
+                internal::WeightSetMPISum());
 
-        return 1 / gess;
+        return gsum[1] * gsum[1] / gsum[2];
     }
 
     double compute_cess (const double *first, bool use_log) const
     {
-        using std::exp;
+        double lsum[2] = {0, 0};
+        this->weight_sum(this->weight_data(), first, use_log, true, 0, lsum);
+        double gsum[2] = {0, 0};
+        ::boost::mpi::all_reduce(world_, lsum, 2, gsum, std::plus<double>());
 
-        const size_type N = static_cast<size_type>(this->size());
-        const double *bptr = first;
-        const double *const wptr = this->weight_data();
-        std::vector<double, AlignedAllocator<double> > buffer;
-        if (use_log) {
-            buffer.resize(N);
-            double *const cptr = &buffer[0];
-            for (size_type i = 0; i != N; ++i)
-                cptr[i] = exp(first[i]);
-            bptr = cptr;
-        }
+        return gsum[0] * gsum[0] / gsum[1];
+    }
 
-        double labove = 0;
-        double lbelow = 0;
-        for (size_type i = 0; i != N; ++i) {
-            double wb = wptr[i] * bptr[i];
-            labove += wb;
-            lbelow += wb * bptr[i];
+    // The sums of each candidate are relative to its local shift, and the
+    // shifts and sums of a group of candidates are reduced with one
+    // collective with the rescaling of WeightSetMPISum. A candidate whose
+    // local sums are too small is evaluated again with its own local shift,
+    // which needs no communication
+    void compute_ess_batch (const double *first, std::size_t n,
+            double alpha, double step, double *res, bool use_cess) const
+    {
+        const std::size_t K = VSMC_WEIGHT_SET_BISECT_NUM;
+        double shift[2];
+        double sum[K];
+        double sum2[K];
+        Array<double, 3> lsum[K];
+        Array<double, 3> gsum[K];
+        for (std::size_t k0 = 0; k0 < n; k0 += K) {
+            const std::size_t m = n - k0 < K ? n - k0 : K;
+            const double a = alpha + step * static_cast<double>(k0);
+            this->weight_batch_max(first, a, step, shift, use_cess);
+            this->weight_batch_sum(first, m, a, step, shift, sum, sum2,
+                    use_cess);
+            for (std::size_t k = 0; k != m; ++k) {
+                lsum[k][0] = shift[0] + shift[1] * static_cast<double>(k);
+                if (!(sum[k] > WeightSetBase::ess_batch_min())) {
+                    const double ak = a + step * static_cast<double>(k);
+                    double s[2];
+                    this->weight_batch_max(first, ak, 0, s, use_cess);
+                    this->weight_batch_sum(first, 1, ak, 0, s,
+                            sum + k, sum2 + k, use_cess);
+                    lsum[k][0] = s[0];
+                }
+                if (this->size() == 0)
+                    lsum[k][0] = -std::numeric_limits<double>::max VSMC_MNE ();
+                lsum[k][1] = sum[k];
+                lsum[k][2] = sum2[k];
+            }
+            ::boost::mpi::all_reduce(world_, lsum, static_cast<int>(m), gsum,
+                    internal::WeightSetMPISum());
+            for (std::size_t k = 0; k != m; ++k)
+                res[k0 + k] = gsum[k][1] * gsum[k][1] / gsum[k][2];
         }
-        double gabove = 0;
-        double gbelow = 0;
-        ::boost::mpi::all_reduce(world_, labove, gabove, std::plus<double>());
-        ::boost::mpi::all_reduce(world_, lbelow, gbelow, std::plus<double>());
-
-        return gabove * gabove / gbelow;
     }
 
     private :
@@ -218,7 +283,7 @@ class WeightSetMPI : public WeightSetBase
     void gather_resample_weight () const
     {
         weight_.resize(this->size());
-        this->read_weight(&weight_[0]);
+        this->read_weight(weight_.size() == 0 ? VSMC_NULLPTR : &weight_[0]);
         if (world_.rank() == 0)
             ::boost::mpi::gather(world_, weight_, weight_all_, 0);
         else
@@ -226,8 +291,347 @@ class WeightSetMPI : public WeightSetBase
     }
 }; // class WeightSetMPI
 
+/// \brief Particle::weight_set_type subtype for the island model using MPI
+/// \ingroup MPI
+///
+/// \details
+/// Each node is an island. Weights are normalized within each island, and
+/// ESS, resampling size and resampling weights are all those of the island.
+/// Thus Particle::resample resamples the particles of each node locally,
+/// without any communication, and the value collection type shall copy
+/// particles locally (for example, StateMatrix or an SMP backend, but not
+/// StateMPI).
+///
+/// The total weight of each island is maintained by `island_log_weight`.
+/// When logarithm weights are set or added, or weights are set or
+/// multiplied, it is multiplied by the ratio of the sum of the new
+/// unnormalized weights to that of the previous ones. Thus values passed to
+/// `set_log_weight` and `set_weight` are relative to the current island
+/// weight. `set_equal_weight`, such as when the island is resampled, does
+/// not change it. The weight of a particle in the whole system is the
+/// product of the normalized island weight (`island_weight`) and its weight
+/// within the island.
+///
+/// The islands interact only through `island_ess`, a collective operation,
+/// and MoveIsland, which resamples islands if their ESS is too small.
+template <typename WeightSetBase, typename ID>
+class WeightSetIsland : public WeightSetBase
+{
+    public :
+
+    typedef typename WeightSetBase::size_type size_type;
+    typedef ID mpi_id;
+
+    explicit WeightSetIsland (size_type N) :
+        WeightSetBase(N), world_(MPICommunicator<ID>::instance().get(),
+                ::boost::mpi::comm_duplicate),
+        island_log_weight_(0), island_log_weight_sum_(0),
+        log_sum_(log_size()) {}
+
+    /// \brief Set normalized weight, unnormalized logarithm weight and ESS
+    /// such that each particle has a equal weight within this island
+    void set_equal_weight ()
+    {
+        WeightSetBase::set_equal_weight();
+        log_sum_ = log_size();
+    }
+
+    /// \brief The logarithm of the total weight of this island
+    double island_log_weight () const {return island_log_weight_;}
+
+    /// \brief Set the logarithm of the total weight of this island
+    void island_log_weight (double lw) {island_log_weight_ = lw;}
+
+    /// \brief Normalized weights of all islands, updated by `island_ess`
+    const std::vector<double> &island_weight () const
+    {return island_weight_;}
+
+    /// \brief The logarithm of the total weight of all islands, updated by
+    /// `island_ess`
+    double island_log_weight_sum () const {return island_log_weight_sum_;}
+
+    /// \brief Gather island weights from all nodes and compute the ESS of
+    /// islands, which is between one and the number of nodes
+    ///
+    /// \details
+    /// It is a collective operation and shall be called by all nodes
+    double island_ess () const
+    {
+        using std::exp;
+        using std::log;
+
+        ::boost::mpi::all_gather(world_, island_log_weight_, island_weight_);
+        const std::size_t S = island_weight_.size();
+        double lmax = island_weight_[0];
+        for (std::size_t s = 0; s != S; ++s)
+            if (lmax < island_weight_[s])
+                lmax = island_weight_[s];
+        double sum = 0;
+        for (std::size_t s = 0; s != S; ++s) {
+            island_weight_[s] = exp(island_weight_[s] - lmax);
+            sum += island_weight_[s];
+        }
+        island_log_weight_sum_ = lmax + log(sum);
+        double sum2 = 0;
+        for (std::size_t s = 0; s != S; ++s) {
+            island_weight_[s] /= sum;
+            sum2 += island_weight_[s] * island_weight_[s];
+        }
+
+        return 1 / sum2;
+    }
+
+    /// \brief A duplicated MPI communicator for this weight set object
+    const ::boost::mpi::communicator &world () const {return world_;}
+
+    protected :
+
+    void post_set_log_weight ()
+    {
+        using std::log;
+
+        double *const wptr = this->mutable_weight_data();
+        double *const lwptr = this->mutable_log_weight_data();
+        if (this->size() == 0)
+            return;
+
+        const double lmax = this->weight_max(lwptr, VSMC_NULLPTR);
+        double sum[2];
+        this->weight_exp(lmax, lwptr, wptr, sum);
+        this->weight_scale(1 / sum[0], wptr);
+        this->set_ess(sum[0] * sum[0] / sum[1]);
+
+        const double log_sum = log(sum[0]);
+        island_log_weight_ += lmax + log_sum - log_sum_;
+        log_sum_ = log_sum;
+    }
+
+    void normalize_weight ()
+    {
+        using std::log;
+
+        double sum[2];
+        this->weight_sum(this->weight_data(), VSMC_NULLPTR, false, false, 0,
+                sum);
+        if (this->size() != 0)
+            island_log_weight_ += log(sum[0]);
+        WeightSetBase::normalize_weight();
+    }
+
+    // Called after weight2log_weight, and thus the sum of exp(lw) after the
+    // normalization is that of the weights divided by their maximum
+    void normalize_log_weight ()
+    {
+        using std::log;
+
+        const double lmax = this->weight_max(this->log_weight_data(),
+                VSMC_NULLPTR);
+        WeightSetBase::normalize_log_weight();
+        double sum[2];
+        this->weight_sum(this->weight_data(), VSMC_NULLPTR, false, false, 0,
+                sum);
+        log_sum_ = log(sum[0]) - lmax;
+    }
+
+    private :
+
+    ::boost::mpi::communicator world_;
+    double island_log_weight_;
+    mutable double island_log_weight_sum_;
+    double log_sum_;
+    mutable std::vector<double> island_weight_;
+
+    double log_size () const
+    {
+        using std::log;
+
+        return log(static_cast<double>(this->size()));
+    }
+}; // class WeightSetIsland
+
+namespace internal {
+
+// If the states of BaseState can be sent as arrays of state_type, which is
+// the case for StateMatrix with a value type that has an MPI datatype
+template <typename BaseState>
+struct StateMPIRawImpl
+{
+    private :
+
+    struct char2 {char c1; char c2;};
+
+    template <MatrixOrder Order, std::size_t Dim, typename T>
+    static typename cxx11::conditional<
+        ::boost::mpi::is_mpi_datatype<T>::value, char, char2>::type
+        test (const StateMatrix<Order, Dim, T> *);
+    static char2 test (...);
+
+    public :
+
+    static VSMC_CONSTEXPR const bool value = sizeof(test(
+                static_cast<const BaseState *>(VSMC_NULLPTR))) == sizeof(char);
+}; // struct StateMPIRawImpl
+
+template <typename BaseState> struct StateMPIRaw :
+public cxx11::integral_constant<bool, StateMPIRawImpl<BaseState>::value> {};
+
+// Buffers of particles sent to or received from each node
+template <typename BaseState, bool = StateMPIRaw<BaseState>::value>
+class StateMPIBuffer;
+
+// Particles are packed by state_pack into one vector for each node, which is
+// serialized as a whole
+template <typename BaseState>
+class StateMPIBuffer<BaseState, false>
+{
+    public :
+
+    typedef typename traits::SizeTypeTrait<BaseState>::type size_type;
+    typedef typename BaseState::state_pack_type state_pack_type;
+
+    void resize (std::size_t S)
+    {
+        send_.resize(S);
+        recv_.resize(S);
+    }
+
+    ::boost::mpi::request send (const ::boost::mpi::communicator &world,
+            int tag, const BaseState &state, int rank, std::size_t n,
+            const size_type *id)
+    {
+        std::vector<state_pack_type> &buffer = send_[rank];
+        buffer.clear();
+        for (std::size_t i = 0; i != n; ++i)
+            buffer.push_back(state.state_pack(id[i]));
+
+        return world.isend(rank, tag, buffer);
+    }
+
+    ::boost::mpi::request recv (const ::boost::mpi::communicator &world,
+            int tag, const BaseState &, int rank, std::size_t)
+    {return world.irecv(rank, tag, recv_[rank]);}
+
+    void unpack (BaseState &state, int rank, std::size_t n,
+            const size_type *id)
+    {
+        std::vector<state_pack_type> &buffer = recv_[rank];
+        for (std::size_t i = 0; i != n; ++i) {
+#if VSMC_HAS_CXX11_RVALUE_REFERENCES
+            state.state_unpack(id[i], cxx11::move(buffer[i]));
+#else
+            state.state_unpack(id[i], buffer[i]);
+#endif
+        }
+    }
+
+    private :
+
+    std::vector<std::vector<state_pack_type> > send_;
+    std::vector<std::vector<state_pack_type> > recv_;
+}; // class StateMPIBuffer
+
+// The states of particles are copied into one array of state_type for each
+// node, which is sent as raw data without serialization
+template <typename BaseState>
+class StateMPIBuffer<BaseState, true>
+{
+    public :
+
+    typedef typename traits::SizeTypeTrait<BaseState>::type size_type;
+    typedef typename BaseState::state_type state_type;
+
+    void resize (std::size_t S)
+    {
+        send_.resize(S);
+        recv_.resize(S);
+    }
+
+    ::boost::mpi::request send (const ::boost::mpi::communicator &world,
+            int tag, const BaseState &state, int rank, std::size_t n,
+            const size_type *id)
+    {
+        const std::size_t dim = state.dim();
+        std::vector<state_type> &buffer = send_[rank];
+        buffer.resize(n * dim);
+        state_type *ptr = &buffer[0];
+        for (std::size_t i = 0; i != n; ++i)
+            for (std::size_t d = 0; d != dim; ++d)
+                *ptr++ = state.state(id[i], d);
+
+        return world.isend(rank, tag, &buffer[0], static_cast<int>(n * dim));
+    }
+
+    ::boost::mpi::request recv (const ::boost::mpi::communicator &world,
+            int tag, const BaseState &state, int rank, std::size_t n)
+    {
+        const std::size_t dim = state.dim();
+        std::vector<state_type> &buffer = recv_[rank];
+        buffer.resize(n * dim);
+
+        return world.irecv(rank, tag, &buffer[0], static_cast<int>(n * dim));
+    }
+
+    void unpack (BaseState &state, int rank, std::size_t n,
+            const size_type *id)
+    {
+        const std::size_t dim = state.dim();
+        const state_type *ptr = &recv_[rank][0];
+        for (std::size_t i = 0; i != n; ++i)
+            for (std::size_t d = 0; d != dim; ++d)
+                state.state(id[i], d) = *ptr++;
+    }
+
+    private :
+
+    std::vector<std::vector<state_type> > send_;
+    std::vector<std::vector<state_type> > recv_;
+}; // class StateMPIBuffer
+
+#if VSMC_HAS_CXX11LIB_THREAD
+// A thread that waits for the communications of StateMPI::copy. It is
+// joined on destruction, and copies of it are not running
+class StateMPIThread
+{
+    public :
+
+    StateMPIThread () {}
+    StateMPIThread (const StateMPIThread &) {}
+    StateMPIThread &operator= (const StateMPIThread &) {return *this;}
+    ~StateMPIThread () {join();}
+
+    template <typename T>
+    void start (void (T::*f) (), T *obj) {thread_ = std::thread(f, obj);}
+
+    void join ()
+    {
+        if (thread_.joinable())
+            thread_.join();
+    }
+
+    private :
+
+    std::thread thread_;
+}; // class StateMPIThread
+#endif
+
+} // namespace vsmc::internal
+
 /// \brief Particle::value_type subtype using MPI
 /// \ingroup MPI
+///
+/// \details
+/// `BaseState` can be an SMP state, such as `StateTBB<StateMatrix<...> >`
+/// or `StateOMP<...>`, such that each node, for example, one node for each
+/// socket, uses all its cores. The local copy of `copy` is then performed
+/// by `BaseState::copy` in parallel. The `weight_set_type` is WeightSetMPI
+/// of the `weight_set_type` of `BaseState` (WeightSet by default). If the
+/// value type of Particle defines it as an SMP weight set, such as
+/// ~~~{.cpp}
+/// typedef WeightSetTBB<> weight_set_type;
+/// ~~~
+/// then the local passes of weight normalization and ESS computations are
+/// also parallel, while each still needs at most one reduction between
+/// nodes. See also `copy_thread`.
 template <typename BaseState, typename ID>
 class StateMPI : public BaseState
 {
@@ -236,12 +640,15 @@ class StateMPI : public BaseState
     typedef typename traits::SizeTypeTrait<BaseState>::type size_type;
     typedef WeightSetMPI<typename traits::WeightSetTypeTrait<BaseState>::type,
             ID> weight_set_type;
+    typedef cxx11::true_type resample_local_type;
     typedef ID mpi_id;
 
     explicit StateMPI (size_type N) :
         BaseState(N), world_(MPICommunicator<ID>::instance().get(),
                 ::boost::mpi::comm_duplicate),
         offset_(0), global_size_(0), size_equal_(true),
+        resample_local_(false), min_migration_(false), copy_thread_(false),
+        copy_started_(false),
         copy_tag_(::boost::mpi::environment::max_tag())
     {
         ::boost::mpi::all_gather(world_, N, size_all_);
@@ -298,35 +705,155 @@ class StateMPI : public BaseState
     /// of each particle. Particles with replication zero need to copy other
     /// particles. The vector of the number of replications is transfered to
     /// `copy_from` by Particle::resample, and it is generated in such a way
-    /// that each particle will copy from somewhere close to itself. Therefore,
-    /// transferring between nodes is minimized.
+    /// that each particle will copy from somewhere close to itself. However,
+    /// it does not take into account on which node the particles are. By
+    /// default, the particle with global id `to` is exactly a copy of the
+    /// particle with global id `copy_from[to]`. If `min_migration()` is
+    /// `true`, then only the number of times each particle is copied matters,
+    /// but not where the copies are placed. Each node keeps as many copies of
+    /// its own particles as possible, and the remaining copies are sent from
+    /// nodes with more copies than particles to nodes with fewer, such that
+    /// the number of particles transferred between nodes is minimal (see the
+    /// overload of `copy_this_node` that accepts replication numbers).
     ///
     /// This default implementation perform three stages of copy.
-    /// - Stage one: Generate a local duplicate of `copy_from` on node `0` and
-    /// broadcast it to all nodes.
+    /// - Stage one: If `min_migration()` is `true`, count the number of
+    /// copies of each particle on node `0` and scatter them to the nodes that
+    /// own the particles. Otherwise, generate a local duplicate of
+    /// `copy_from` on node `0` and broadcast it to all nodes.
     /// - Stage two: Perform local copy, copy those particles where the
     /// destination and source are both on this node. This is performed in
-    /// parallel on each node.
+    /// parallel on each node, while the messages of stage three are in
+    /// flight.
     /// - Stage three: copy particles that need message passing between nodes.
+    /// Particles sent to the same node are aggregated into one message (see
+    /// `copy_inter_node`).
     ///
     /// A derived class can override this `copy` method. For the following
     /// possible reasons,
     /// - Stage one is not needed or too expansive
-    /// - Stage three is too expansive. The default implementation assumes
+    /// - Stage three is too expansive. For states other than StateMatrix of
+    /// MPI datatypes, the default implementation assumes
     /// `this->state_pack(id)` and `this->state_unpack(id, pack) is not too
-    /// expansive, and inter-node copy is rare anyway. If this is not the case,
-    /// then it can be a performance bottle neck.
+    /// expansive. If this is not the case, then it can be a performance
+    /// bottle neck.
     template <typename IntType>
     void copy (size_type N, const IntType *copy_from)
     {
         VSMC_RUNTIME_ASSERT_MPI_BACKEND_MPI_COPY_SIZE_MISMATCH;
 
         copy_pre_processor_dispatch(has_copy_pre_processor_<BaseState>());
-        copy_from_.resize(N);
-        if (world_.rank() == 0)
-            std::copy(copy_from, copy_from + N, copy_from_.begin());
-        ::boost::mpi::broadcast(world_, copy_from_, 0);
-        copy_this_node(N, &copy_from_[0], copy_recv_, copy_send_);
+        if (min_migration_) {
+            copy_replication(copy_from);
+            copy_this_node(this->size() == 0 ? VSMC_NULLPTR : &replication_[0],
+                    count_all_, copy_recv_, copy_send_);
+        } else {
+            copy_from_.resize(N);
+            if (world_.rank() == 0)
+                std::copy(copy_from, copy_from + N, copy_from_.begin());
+            ::boost::mpi::broadcast(world_, copy_from_, 0);
+            copy_this_node(N, N == 0 ? VSMC_NULLPTR : &copy_from_[0],
+                    copy_recv_, copy_send_);
+        }
+        copy_inter_node(copy_recv_, copy_send_);
+        copy_post_processor_dispatch(has_copy_post_processor_<BaseState>());
+    }
+
+    /// \brief If `copy` minimizes the number of particles transferred
+    /// between nodes instead of placing copies exactly as `copy_from`
+    bool min_migration () const {return min_migration_;}
+
+    /// \brief Set if `copy` minimizes the number of particles transferred
+    /// between nodes (default `false`)
+    ///
+    /// \details
+    /// It shall be set to the same value on all nodes. If it is `true`, the
+    /// particle with global id `i` is no longer a copy of `copy_from[i]`, and
+    /// thus it shall not be set if the ancestry of particles is needed.
+    void min_migration (bool min) {min_migration_ = min;}
+
+    /// \brief If Particle::resample uses `resample_copy`
+    bool resample_local () const {return resample_local_;}
+
+    /// \brief Set if Particle::resample uses `resample_copy` instead of
+    /// gathering all weights to the node with rank zero (default `false`)
+    ///
+    /// \details
+    /// It shall be set to the same value on all nodes.
+    void resample_local (bool local) {resample_local_ = local;}
+
+    /// \brief If the communications of `copy` are waited for by a separate
+    /// thread while the local copy is performed
+    bool copy_thread () const {return copy_thread_;}
+
+    /// \brief Set if the communications of `copy` are waited for by a
+    /// separate thread while the local copy is performed (default `false`)
+    ///
+    /// \details
+    /// Messages between nodes are only guaranteed to progress while MPI is
+    /// called. With an SMP `BaseState`, the calling thread is busy with the
+    /// parallel local copy, and thus a dedicated thread is started to wait
+    /// for the messages in the meantime. MPI is only called by one thread at
+    /// a time. It has effect only if the C++11 `<thread>` library is
+    /// available and MPI is initialized with at least
+    /// `boost::mpi::threading::serialized` (see MPIEnvironment).
+    void copy_thread (bool thr) {copy_thread_ = thr;}
+
+    /// \brief Resample and copy particles without gathering weights
+    ///
+    /// \param op The resampling algorithm, with the same signature as
+    /// Particle::resample_type
+    /// \param rng The RNG used by `op`
+    /// \param weight Weights of particles on this node, normalized with
+    /// respect to all nodes
+    ///
+    /// \details
+    /// Let `W_r` be the sum of weights on the node with rank `r`. All nodes
+    /// gather the sums `W_r`, and the numbers of offspring of each node are
+    /// obtained by systematic resampling of the nodes, where the boundaries
+    /// are the exclusive scan of `W_r`. Each node then resamples its own
+    /// offspring with `op`, using its own weights normalized by `W_r`. The
+    /// sums and one uniform random number are the only data communicated
+    /// before particles are copied. The result is unbiased if `op` is, but it
+    /// is not identical to applying `op` to all particles at once.
+    ///
+    /// Particles with non-zero replication numbers stay where they are.
+    /// Their extra offspring replace particles with zero replication numbers
+    /// on the same node, and nodes with more offspring than particles send
+    /// the rest to nodes with fewer offspring than particles. Only particles
+    /// that migrate are communicated.
+    template <typename OpType, typename RngType>
+    void resample_copy (const OpType &op, RngType &rng, const double *weight)
+    {
+        const size_type N = this->size();
+        const std::size_t R = static_cast<std::size_t>(world_.rank());
+        const std::size_t S = static_cast<std::size_t>(world_.size());
+
+        cxx11::uniform_real_distribution<double> runif(0, 1);
+        double sum[2] = {0, runif(rng)};
+        if (N != 0) {
+            sum[0] = internal::resample_sum(static_cast<std::size_t>(N),
+                    weight);
+        }
+        sum_all_.resize(S * 2);
+        ::boost::mpi::all_gather(world_, sum, 2, &sum_all_[0]);
+        resample_count_node();
+
+        replication_.resize(N);
+        std::fill(replication_.begin(), replication_.end(), 0);
+        size_type *const rptr = N == 0 ? VSMC_NULLPTR : &replication_[0];
+        if (N != 0 && count_all_[R] != 0) {
+            resample_weight_.resize(N);
+            const double coeff = 1 / sum[0];
+            for (size_type i = 0; i != N; ++i)
+                resample_weight_[i] = weight[i] * coeff;
+            op(static_cast<std::size_t>(N),
+                    static_cast<std::size_t>(count_all_[R]), rng,
+                    &resample_weight_[0], rptr);
+        }
+
+        copy_pre_processor_dispatch(has_copy_pre_processor_<BaseState>());
+        copy_this_node(rptr, count_all_, copy_recv_, copy_send_);
         copy_inter_node(copy_recv_, copy_send_);
         copy_post_processor_dispatch(has_copy_post_processor_<BaseState>());
     }
@@ -429,7 +956,6 @@ class StateMPI : public BaseState
             copy_from_this_[to] =
                 rank_this == rank(from) ? local_id(from) : to;
         }
-        BaseState::copy(this->size(), &copy_from_this_[0]);
 
         copy_recv.clear();
         copy_send.clear();
@@ -447,36 +973,129 @@ class StateMPI : public BaseState
                 copy_send.push_back(std::make_pair(rank_recv, id_send));
             }
         }
+        copy_start(copy_recv, copy_send);
+        if (this->size() != 0)
+            BaseState::copy(this->size(), &copy_from_this_[0]);
+    }
+
+    /// \brief Perform local copy given replication numbers
+    ///
+    /// \param replication The replication numbers of particles on this node
+    /// \param count_all The sums of replication numbers on each node, whose
+    /// total is the number of particles on all nodes
+    /// \param copy_recv All particles that shall be received at this node
+    /// \param copy_send All particles that shall be send from this node
+    ///
+    /// \details
+    /// Particles with non-zero replication numbers are not changed. Their
+    /// extra offspring replace particles with zero replication numbers on
+    /// this node. Nodes with more offspring than particles are paired with
+    /// nodes with fewer offspring than particles in the order of ranks. The
+    /// offspring that do not fit on this node are inserted into `copy_send`,
+    /// and the particles that are not replaced locally are inserted into
+    /// `copy_recv`, in the same way as the other overload.
+    ///
+    /// It is important that `count_all` is the same for all nodes. Otherwise
+    /// the behavior is undefined.
+    void copy_this_node (const size_type *replication,
+            const std::vector<size_type> &count_all,
+            std::vector<std::pair<int, size_type> > &copy_recv,
+            std::vector<std::pair<int, size_type> > &copy_send)
+    {
+        const size_type N = this->size();
+        const std::size_t rank_this = static_cast<std::size_t>(world_.rank());
+        const std::size_t S = static_cast<std::size_t>(world_.size());
+
+        copy_from_this_.resize(N);
+        for (size_type i = 0; i != N; ++i)
+            copy_from_this_[i] = i;
+        copy_extra_.clear();
+        size_type to = 0;
+        for (size_type i = 0; i != N; ++i) {
+            for (size_type j = 1; j < replication[i]; ++j) {
+                while (to != N && replication[to] != 0)
+                    ++to;
+                if (to != N)
+                    copy_from_this_[to++] = i;
+                else
+                    copy_extra_.push_back(i);
+            }
+        }
+
+        copy_recv.clear();
+        copy_send.clear();
+        std::size_t s = 0;
+        std::size_t t = 0;
+        size_type ds = 0;
+        size_type dt = 0;
+        std::size_t extra = 0;
+        while (true) {
+            for (; ds == 0 && s != S; ++s)
+                if (count_all[s] > size_all_[s])
+                    ds = count_all[s] - size_all_[s];
+            for (; dt == 0 && t != S; ++t)
+                if (count_all[t] < size_all_[t])
+                    dt = size_all_[t] - count_all[t];
+            if (ds == 0 || dt == 0)
+                break;
+
+            const size_type m = ds < dt ? ds : dt;
+            if (s - 1 == rank_this) {
+                for (size_type k = 0; k != m; ++k, ++extra) {
+                    copy_send.push_back(std::make_pair(
+                                static_cast<int>(t - 1), copy_extra_[extra]));
+                }
+            }
+            if (t - 1 == rank_this) {
+                for (size_type k = 0; k != m; ++k, ++to) {
+                    while (replication[to] != 0)
+                        ++to;
+                    copy_recv.push_back(std::make_pair(
+                                static_cast<int>(s - 1), to));
+                }
+            }
+            ds -= m;
+            dt -= m;
+        }
+        copy_start(copy_recv, copy_send);
+        if (N != 0)
+            BaseState::copy(N, &copy_from_this_[0]);
     }
 
     /// \brief Perform global copy
     ///
     /// \param copy_recv The output vector `copy_recv` from `copy_this_node`
     /// \param copy_send The output vector `copy_send` from `copy_this_node`
+    ///
+    /// \details
+    /// Particles sent to the same node are packed into one buffer, and
+    /// messages to and from all nodes are posted at once with non-blocking
+    /// communications. If `BaseState` is a StateMatrix whose value type has
+    /// an MPI datatype, then the states are sent as raw arrays. Otherwise,
+    /// `state_pack` and `state_unpack` are used and the vector of packs for
+    /// each node is serialized as a whole. `copy_this_node` starts the
+    /// communications before it performs the local copy, such that the two
+    /// overlap, and this function waits for them to complete and unpacks the
+    /// particles received.
     void copy_inter_node (
             const std::vector<std::pair<int, size_type> > &copy_recv,
             const std::vector<std::pair<int, size_type> > &copy_send)
     {
-        const int rank_this = world_.rank();
-        for (int r = 0; r != world_.size(); ++r) {
-            if (rank_this == r) {
-                for (std::size_t i = 0; i != copy_recv.size(); ++i) {
-                    world_.recv(copy_recv[i].first, copy_tag_, pack_recv_);
-#if VSMC_HAS_CXX11_RVALUE_REFERENCES
-                    this->state_unpack(copy_recv[i].second,
-                            cxx11::move(pack_recv_));
-#else
-                    this->state_unpack(copy_recv[i].second,
-                            pack_recv_);
+        if (!copy_started_)
+            copy_start(copy_recv, copy_send);
+#if VSMC_HAS_CXX11LIB_THREAD
+        copy_wait_thread_.join();
 #endif
-                }
-            } else {
-                for (std::size_t i = 0; i != copy_send.size(); ++i) {
-                    if (copy_send[i].first == r) {
-                        pack_send_ = this->state_pack(copy_send[i].second);
-                        world_.send(copy_send[i].first, copy_tag_, pack_send_);
-                    }
-                }
+        copy_wait();
+        copy_started_ = false;
+
+        const std::size_t S = static_cast<std::size_t>(world_.size());
+        for (std::size_t r = 0; r != S; ++r) {
+            const std::size_t n = copy_recv_offset_[r + 1] -
+                copy_recv_offset_[r];
+            if (n != 0) {
+                copy_buffer_.unpack(*this, static_cast<int>(r), n,
+                        &copy_recv_id_[copy_recv_offset_[r]]);
             }
         }
     }
@@ -487,18 +1106,169 @@ class StateMPI : public BaseState
     size_type offset_;
     size_type global_size_;
     bool size_equal_;
+    bool resample_local_;
+    bool min_migration_;
+    bool copy_thread_;
+    bool copy_started_;
     std::vector<size_type> size_all_;
+    std::vector<size_type> count_all_;
+    std::vector<double> sum_all_;
+    std::vector<double> resample_weight_;
+    std::vector<size_type> replication_;
+    std::vector<size_type> replication_all_;
+    std::vector<int> replication_size_;
+    std::vector<int> replication_displ_;
     int copy_tag_;
     std::vector<size_type> copy_from_;
     std::vector<size_type> copy_from_this_;
+    std::vector<size_type> copy_extra_;
     std::vector<std::pair<int, size_type> > copy_recv_;
     std::vector<std::pair<int, size_type> > copy_send_;
-    typename BaseState::state_pack_type pack_recv_;
-    typename BaseState::state_pack_type pack_send_;
+    std::vector<std::size_t> copy_recv_offset_;
+    std::vector<std::size_t> copy_send_offset_;
+    std::vector<size_type> copy_recv_id_;
+    std::vector<size_type> copy_send_id_;
+    std::vector< ::boost::mpi::request> copy_request_;
+    internal::StateMPIBuffer<BaseState> copy_buffer_;
+#if VSMC_HAS_CXX11LIB_THREAD
+    internal::StateMPIThread copy_wait_thread_;
+#endif
 
     VSMC_DEFINE_METHOD_CHECKER(copy_pre_processor, void, ())
     VSMC_DEFINE_METHOD_CHECKER(copy_post_processor, void, ())
 
+    // Count the number of copies of each particle on node zero and scatter
+    // them to the nodes that own the particles
+    template <typename IntType>
+    void copy_replication (const IntType *copy_from)
+    {
+        const int N = static_cast<int>(this->size());
+        replication_.resize(this->size());
+        size_type *const rptr = N == 0 ? VSMC_NULLPTR : &replication_[0];
+        if (world_.rank() == 0) {
+            const std::size_t S = static_cast<std::size_t>(world_.size());
+            replication_all_.resize(global_size_);
+            std::fill(replication_all_.begin(), replication_all_.end(), 0);
+            for (size_type to = 0; to != global_size_; ++to)
+                ++replication_all_[static_cast<size_type>(copy_from[to])];
+            replication_size_.resize(S);
+            replication_displ_.resize(S);
+            int displ = 0;
+            for (std::size_t r = 0; r != S; ++r) {
+                replication_size_[r] = static_cast<int>(size_all_[r]);
+                replication_displ_[r] = displ;
+                displ += replication_size_[r];
+            }
+            ::boost::mpi::scatterv(world_, global_size_ == 0 ?
+                    VSMC_NULLPTR : &replication_all_[0],
+                    replication_size_, replication_displ_, rptr, N, 0);
+        } else {
+            ::boost::mpi::scatterv(world_, rptr, N, 0);
+        }
+
+        size_type count = 0;
+        for (size_type i = 0; i != this->size(); ++i)
+            count += replication_[i];
+        ::boost::mpi::all_gather(world_, count, count_all_);
+    }
+
+    // Sort the local ids in copy by rank, keeping their order within the
+    // same rank. The ids of rank r are id[offset[r]] to id[offset[r + 1] - 1]
+    void copy_group (const std::vector<std::pair<int, size_type> > &copy,
+            std::vector<std::size_t> &offset, std::vector<size_type> &id)
+    {
+        const std::size_t S = static_cast<std::size_t>(world_.size());
+        offset.resize(S + 1);
+        std::fill(offset.begin(), offset.end(), 0);
+        for (std::size_t i = 0; i != copy.size(); ++i)
+            ++offset[static_cast<std::size_t>(copy[i].first) + 1];
+        for (std::size_t r = 0; r != S; ++r)
+            offset[r + 1] += offset[r];
+        id.resize(copy.size());
+        for (std::size_t i = 0; i != copy.size(); ++i)
+            id[offset[static_cast<std::size_t>(copy[i].first)]++] =
+                copy[i].second;
+        for (std::size_t r = S; r != 0; --r)
+            offset[r] = offset[r - 1];
+        offset[0] = 0;
+    }
+
+    // Pack particles and post non-blocking receives and sends for all nodes
+    void copy_start (const std::vector<std::pair<int, size_type> > &copy_recv,
+            const std::vector<std::pair<int, size_type> > &copy_send)
+    {
+        const std::size_t S = static_cast<std::size_t>(world_.size());
+        copy_group(copy_recv, copy_recv_offset_, copy_recv_id_);
+        copy_group(copy_send, copy_send_offset_, copy_send_id_);
+        copy_buffer_.resize(S);
+        copy_request_.clear();
+        for (std::size_t r = 0; r != S; ++r) {
+            const std::size_t n = copy_recv_offset_[r + 1] -
+                copy_recv_offset_[r];
+            if (n != 0) {
+                copy_request_.push_back(copy_buffer_.recv(world_, copy_tag_,
+                            *this, static_cast<int>(r), n));
+            }
+        }
+        for (std::size_t r = 0; r != S; ++r) {
+            const std::size_t n = copy_send_offset_[r + 1] -
+                copy_send_offset_[r];
+            if (n != 0) {
+                copy_request_.push_back(copy_buffer_.send(world_, copy_tag_,
+                            *this, static_cast<int>(r), n,
+                            &copy_send_id_[copy_send_offset_[r]]));
+            }
+        }
+        copy_started_ = true;
+#if VSMC_HAS_CXX11LIB_THREAD
+        if (copy_thread_ && copy_request_.size() != 0 &&
+                ::boost::mpi::environment::thread_level() >=
+                ::boost::mpi::threading::serialized) {
+            copy_wait_thread_.start(&StateMPI<BaseState, ID>::copy_wait,
+                    this);
+        }
+#endif
+    }
+
+    void copy_wait ()
+    {
+        ::boost::mpi::wait_all(copy_request_.begin(), copy_request_.end());
+        copy_request_.clear();
+    }
+
+    // Systematic resampling of nodes given the sums of weights gathered in
+    // sum_all_, using the uniform random number of the node with rank zero.
+    // The boundary of the last node is set to the number of particles such
+    // that the total is exact regardless of rounding errors
+    void resample_count_node ()
+    {
+        using std::ceil;
+
+        const std::size_t S = static_cast<std::size_t>(world_.size());
+        const double u = sum_all_[1];
+        const double M = static_cast<double>(global_size_);
+
+        double total = 0;
+        for (std::size_t s = 0; s != S; ++s)
+            total += sum_all_[s * 2];
+
+        count_all_.resize(S);
+        double sum = 0;
+        size_type k0 = 0;
+        for (std::size_t s = 0; s != S - 1; ++s) {
+            sum += sum_all_[s * 2];
+            const double x = M * (sum / total) - u;
+            size_type k1 = 0;
+            if (x >= M)
+                k1 = global_size_;
+            else if (x > 0)
+                k1 = static_cast<size_type>(ceil(x));
+            count_all_[s] = k1 - k0;
+            k0 = k1;
+        }
+        count_all_[S - 1] = global_size_ - k0;
+    }
+
     void copy_pre_processor_dispatch (cxx11::true_type)
     {BaseState::copy_pre_processor();}
 
@@ -510,6 +1280,145 @@ class StateMPI : public BaseState
     void copy_post_processor_dispatch (cxx11::false_type) {}
 }; // class StateMPI
 
+/// \brief Sampler<T>::move_type subtype that resamples islands using MPI
+/// \ingroup MPI
+///
+/// \details
+/// It requires the `weight_set_type` of `T` to be WeightSetIsland, and all
+/// nodes to have the same number of particles. In each iteration, it
+/// computes the ESS of islands. If it is less than `threshold` times the
+/// number of nodes, then islands are resampled with systematic resampling
+/// according to their weights. An island with replication number zero is
+/// replaced by a copy of another island, including particles and their
+/// weights within the island, which is transferred between nodes as a whole.
+/// Afterwards all islands have equal weights and the total weight of all
+/// islands is not changed. For example,
+/// ~~~{.cpp}
+/// sampler.move(MoveIsland<T>(0.5), true);
+/// ~~~
+template <typename T>
+class MoveIsland
+{
+    public :
+
+    typedef typename Particle<T>::size_type size_type;
+
+    explicit MoveIsland (double threshold) :
+        threshold_(threshold), island_tag_(0), weight_tag_(1), island_(0) {}
+
+    /// \brief The threshold of island ESS over the number of nodes
+    double threshold () const {return threshold_;}
+
+    /// \brief Set the threshold of island ESS over the number of nodes
+    void threshold (double threshold) {threshold_ = threshold;}
+
+    std::size_t operator() (std::size_t, Particle<T> &particle)
+    {
+        using std::log;
+
+        typename Particle<T>::weight_set_type &weight_set =
+            particle.weight_set();
+        const ::boost::mpi::communicator &world = weight_set.world();
+        const std::size_t S = static_cast<std::size_t>(world.size());
+        const std::size_t R = static_cast<std::size_t>(world.rank());
+        const std::vector<double> &weight = weight_set.island_weight();
+        const double ess = weight_set.island_ess();
+        if (!(ess < threshold_ * static_cast<double>(S)))
+            return 0;
+
+        const double island_log_weight = weight_set.island_log_weight_sum() -
+            log(static_cast<double>(S));
+
+        cxx11::uniform_real_distribution<double> runif(0, 1);
+        double u = runif(particle.resample_rng());
+        ::boost::mpi::broadcast(world, u, 0);
+        replication_.resize(S);
+        double cw = 0;
+        std::size_t k0 = 0;
+        for (std::size_t s = 0; s != S; ++s) {
+            cw += weight[s];
+            std::size_t k1 = S;
+            const double x = static_cast<double>(S) * cw - u;
+            if (s + 1 != S && x < static_cast<double>(S))
+                k1 = x > 0 ? static_cast<std::size_t>(std::ceil(x)) : 0;
+            replication_[s] = k1 - k0;
+            k0 = k1;
+        }
+
+        const size_type N = particle.size();
+#if !VSMC_NO_RUNTIME_ASSERT
+        Array<size_type, 2> lsize;
+        lsize[0] = lsize[1] = N;
+        Array<size_type, 2> gsize;
+        ::boost::mpi::all_reduce(world, lsize, gsize,
+                internal::MoveIslandSize<size_type>());
+        VSMC_RUNTIME_ASSERT_MPI_BACKEND_MPI_MOVE_ISLAND_SIZE(
+                gsize[0], gsize[1]);
+#endif
+
+        id_.resize(N);
+        for (size_type i = 0; i != N; ++i)
+            id_[i] = i;
+        size_type *const iptr = N == 0 ? VSMC_NULLPTR : &id_[0];
+        buffer_.resize(S);
+        request_.clear();
+        double *lwptr = VSMC_NULLPTR;
+        if (replication_[R] > 1) {
+            log_weight_.resize(N);
+            weight_set.read_log_weight(log_weight_.begin());
+            if (N != 0)
+                lwptr = &log_weight_[0];
+        }
+        log_weight_recv_.resize(N);
+        double *const lwrptr = N == 0 ? VSMC_NULLPTR : &log_weight_recv_[0];
+        std::size_t t = 0;
+        for (std::size_t s = 0; s != S; ++s) {
+            for (std::size_t k = 1; k < replication_[s]; ++k) {
+                while (replication_[t] != 0)
+                    ++t;
+                if (s == R) {
+                    request_.push_back(buffer_.send(world, island_tag_,
+                                particle.value(), static_cast<int>(t), N,
+                                iptr));
+                    request_.push_back(world.isend(static_cast<int>(t),
+                                weight_tag_, lwptr, static_cast<int>(N)));
+                } else if (t == R) {
+                    request_.push_back(buffer_.recv(world, island_tag_,
+                                particle.value(), static_cast<int>(s), N));
+                    request_.push_back(world.irecv(static_cast<int>(s),
+                                weight_tag_, lwrptr, static_cast<int>(N)));
+                    island_ = s;
+                }
+                ++t;
+            }
+        }
+        ::boost::mpi::wait_all(request_.begin(), request_.end());
+        request_.clear();
+
+        if (replication_[R] == 0) {
+            buffer_.unpack(particle.value(), static_cast<int>(island_), N,
+                    iptr);
+            weight_set.set_log_weight(log_weight_recv_.begin());
+        }
+        weight_set.island_log_weight(island_log_weight);
+
+        return 0;
+    }
+
+    private :
+
+    double threshold_;
+    int island_tag_;
+    int weight_tag_;
+    std::size_t island_;
+    std::vector<std::size_t> replication_;
+    std::vector<size_type> id_;
+    std::vector<double> log_weight_;
+    std::vector<double> log_weight_recv_;
+    std::vector< ::boost::mpi::request> request_;
+    internal::StateMPIBuffer<T> buffer_;
+}; // class MoveIsland
+
 } // namespace vsmc
 
 #endif // VSMC_MPI_BACKEND_MPI_HPP
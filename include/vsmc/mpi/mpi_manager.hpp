@@ -66,11 +66,27 @@ class MPIEnvironment
 #ifdef BOOST_MPI_HAS_NOARG_INITIALIZATION
     explicit MPIEnvironment (bool abort_on_exception = true) :
         env_(abort_on_exception) {init_seed();}
+
+    explicit MPIEnvironment (::boost::mpi::threading::level mt_level,
+            bool abort_on_exception = true) :
+        env_(mt_level, abort_on_exception) {init_seed();}
 #endif
 
     MPIEnvironment(int &argc, char **&argv, bool abort_on_exception = true) :
         env_(argc, argv, abort_on_exception) {init_seed();}
 
+    /// \brief Initialize MPI with the required level of threading support
+    ///
+    /// \details
+    /// A hybrid program with an SMP `BaseState` in StateMPI, such as
+    /// `StateMPI<StateTBB<...> >`, needs at least
+    /// `boost::mpi::threading::serialized` for `StateMPI::copy_thread`. MPI
+    /// calls are still made by one thread at a time.
+    MPIEnvironment(int &argc, char **&argv,
+            ::boost::mpi::threading::level mt_level,
+            bool abort_on_exception = true) :
+        env_(argc, argv, mt_level, abort_on_exception) {init_seed();}
+
     private :
 
     ::boost::mpi::environment env_;
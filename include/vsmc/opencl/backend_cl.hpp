@@ -33,6 +33,7 @@
 #define VSMC_OPENCL_BACKEND_CL_HPP
 
 #include <vsmc/internal/common.hpp>
+#include <vsmc/core/weight_set.hpp>
 #include <vsmc/opencl/cl_buffer.hpp>
 #include <vsmc/opencl/cl_configure.hpp>
 #include <vsmc/opencl/cl_error.hpp>
@@ -187,6 +188,7 @@ inline void set_cl_fp_type<cl_double> (std::stringstream &ss)
     ss << "#pragma OPENCL EXTENSION cl_amd_fp64 : enable\n";
     ss << "#endif\n";
 
+    ss << "#ifndef FP_TYPE\n";
     ss << "#define FP_TYPE double\n";
     ss << "typedef double fp_type;\n";
     ss << "#endif\n";
@@ -197,8 +199,8 @@ inline void set_cl_fp_type<cl_double> (std::stringstream &ss)
 }
 
 template <typename FPType>
-inline std::string cl_source_macros (
-        std::size_t size, std::size_t state_size, std::size_t seed)
+inline std::string cl_source_macros (std::size_t size, std::size_t state_size,
+        ::cl_ulong seed, bool seed_macro)
 {
     std::stringstream ss;
     set_cl_fp_type<FPType>(ss);
@@ -211,9 +213,11 @@ inline std::string cl_source_macros (
     ss << "#define STATE_SIZE " << state_size << "UL\n";
     ss << "#endif\n";
 
-    ss << "#ifndef SEED\n";
-    ss << "#define SEED " << seed << "UL\n";
-    ss << "#endif\n";
+    if (seed_macro) {
+        ss << "#ifndef SEED\n";
+        ss << "#define SEED " << seed << "UL\n";
+        ss << "#endif\n";
+    }
 
     return ss.str();
 }
@@ -238,6 +242,448 @@ template <typename D>
 struct IsDerivedFromStateCL :
     public cxx11::integral_constant<bool, IsDerivedFromStateCLImpl<D>::value>{};
 
+// The local size of reduction kernels, a power of two no larger than 256 and
+// the maximum work group size of the device
+template <typename ID>
+inline std::size_t cl_reduce_local_size ()
+{
+    std::size_t local_size = 256;
+    std::size_t lmax = 0;
+    CLManager<ID>::instance().device().getInfo(
+            CL_DEVICE_MAX_WORK_GROUP_SIZE, &lmax);
+    while (local_size > lmax && local_size > 1)
+        local_size /= 2;
+
+    return local_size;
+}
+
+// Reduce lmax to the maximum work group size of a kernel
+template <typename ID>
+inline void cl_reduce_work_group_size (const ::cl::Kernel &kern,
+        std::size_t &lmax)
+{
+    std::size_t l = 0;
+    kern.getWorkGroupInfo(CLManager<ID>::instance().device(),
+            CL_KERNEL_WORK_GROUP_SIZE, &l);
+    if (lmax > l)
+        lmax = l;
+}
+
+// Macros used by reduction kernels. REDUCE_LOCAL(op) reduces a __local
+// array of LocalSize elements, op being the operation with l being the
+// local id and l + s the other element
+inline void cl_reduce_source_macros (std::stringstream &ss,
+        std::size_t size, std::size_t local_size, std::size_t group_num)
+{
+    ss << "#define Size " << size << "UL\n";
+    ss << "#define LocalSize " << local_size << "UL\n";
+    ss << "#define GroupNum " << group_num << "UL\n";
+
+    ss << "#define REDUCE_LOCAL(op)                                \\\n";
+    ss << "    barrier(CLK_LOCAL_MEM_FENCE);                       \\\n";
+    ss << "    for (ulong s = LocalSize / 2; s != 0; s /= 2) {     \\\n";
+    ss << "        if (l < s) {op;}                                \\\n";
+    ss << "        barrier(CLK_LOCAL_MEM_FENCE);                   \\\n";
+    ss << "    }\n";
+}
+
+// Kernels of WeightSetCL. Each reduction is done in two levels. Each work
+// group reduces its part into a partial result, and then a single work group
+// reduces the partial results. The maximum, the sums and the ESS are kept in
+// a device buffer of four elements, such that the kernels can be enqueued
+// without waiting for each other and only the ESS is read by the host.
+template <typename FPType, typename ID>
+class CLWeight
+{
+    public :
+
+    typedef CLManager<ID> manager_type;
+
+    CLWeight () : size_(0), local_size_(0), group_num_(0) {}
+
+    static manager_type &manager () {return manager_type::instance();}
+
+    std::size_t size () const {return size_;}
+
+    const ::cl::Program &program () const {return program_;}
+
+    // mode 0: Normalize lw, mode 1: lw += inc, mode 2: lw = inc. The first
+    // kernel waits for events, and each of the others waits for the previous
+    // one, such that they are ordered even on an out-of-order queue
+    double normalize (const ::cl::Buffer &lw, const ::cl::Buffer &w,
+            const ::cl::Buffer &inc, ::cl_ulong mode,
+            const std::vector< ::cl::Event> *events)
+    {
+        const std::size_t global_size = group_num_ * local_size_;
+        std::vector< ::cl::Event> wait(1);
+        ::cl::Event event;
+
+        cl_set_kernel_args(kernel_max_, 0, lw, inc, mode, part_.data());
+        manager().run_kernel(kernel_max_, global_size, local_size_,
+                events, &event, false);
+        wait[0] = event;
+        cl_set_kernel_args(kernel_max_reduce_, 0, part_.data(), res_.data());
+        manager().run_kernel(kernel_max_reduce_, local_size_, local_size_,
+                &wait, &event, false);
+        wait[0] = event;
+        cl_set_kernel_args(kernel_exp_, 0, lw, w, res_.data(), part_.data());
+        manager().run_kernel(kernel_exp_, global_size, local_size_,
+                &wait, &event, false);
+        wait[0] = event;
+        cl_set_kernel_args(kernel_sum_reduce_, 0, part_.data(), res_.data());
+        manager().run_kernel(kernel_sum_reduce_, local_size_, local_size_,
+                &wait, &event, false);
+        wait[0] = event;
+        cl_set_kernel_args(kernel_scale_, 0, w, res_.data());
+        manager().run_kernel(kernel_scale_, global_size, local_size_,
+                &wait, &event, false);
+        wait[0] = event;
+
+        FPType ess = 0;
+        manager().template read_buffer<FPType>(
+                res_.data(), 1, &ess, 3, &wait);
+
+        return static_cast<double>(ess);
+    }
+
+    void equal (const ::cl::Buffer &lw, const ::cl::Buffer &w)
+    {
+        cl_set_kernel_args(kernel_equal_, 0, lw, w);
+        manager().run_kernel(kernel_equal_, group_num_ * local_size_,
+                local_size_);
+    }
+
+    // The local size is a power of two no larger than 256 and the maximum
+    // work group size of the device. The program is rebuilt with a smaller
+    // local size if it is too large for any of the kernels.
+    void build (std::size_t size)
+    {
+        size_ = size;
+        local_size_ = cl_reduce_local_size<ID>();
+        while (true) {
+            build_program();
+            std::size_t lmax = local_size_;
+            cl_reduce_work_group_size<ID>(kernel_max_, lmax);
+            cl_reduce_work_group_size<ID>(kernel_max_reduce_, lmax);
+            cl_reduce_work_group_size<ID>(kernel_exp_, lmax);
+            cl_reduce_work_group_size<ID>(kernel_sum_reduce_, lmax);
+            cl_reduce_work_group_size<ID>(kernel_scale_, lmax);
+            cl_reduce_work_group_size<ID>(kernel_equal_, lmax);
+            if (lmax >= local_size_ || local_size_ == 1)
+                break;
+            while (local_size_ > lmax && local_size_ > 1)
+                local_size_ /= 2;
+        }
+        part_.resize(group_num_ * 2);
+        res_.resize(4);
+    }
+
+    private :
+
+    std::size_t size_;
+    std::size_t local_size_;
+    std::size_t group_num_;
+    ::cl::Program program_;
+    ::cl::Kernel kernel_max_;
+    ::cl::Kernel kernel_max_reduce_;
+    ::cl::Kernel kernel_exp_;
+    ::cl::Kernel kernel_sum_reduce_;
+    ::cl::Kernel kernel_scale_;
+    ::cl::Kernel kernel_equal_;
+    CLBuffer<FPType, ID> part_;
+    CLBuffer<FPType, ID> res_;
+
+    void build_program ()
+    {
+        group_num_ = (size_ + local_size_ - 1) / local_size_;
+
+        std::stringstream ss;
+        set_cl_fp_type<FPType>(ss);
+        cl_reduce_source_macros(ss, size_, local_size_, group_num_);
+
+        ss << "__kernel void weight_max (__global fp_type *lw,\n";
+        ss << "        __global const fp_type *inc, ulong mode,\n";
+        ss << "        __global fp_type *part)\n";
+        ss << "{\n";
+        ss << "    __local fp_type buf[LocalSize];\n";
+        ss << "    ulong i = get_global_id(0);\n";
+        ss << "    ulong l = get_local_id(0);\n";
+        ss << "    fp_type v = -INFINITY;\n";
+        ss << "    if (i < Size) {\n";
+        ss << "        if (mode == 1) lw[i] += inc[i];\n";
+        ss << "        else if (mode == 2) lw[i] = inc[i];\n";
+        ss << "        v = lw[i];\n";
+        ss << "    }\n";
+        ss << "    buf[l] = v;\n";
+        ss << "    REDUCE_LOCAL(buf[l] = fmax(buf[l], buf[l + s]))\n";
+        ss << "    if (l == 0) part[get_group_id(0)] = buf[0];\n";
+        ss << "}\n";
+
+        ss << "__kernel void weight_max_reduce (\n";
+        ss << "        __global const fp_type *part, __global fp_type *res)\n";
+        ss << "{\n";
+        ss << "    __local fp_type buf[LocalSize];\n";
+        ss << "    ulong l = get_local_id(0);\n";
+        ss << "    fp_type v = -INFINITY;\n";
+        ss << "    for (ulong j = l; j < GroupNum; j += LocalSize)\n";
+        ss << "        v = fmax(v, part[j]);\n";
+        ss << "    buf[l] = v;\n";
+        ss << "    REDUCE_LOCAL(buf[l] = fmax(buf[l], buf[l + s]))\n";
+        ss << "    if (l == 0) res[0] = buf[0];\n";
+        ss << "}\n";
+
+        ss << "__kernel void weight_exp (__global fp_type *lw,\n";
+        ss << "        __global fp_type *w, __global const fp_type *res,\n";
+        ss << "        __global fp_type *part)\n";
+        ss << "{\n";
+        ss << "    __local fp_type buf[LocalSize];\n";
+        ss << "    __local fp_type buf2[LocalSize];\n";
+        ss << "    ulong i = get_global_id(0);\n";
+        ss << "    ulong l = get_local_id(0);\n";
+        ss << "    fp_type v = 0;\n";
+        ss << "    if (i < Size) {\n";
+        ss << "        fp_type x = lw[i] - res[0];\n";
+        ss << "        lw[i] = x;\n";
+        ss << "        v = exp(x);\n";
+        ss << "        w[i] = v;\n";
+        ss << "    }\n";
+        ss << "    buf[l] = v;\n";
+        ss << "    buf2[l] = v * v;\n";
+        ss << "    REDUCE_LOCAL(buf[l] += buf[l + s];\n";
+        ss << "            buf2[l] += buf2[l + s])\n";
+        ss << "    if (l == 0) {\n";
+        ss << "        part[get_group_id(0)] = buf[0];\n";
+        ss << "        part[GroupNum + get_group_id(0)] = buf2[0];\n";
+        ss << "    }\n";
+        ss << "}\n";
+
+        ss << "__kernel void weight_sum_reduce (\n";
+        ss << "        __global const fp_type *part, __global fp_type *res)\n";
+        ss << "{\n";
+        ss << "    __local fp_type buf[LocalSize];\n";
+        ss << "    __local fp_type buf2[LocalSize];\n";
+        ss << "    ulong l = get_local_id(0);\n";
+        ss << "    fp_type v = 0;\n";
+        ss << "    fp_type v2 = 0;\n";
+        ss << "    for (ulong j = l; j < GroupNum; j += LocalSize) {\n";
+        ss << "        v += part[j];\n";
+        ss << "        v2 += part[GroupNum + j];\n";
+        ss << "    }\n";
+        ss << "    buf[l] = v;\n";
+        ss << "    buf2[l] = v2;\n";
+        ss << "    REDUCE_LOCAL(buf[l] += buf[l + s];\n";
+        ss << "            buf2[l] += buf2[l + s])\n";
+        ss << "    if (l == 0) {\n";
+        ss << "        res[1] = buf[0];\n";
+        ss << "        res[2] = buf2[0];\n";
+        ss << "        res[3] = buf[0] * buf[0] / buf2[0];\n";
+        ss << "    }\n";
+        ss << "}\n";
+
+        ss << "__kernel void weight_scale (__global fp_type *w,\n";
+        ss << "        __global const fp_type *res)\n";
+        ss << "{\n";
+        ss << "    ulong i = get_global_id(0);\n";
+        ss << "    if (i < Size) w[i] /= res[1];\n";
+        ss << "}\n";
+
+        ss << "__kernel void weight_equal (__global fp_type *lw,\n";
+        ss << "        __global fp_type *w)\n";
+        ss << "{\n";
+        ss << "    ulong i = get_global_id(0);\n";
+        ss << "    if (i >= Size) return;\n";
+        ss << "    lw[i] = 0;\n";
+        ss << "    w[i] = 1 / (fp_type) Size;\n";
+        ss << "}\n";
+
+        manager().build_program(program_, ss.str());
+        kernel_max_ = ::cl::Kernel(program_, "weight_max");
+        kernel_max_reduce_ = ::cl::Kernel(program_, "weight_max_reduce");
+        kernel_exp_ = ::cl::Kernel(program_, "weight_exp");
+        kernel_sum_reduce_ = ::cl::Kernel(program_, "weight_sum_reduce");
+        kernel_scale_ = ::cl::Kernel(program_, "weight_scale");
+        kernel_equal_ = ::cl::Kernel(program_, "weight_equal");
+    }
+}; // class CLWeight
+
+// Reduction kernels of StateCL, used by InitializeCL and MoveCL to sum the
+// acceptance counts and by MonitorEvalCL to integrate the results against
+// the weights, such that only the final results are read by the host
+template <typename FPType, typename ID>
+class CLReduce
+{
+    public :
+
+    typedef CLManager<ID> manager_type;
+
+    CLReduce () : size_(0), local_size_(0), group_num_(0) {}
+
+    static manager_type &manager () {return manager_type::instance();}
+
+    std::size_t size () const {return size_;}
+
+    const ::cl::Program &program () const {return program_;}
+
+    // Sum of accept[i], i = 0, ..., Size - 1. The kernels wait for events
+    // and the host waits for the result
+    ::cl_ulong accept (const ::cl::Buffer &accept,
+            const std::vector< ::cl::Event> *events)
+    {
+        std::vector< ::cl::Event> wait(1);
+
+        cl_set_kernel_args(kernel_accept_, 0, accept, accept_part_.data());
+        manager().run_kernel(kernel_accept_, group_num_ * local_size_,
+                local_size_, events, &wait[0], false);
+        cl_set_kernel_args(kernel_accept_reduce_, 0,
+                accept_part_.data(), accept_res_.data());
+        ::cl::Event event;
+        manager().run_kernel(kernel_accept_reduce_, local_size_,
+                local_size_, &wait, &event, false);
+        wait[0] = event;
+
+        ::cl_ulong res = 0;
+        manager().template read_buffer< ::cl_ulong>(
+                accept_res_.data(), 1, &res, 0, &wait);
+
+        return res;
+    }
+
+    // res[d] = sum of weight[i] * buffer[i * dim + d], d = 0, ..., dim - 1.
+    // The kernels wait for events and the host waits for the results
+    void integrate (std::size_t dim, const ::cl::Buffer &buffer,
+            const ::cl::Buffer &weight, double *res,
+            const std::vector< ::cl::Event> *events)
+    {
+        if (integrate_part_.size() < dim * group_num_)
+            integrate_part_.resize(dim * group_num_);
+        if (integrate_res_.size() < dim)
+            integrate_res_.resize(dim);
+
+        std::vector< ::cl::Event> wait(1);
+
+        cl_set_kernel_args(kernel_integrate_, 0, static_cast< ::cl_ulong>(dim),
+                buffer, weight, integrate_part_.data());
+        manager().run_kernel(kernel_integrate_,
+                dim * group_num_ * local_size_, local_size_,
+                events, &wait[0], false);
+        cl_set_kernel_args(kernel_integrate_reduce_, 0,
+                integrate_part_.data(), integrate_res_.data());
+        ::cl::Event event;
+        manager().run_kernel(kernel_integrate_reduce_, dim * local_size_,
+                local_size_, &wait, &event, false);
+        wait[0] = event;
+
+        manager().template read_buffer<FPType>(
+                integrate_res_.data(), dim, res, 0, &wait);
+    }
+
+    void build (std::size_t size)
+    {
+        size_ = size;
+        local_size_ = cl_reduce_local_size<ID>();
+        while (true) {
+            build_program();
+            std::size_t lmax = local_size_;
+            cl_reduce_work_group_size<ID>(kernel_accept_, lmax);
+            cl_reduce_work_group_size<ID>(kernel_accept_reduce_, lmax);
+            cl_reduce_work_group_size<ID>(kernel_integrate_, lmax);
+            cl_reduce_work_group_size<ID>(kernel_integrate_reduce_, lmax);
+            if (lmax >= local_size_ || local_size_ == 1)
+                break;
+            while (local_size_ > lmax && local_size_ > 1)
+                local_size_ /= 2;
+        }
+        accept_part_.resize(group_num_);
+        accept_res_.resize(1);
+    }
+
+    private :
+
+    std::size_t size_;
+    std::size_t local_size_;
+    std::size_t group_num_;
+    ::cl::Program program_;
+    ::cl::Kernel kernel_accept_;
+    ::cl::Kernel kernel_accept_reduce_;
+    ::cl::Kernel kernel_integrate_;
+    ::cl::Kernel kernel_integrate_reduce_;
+    CLBuffer< ::cl_ulong, ID> accept_part_;
+    CLBuffer< ::cl_ulong, ID> accept_res_;
+    CLBuffer<FPType, ID> integrate_part_;
+    CLBuffer<FPType, ID> integrate_res_;
+
+    void build_program ()
+    {
+        group_num_ = (size_ + local_size_ - 1) / local_size_;
+
+        std::stringstream ss;
+        set_cl_fp_type<FPType>(ss);
+        cl_reduce_source_macros(ss, size_, local_size_, group_num_);
+
+        ss << "__kernel void accept_sum (__global const ulong *accept,\n";
+        ss << "        __global ulong *part)\n";
+        ss << "{\n";
+        ss << "    __local ulong buf[LocalSize];\n";
+        ss << "    ulong i = get_global_id(0);\n";
+        ss << "    ulong l = get_local_id(0);\n";
+        ss << "    buf[l] = i < Size ? accept[i] : 0;\n";
+        ss << "    REDUCE_LOCAL(buf[l] += buf[l + s])\n";
+        ss << "    if (l == 0) part[get_group_id(0)] = buf[0];\n";
+        ss << "}\n";
+
+        ss << "__kernel void accept_sum_reduce (\n";
+        ss << "        __global const ulong *part, __global ulong *res)\n";
+        ss << "{\n";
+        ss << "    __local ulong buf[LocalSize];\n";
+        ss << "    ulong l = get_local_id(0);\n";
+        ss << "    ulong v = 0;\n";
+        ss << "    for (ulong j = l; j < GroupNum; j += LocalSize)\n";
+        ss << "        v += part[j];\n";
+        ss << "    buf[l] = v;\n";
+        ss << "    REDUCE_LOCAL(buf[l] += buf[l + s])\n";
+        ss << "    if (l == 0) res[0] = buf[0];\n";
+        ss << "}\n";
+
+        // Work group g reduces the block g % GroupNum of the column
+        // g / GroupNum, and part has GroupNum elements for each column
+        ss << "__kernel void integrate (ulong dim,\n";
+        ss << "        __global const fp_type *buffer,\n";
+        ss << "        __global const fp_type *weight,\n";
+        ss << "        __global fp_type *part)\n";
+        ss << "{\n";
+        ss << "    __local fp_type buf[LocalSize];\n";
+        ss << "    ulong g = get_group_id(0);\n";
+        ss << "    ulong d = g / GroupNum;\n";
+        ss << "    ulong l = get_local_id(0);\n";
+        ss << "    ulong i = (g % GroupNum) * LocalSize + l;\n";
+        ss << "    buf[l] = i < Size ? weight[i] * buffer[i * dim + d] : 0;\n";
+        ss << "    REDUCE_LOCAL(buf[l] += buf[l + s])\n";
+        ss << "    if (l == 0) part[g] = buf[0];\n";
+        ss << "}\n";
+
+        ss << "__kernel void integrate_reduce (\n";
+        ss << "        __global const fp_type *part, __global fp_type *res)\n";
+        ss << "{\n";
+        ss << "    __local fp_type buf[LocalSize];\n";
+        ss << "    ulong d = get_group_id(0);\n";
+        ss << "    ulong l = get_local_id(0);\n";
+        ss << "    fp_type v = 0;\n";
+        ss << "    for (ulong j = l; j < GroupNum; j += LocalSize)\n";
+        ss << "        v += part[d * GroupNum + j];\n";
+        ss << "    buf[l] = v;\n";
+        ss << "    REDUCE_LOCAL(buf[l] += buf[l + s])\n";
+        ss << "    if (l == 0) res[d] = buf[0];\n";
+        ss << "}\n";
+
+        manager().build_program(program_, ss.str());
+        kernel_accept_ = ::cl::Kernel(program_, "accept_sum");
+        kernel_accept_reduce_ = ::cl::Kernel(program_, "accept_sum_reduce");
+        kernel_integrate_ = ::cl::Kernel(program_, "integrate");
+        kernel_integrate_reduce_ = ::cl::Kernel(program_,
+                "integrate_reduce");
+    }
+}; // class CLReduce
+
 } // namespace vsmc::internal
 
 /// \brief Particle::value_type subtype using OpenCL
@@ -256,7 +702,7 @@ class StateCL
 
     explicit StateCL (size_type N) :
         state_size_(StateSize == Dynamic ? 1 : StateSize),
-        size_(N), build_(false), build_id_(0),
+        size_(N), seed_(0), build_(false), build_id_(0),
         state_buffer_(state_size_ * size_)
         {
 #if VSMC_OPENCL_VERSION >= 120
@@ -340,18 +786,25 @@ class StateCL
     /// // ... User source, passed by the source argument
     /// ~~~
     /// After build, `vsmc::Seed::instance().skip(N)` is called with `N`
-    /// being the nubmer of particles.
+    /// being the nubmer of particles. The seed is also returned by `seed()`.
+    ///
+    /// The program, together with the programs generated by the library, is
+    /// built by CLManager::build_program, and thus the program binary cache is
+    /// used if it is enabled through CLSetup::cache_dir. In that case, the
+    /// `SEED` macro is not defined, such that the cache is reused for all
+    /// seeds, and the kernels shall take `seed()` as an argument instead.
     template <typename CharT, typename Traits>
     void build (const std::string &source,
             const std::string &flags, std::basic_ostream<CharT, Traits> &os)
     {
         VSMC_STATIC_ASSERT_OPENCL_BACKEND_CL_STATE_CL_FP_TYPE(fp_type);
 
+        seed_ = Seed::instance().get();
         std::string src(internal::cl_source_macros<fp_type>(
-                    size_, state_size_, Seed::instance().get()) + source);
+                    size_, state_size_, seed_,
+                    CLSetup<ID>::instance().cache_dir().empty()) + source);
         Seed::instance().skip(static_cast<Seed::skip_type>(size_));
-        program_ = manager().create_program(src);
-        build_program(flags, os);
+        build_program(&src, flags, os);
     }
 
     void build (const std::string &source,
@@ -364,7 +817,7 @@ class StateCL
             const std::string &flags, std::basic_ostream<CharT, Traits> &os)
     {
         program_ = program;
-        build_program(flags, os);
+        build_program(VSMC_NULLPTR, flags, os);
     }
 
     void build (const ::cl::Program &program,
@@ -374,6 +827,16 @@ class StateCL
     /// \brief Whether the last attempted building success
     bool build () const {return build_;}
 
+    /// \brief The seed of the kernels, set when the program is built from
+    /// source
+    ///
+    /// \details
+    /// The particles are assigned the seeds `seed()`, ..., `seed() + N - 1`.
+    /// It is the value of the `SEED` macro if the program binary cache is
+    /// disabled. Otherwise the macro is not defined and the kernels shall
+    /// take the seed as an argument.
+    ::cl_ulong seed () const {return seed_;}
+
     /// \brief The build id of the last attempted of building
     ///
     /// \details
@@ -391,14 +854,112 @@ class StateCL
         return ::cl::Kernel(program_, name.c_str());
     }
 
+    /// \brief Sum of a device buffer of acceptance counts
+    ///
+    /// \details
+    /// The buffer has `size()` elements of type `cl_ulong`. The sum is
+    /// computed by reduction kernels built together with the user program and
+    /// only the sum is read by the host. If build() does not return `true`,
+    /// then calling this is an error
+    std::size_t accept_count (const ::cl::Buffer &accept) const
+    {
+        VSMC_RUNTIME_ASSERT_OPENCL_BACKEND_CL_BUILD(accept_count);
+
+        std::size_t acc = static_cast<std::size_t>(
+                reduce_.accept(accept, event_wait_list()));
+        events_.clear();
+
+        return acc;
+    }
+
+    /// \brief Integrate a device buffer of results against weights
+    ///
+    /// \details
+    /// The buffer has `size() * dim` elements of type `fp_type`, the results
+    /// of the `i`th particle being stored at `i * dim`, ..., `i * dim + dim -
+    /// 1`. The weights are a buffer of `size()` normalized weights of type
+    /// `fp_type`. The `dim` weighted sums are computed by reduction kernels
+    /// and written to `res`. If build() does not return `true`, then calling
+    /// this is an error
+    void integrate (std::size_t dim, const ::cl::Buffer &buffer,
+            const ::cl::Buffer &weight, double *res) const
+    {
+        VSMC_RUNTIME_ASSERT_OPENCL_BACKEND_CL_BUILD(integrate);
+
+        if (dim != 0) {
+            reduce_.integrate(dim, buffer, weight, res, event_wait_list());
+            events_.clear();
+        }
+    }
+
+    /// \brief Events of the commands on the state that have not been waited
+    /// for by the host
+    ///
+    /// \details
+    /// If the `CLConfigure::async` of InitializeCL, MoveCL, MonitorEvalCL,
+    /// PathEvalCL or `copy_configure()` is set to `true`, their kernels are
+    /// enqueued without waiting for them. Each command on the state waits
+    /// for the events returned by `event_wait_list` and replaces them by its
+    /// own event. The host waits only when it needs a result, which is the
+    /// acceptance count of a move, the results of a Monitor or Path, or the
+    /// state values copied to the host. Thus host work, such as the
+    /// `post_processor` of a move, overlaps with the device work. Since all
+    /// commands of the library on the state are chained by events, they are
+    /// correctly ordered even if the command queue set by CLManager::setup
+    /// is an out-of-order one. In this case, commands enqueued by the user,
+    /// such as a kernel computing incremental weights in the `pre_processor`
+    /// of a move, shall also use `event_wait_list` and `event` to join the
+    /// chain. Likewise, reading the results of a kernel in the
+    /// `post_processor`, or passing them to WeightSetCL::add_log_weight,
+    /// shall wait for `event_wait_list`.
+    const std::vector< ::cl::Event> &events () const {return events_;}
+
+    /// \brief The event wait list of the next command on the state, `NULL`
+    /// if there is no event to wait for
+    const std::vector< ::cl::Event> *event_wait_list () const
+    {return events_.size() == 0 ? VSMC_NULLPTR : &events_;}
+
+    /// \brief Set the event of the last command on the state
+    ///
+    /// \details
+    /// The command shall have been enqueued with `event_wait_list()` as its
+    /// dependencies, since it replaces all current events.
+    void event (const ::cl::Event &e) const {events_.assign(1, e);}
+
+    /// \brief Wait for all commands on the state to complete
+    void wait () const
+    {
+        if (events_.size() != 0) {
+            ::cl::Event::waitForEvents(events_);
+            events_.clear();
+        }
+    }
+
     template <typename IntType>
     void copy (std::size_t N, const IntType *copy_from)
     {
         VSMC_RUNTIME_ASSERT_OPENCL_BACKEND_CL_COPY_SIZE_MISMATCH;
 
-        manager().template write_buffer<size_type>(
-                copy_from_buffer_.data(), N, copy_from);
-        copy_(copy_from_buffer_.data(), state_buffer_.data());
+        // The staging buffer of the last asynchronous write shall not be
+        // changed before the write completes
+        if (copy_write_event_() != VSMC_NULLPTR) {
+            copy_write_event_.wait();
+            copy_write_event_ = ::cl::Event();
+        }
+
+        const bool block = !copy_.configure().async();
+        copy_from_host_.resize(N);
+        std::copy(copy_from, copy_from + N, copy_from_host_.begin());
+        std::vector< ::cl::Event> wait(1);
+        manager().template write_buffer<size_type>(copy_from_buffer_.data(),
+                N, &copy_from_host_[0], 0, event_wait_list(), &wait[0],
+                block);
+        if (!block)
+            copy_write_event_ = wait[0];
+        ::cl::Event event;
+        copy_(copy_from_buffer_.data(), state_buffer_.data(),
+                &wait, &event, block);
+        this->event(event);
     }
 
     void copy_pre_processor ()
@@ -424,7 +985,8 @@ class StateCL
 
         std::memset(&state_idx_host_[0], 0, size_);
         manager().read_buffer(state_buffer_.data(), size_ * state_size_,
-                &state_tmp_host_[0]);
+                &state_tmp_host_[0], 0, event_wait_list());
+        events_.clear();
     }
 
     void copy_post_processor ()
@@ -433,8 +995,11 @@ class StateCL
                 &state_idx_host_[0]);
         manager().write_buffer(state_tmp_buffer_.data(), size_ * state_size_,
                 &state_tmp_host_[0]);
+        ::cl::Event event;
         copy_(state_idx_buffer_.data(), state_tmp_buffer_.data(),
-                state_buffer_.data());
+                state_buffer_.data(), event_wait_list(), &event,
+                !copy_.configure().async());
+        this->event(event);
     }
 
     state_pack_type state_pack (size_type id) const
@@ -466,6 +1031,7 @@ class StateCL
 
     std::size_t state_size_;
     size_type size_;
+    ::cl_ulong seed_;
 
     ::cl::Program program_;
 
@@ -474,7 +1040,11 @@ class StateCL
 
     CLBuffer<char, ID> state_buffer_;
     CLBuffer<size_type, ID> copy_from_buffer_;
+    std::vector<size_type> copy_from_host_;
+    ::cl::Event copy_write_event_;
     internal::CLCopy<ID> copy_;
+    mutable internal::CLReduce<FPType, ID> reduce_;
+    mutable std::vector< ::cl::Event> events_;
 
     CLBuffer<char, ID> state_idx_buffer_;
     CLBuffer<char, ID> state_tmp_buffer_;
@@ -482,19 +1052,24 @@ class StateCL
     std::vector<char, AlignedAllocator<char> > state_tmp_host_;
 
     template <typename CharT, typename Traits>
-    void build_program (const std::string flags,
+    void build_program (const std::string *src, const std::string &flags,
             std::basic_ostream<CharT, Traits> &os)
     {
         ++build_id_;
 
         build_ = false;
         try {
-            program_.build(manager().device_vec(), flags.c_str());
+            if (src == VSMC_NULLPTR)
+                program_.build(manager().device_vec(), flags.c_str());
+            else
+                manager().build_program(program_, *src, flags);
             copy_.build(size_, state_size_);
+            reduce_.build(size_);
             build_ = true;
         } catch (const ::cl::Error &err) {
             CLQuery::program_build_log(program_, os);
             CLQuery::program_build_log(copy_.program(), os);
+            CLQuery::program_build_log(reduce_.program(), os);
             throw CLError(err);
         }
     }
@@ -512,6 +1087,317 @@ class StateCL
     {return Array<char, StateSize>();}
 }; // class StateCL
 
+/// \brief Particle::weight_set_type subtype using OpenCL
+/// \ingroup OpenCL
+///
+/// \details
+/// The logarithm weights and the normalized weights are also kept in device
+/// buffers of type `FPType` (`log_weight_buffer` and `weight_buffer`).
+/// Incremental logarithm weights computed on the device, for example, by a
+/// MoveCL kernel into a buffer set as an additional argument, can be passed
+/// to `add_log_weight` or `set_log_weight` as a `cl::Buffer` of `size()`
+/// elements. The maximum, the exponentials, the normalization and the ESS
+/// are all computed by kernels, and only the ESS is read by the host. To use
+/// it, define `weight_set_type` in the value type of Particle, for example,
+/// ~~~{.cpp}
+/// class cv_state : public StateCL<4, cl_float>
+/// {
+///     public :
+///
+///     typedef WeightSetCL<cl_float> weight_set_type;
+///
+///     // ...
+/// };
+/// ~~~
+///
+/// All other member functions work on the host as those of WeightSet. The
+/// host weights are read from the device only when they are accessed after
+/// the device weights are changed, for example, by `weight_data` or by
+/// Particle::resample. Weights changed on the host are written to the device
+/// only when the device buffers are needed again.
+template <typename FPType, typename ID>
+class WeightSetCL : public WeightSet
+{
+    public :
+
+    typedef WeightSet::size_type size_type;
+    typedef FPType fp_type;
+    typedef ID cl_id;
+    typedef CLManager<ID> manager_type;
+
+    explicit WeightSetCL (size_type N) :
+        WeightSet(N), host_valid_(true), device_valid_(false),
+        log_weight_buffer_(N), weight_buffer_(N)
+    {
+        VSMC_STATIC_ASSERT_OPENCL_BACKEND_CL_STATE_CL_FP_TYPE(fp_type);
+
+        // OpenCL rejects empty buffers and empty ranges, and without
+        // particles no kernel is ever run
+        if (N != 0)
+            cl_weight_.build(N);
+    }
+
+    static manager_type &manager () {return manager_type::instance();}
+
+    /// \brief The device buffer of normalized logarithm weights (read only)
+    const CLBuffer<fp_type, ID> &log_weight_buffer () const
+    {
+        write_device();
+
+        return log_weight_buffer_;
+    }
+
+    /// \brief The device buffer of normalized weights (read only)
+    const CLBuffer<fp_type, ID> &weight_buffer () const
+    {
+        write_device();
+
+        return weight_buffer_;
+    }
+
+    /// \brief Set normalized weight, unnormalized logarithm weight and ESS
+    /// such that each particle has a equal weight, on both the host and the
+    /// device
+    void set_equal_weight ()
+    {
+        WeightSet::set_equal_weight();
+        if (this->size() != 0)
+            cl_weight_.equal(log_weight_buffer_.data(), weight_buffer_.data());
+        host_valid_ = true;
+        device_valid_ = true;
+    }
+
+    /// \brief Set logarithm weights from a device buffer
+    ///
+    /// \details
+    /// The kernels wait for `events` if it is not `NULL`, for example,
+    /// StateCL::event_wait_list when the buffer is computed by an
+    /// asynchronous MoveCL on an out-of-order command queue
+    void set_log_weight (const ::cl::Buffer &first,
+            const std::vector< ::cl::Event> *events = VSMC_NULLPTR)
+    {device_normalize(first, 2, events);}
+
+    template <typename InputIter>
+    void set_log_weight (InputIter first)
+    {WeightSet::set_log_weight(first);}
+
+    template <typename RandomIter>
+    void set_log_weight (RandomIter first, int stride)
+    {WeightSet::set_log_weight(first, stride);}
+
+    /// \brief Add incremental logarithm weights from a device buffer
+    ///
+    /// \details
+    /// The kernels wait for `events` if it is not `NULL`
+    void add_log_weight (const ::cl::Buffer &first,
+            const std::vector< ::cl::Event> *events = VSMC_NULLPTR)
+    {
+        write_device();
+        device_normalize(first, 1, events);
+    }
+
+    template <typename InputIter>
+    void add_log_weight (InputIter first)
+    {
+        read_host();
+        WeightSet::add_log_weight(first);
+    }
+
+    template <typename RandomIter>
+    void add_log_weight (RandomIter first, int stride)
+    {
+        read_host();
+        WeightSet::add_log_weight(first, stride);
+    }
+
+    template <typename InputIter>
+    void mul_weight (InputIter first)
+    {
+        read_host();
+        WeightSet::mul_weight(first);
+    }
+
+    template <typename RandomIter>
+    void mul_weight (RandomIter first, int stride)
+    {
+        read_host();
+        WeightSet::mul_weight(first, stride);
+    }
+
+    void read_resample_weight (double *first) const
+    {
+        read_host();
+        WeightSet::read_resample_weight(first);
+    }
+
+    template <typename OutputIter>
+    void read_weight (OutputIter first) const
+    {
+        read_host();
+        WeightSet::read_weight(first);
+    }
+
+    template <typename RandomIter>
+    void read_weight (RandomIter first, int stride) const
+    {
+        read_host();
+        WeightSet::read_weight(first, stride);
+    }
+
+    template <typename OutputIter>
+    void read_log_weight (OutputIter first) const
+    {
+        read_host();
+        WeightSet::read_log_weight(first);
+    }
+
+    template <typename RandomIter>
+    void read_log_weight (RandomIter first, int stride) const
+    {
+        read_host();
+        WeightSet::read_log_weight(first, stride);
+    }
+
+    double weight (size_type id) const
+    {
+        read_host();
+
+        return WeightSet::weight(id);
+    }
+
+    double log_weight (size_type id) const
+    {
+        read_host();
+
+        return WeightSet::log_weight(id);
+    }
+
+    template <typename URNG>
+    size_type draw (URNG &eng) const
+    {
+        read_host();
+
+        return WeightSet::draw(eng);
+    }
+
+    const double *resample_weight_data () const
+    {
+        read_host();
+
+        return WeightSet::resample_weight_data();
+    }
+
+    const double *weight_data () const
+    {
+        read_host();
+
+        return WeightSet::weight_data();
+    }
+
+    const double *log_weight_data () const
+    {
+        read_host();
+
+        return WeightSet::log_weight_data();
+    }
+
+    protected :
+
+    // All weights set on the host end with one of the following two
+
+    void post_set_log_weight ()
+    {
+        WeightSet::post_set_log_weight();
+        host_valid_ = true;
+        device_valid_ = false;
+    }
+
+    void normalize_log_weight ()
+    {
+        WeightSet::normalize_log_weight();
+        host_valid_ = true;
+        device_valid_ = false;
+    }
+
+    double compute_ess (const double *first, bool use_log) const
+    {
+        read_host();
+
+        return WeightSet::compute_ess(first, use_log);
+    }
+
+    double compute_cess (const double *first, bool use_log) const
+    {
+        read_host();
+
+        return WeightSet::compute_cess(first, use_log);
+    }
+
+    void compute_ess_batch (const double *first, std::size_t n,
+            double alpha, double step, double *res, bool use_cess) const
+    {
+        read_host();
+        WeightSet::compute_ess_batch(first, n, alpha, step, res, use_cess);
+    }
+
+    private :
+
+    mutable bool host_valid_;
+    mutable bool device_valid_;
+    CLBuffer<fp_type, ID> log_weight_buffer_;
+    CLBuffer<fp_type, ID> weight_buffer_;
+    internal::CLWeight<fp_type, ID> cl_weight_;
+
+    void device_normalize (const ::cl::Buffer &inc, ::cl_ulong mode,
+            const std::vector< ::cl::Event> *events)
+    {
+        if (this->size() == 0)
+            return;
+
+        this->set_ess(cl_weight_.normalize(log_weight_buffer_.data(),
+                    weight_buffer_.data(), inc, mode, events));
+        host_valid_ = false;
+        device_valid_ = true;
+    }
+
+    // Read the device weights into the host weights if the later are stale
+    void read_host () const
+    {
+        if (host_valid_)
+            return;
+
+        if (this->size() == 0) {
+            host_valid_ = true;
+            return;
+        }
+
+        WeightSetCL<FPType, ID> *ws = const_cast<WeightSetCL<FPType, ID> *>(
+                this);
+        manager().template read_buffer<fp_type>(log_weight_buffer_.data(),
+                this->size(), ws->mutable_log_weight_data());
+        manager().template read_buffer<fp_type>(weight_buffer_.data(),
+                this->size(), ws->mutable_weight_data());
+        host_valid_ = true;
+    }
+
+    // Write the host weights into the device weights if the later are stale
+    void write_device () const
+    {
+        if (device_valid_)
+            return;
+
+        if (this->size() != 0) {
+            const double *const lwptr = WeightSet::log_weight_data();
+            const double *const wptr = WeightSet::weight_data();
+            manager().template write_buffer<fp_type>(
+                    log_weight_buffer_.data(), this->size(), lwptr);
+            manager().template write_buffer<fp_type>(
+                    weight_buffer_.data(), this->size(), wptr);
+        }
+        device_valid_ = true;
+    }
+}; // class WeightSetCL
+
 /// \brief Sampler<T>::init_type subtype using OpenCL
 /// \ingroup OpenCL
 ///
@@ -562,8 +1448,12 @@ class InitializeCL
         set_kernel_args(particle);
         initialize_param(particle, param);
         pre_processor(particle);
+        ::cl::Event event;
         particle.value().manager().run_kernel(
-                kernel_, particle.size(), configure_.local_size());
+                kernel_, particle.size(), configure_.local_size(),
+                particle.value().event_wait_list(), &event,
+                !configure_.async());
+        particle.value().event(event);
         post_processor(particle);
 
         return accept_count(particle, accept_buffer_.data());
@@ -574,16 +1464,14 @@ class InitializeCL
     virtual void pre_processor (Particle<T> &) {}
     virtual void post_processor (Particle<T> &) {}
 
+    /// \brief The number of accepted moves
+    ///
+    /// \details
+    /// By default, the sum of the acceptance counts written by the kernel is
+    /// computed by StateCL::accept_count on the device
     virtual std::size_t accept_count (Particle<T> &particle,
             const ::cl::Buffer &accept_buffer)
-    {
-        particle.value().manager().read_buffer(
-                accept_buffer, particle.size(), &accept_host_[0]);
-
-        return static_cast<std::size_t>(std::accumulate(
-                    accept_host_.begin(), accept_host_.end(),
-                    static_cast< ::cl_ulong>(0)));
-    }
+    {return particle.value().accept_count(accept_buffer);}
 
     virtual void set_kernel (const Particle<T> &particle)
     {
@@ -594,19 +1482,15 @@ class InitializeCL
 
     virtual void set_kernel_args (const Particle<T> &particle)
     {
-        accept_host_.resize(particle.size());
 #if VSMC_OPENCL_VERSION >= 120
         if (particle.value().manager().opencl_version() >= 120) {
             accept_buffer_.resize(particle.size(),
-                    CL_MEM_READ_WRITE|CL_MEM_HOST_READ_ONLY|
-                    CL_MEM_USE_HOST_PTR, &accept_host_[0]);
+                    CL_MEM_READ_WRITE|CL_MEM_HOST_READ_ONLY);
         } else {
-            accept_buffer_.resize(particle.size(),
-                    CL_MEM_READ_WRITE|CL_MEM_USE_HOST_PTR, &accept_host_[0]);
+            accept_buffer_.resize(particle.size());
         }
 #else
-        accept_buffer_.resize(particle.size(),
-                CL_MEM_READ_WRITE|CL_MEM_USE_HOST_PTR, &accept_host_[0]);
+        accept_buffer_.resize(particle.size());
 #endif
         cl_set_kernel_args(kernel_, 0,
                 particle.value().state_buffer().data(), accept_buffer_.data());
@@ -623,7 +1507,6 @@ class InitializeCL
 
     VSMC_DEFINE_OPENCL_MEMBER_DATA;
     CLBuffer< ::cl_ulong, typename T::cl_id> accept_buffer_;
-    std::vector< ::cl_ulong> accept_host_;
 }; // class InitializeCL
 
 /// \brief Sampler<T>::move_type subtype using OpenCL
@@ -657,8 +1540,12 @@ class MoveCL
 
         set_kernel_args(iter, particle);
         pre_processor(iter, particle);
+        ::cl::Event event;
         particle.value().manager().run_kernel(
-                kernel_, particle.size(), configure_.local_size());
+                kernel_, particle.size(), configure_.local_size(),
+                particle.value().event_wait_list(), &event,
+                !configure_.async());
+        particle.value().event(event);
         post_processor(iter, particle);
 
         return accept_count(particle, accept_buffer_.data());
@@ -668,16 +1555,14 @@ class MoveCL
     virtual void pre_processor (std::size_t, Particle<T> &) {}
     virtual void post_processor (std::size_t, Particle<T> &) {}
 
+    /// \brief The number of accepted moves
+    ///
+    /// \details
+    /// By default, the sum of the acceptance counts written by the kernel is
+    /// computed by StateCL::accept_count on the device
     virtual std::size_t accept_count (Particle<T> &particle,
             const ::cl::Buffer &accept_buffer)
-    {
-        particle.value().manager().read_buffer(
-                accept_buffer, particle.size(), &accept_host_[0]);
-
-        return static_cast<std::size_t>(std::accumulate(
-                    accept_host_.begin(), accept_host_.end(),
-                    static_cast< ::cl_ulong>(0)));
-    }
+    {return particle.value().accept_count(accept_buffer);}
 
     virtual void set_kernel (std::size_t iter, const Particle<T> &particle)
     {
@@ -689,19 +1574,15 @@ class MoveCL
     virtual void set_kernel_args (std::size_t iter,
             const Particle<T> &particle)
     {
-        accept_host_.resize(particle.size());
 #if VSMC_OPENCL_VERSION >= 120
         if (particle.value().manager().opencl_version() >= 120) {
             accept_buffer_.resize(particle.size(),
-                    CL_MEM_READ_WRITE|CL_MEM_HOST_READ_ONLY|
-                    CL_MEM_USE_HOST_PTR, &accept_host_[0]);
+                    CL_MEM_READ_WRITE|CL_MEM_HOST_READ_ONLY);
         } else {
-            accept_buffer_.resize(particle.size(),
-                    CL_MEM_READ_WRITE|CL_MEM_USE_HOST_PTR, &accept_host_[0]);
+            accept_buffer_.resize(particle.size());
         }
 #else
-        accept_buffer_.resize(particle.size(),
-                CL_MEM_READ_WRITE|CL_MEM_USE_HOST_PTR, &accept_host_[0]);
+        accept_buffer_.resize(particle.size());
 #endif
         cl_set_kernel_args(kernel_, 0, static_cast< ::cl_ulong>(iter),
                 particle.value().state_buffer().data(), accept_buffer_.data());
@@ -718,7 +1599,6 @@ class MoveCL
 
     VSMC_DEFINE_OPENCL_MEMBER_DATA;
     CLBuffer< ::cl_ulong, typename T::cl_id> accept_buffer_;
-    std::vector< ::cl_ulong> accept_host_;
 }; // class MoveCL
 
 /// \brief Monitor<T>::eval_type subtype using OpenCL
@@ -731,6 +1611,17 @@ class MoveCL
 /// void kern (ulong iter, ulong dim, __global state_type *state,
 ///            __global fp_type *res);
 /// ~~~
+/// - `res` has size `N * dim`, the results of the `i`th particle being
+/// `res[i * dim]`, ..., `res[i * dim + dim - 1]`.
+///
+/// As an evaluation object (Monitor::set_eval), all `N * dim` results are
+/// read by the host and the Monitor integrates them against the weights. As
+/// an integration object (Monitor::set_integrate), the results are instead
+/// integrated against the weights on the device by StateCL::integrate and
+/// only the `dim` estimates are read by the host. If `weight_set_type` is
+/// WeightSetCL with the same `fp_type`, its device buffer of weights is used
+/// directly. Otherwise the weights passed by the Monitor are written to the
+/// device before the integration.
 template <typename T, typename PlaceHolder = NullType>
 class MonitorEvalCL
 {
@@ -748,18 +1639,25 @@ class MonitorEvalCL
     {
         VSMC_STATIC_ASSERT_OPENCL_BACKEND_CL_STATE_CL_TYPE(T, MonitorEvalCL);
 
-        set_kernel(iter, dim, particle);
-        if (kernel_name_.empty())
+        if (!run(iter, dim, particle))
             return;
 
-        set_kernel_args(iter, dim, particle);
-        pre_processor(iter, particle);
-        particle.value().manager().run_kernel(
-                kernel_, particle.size(), configure_.local_size());
-        particle.value().manager().template
-            read_buffer<typename T::fp_type>(
-                    buffer_.data(), particle.value().size() * dim, res);
-        post_processor(iter, particle);
+        particle.value().manager().template read_buffer<typename T::fp_type>(
+                buffer_.data(), particle.value().size() * dim, res,
+                0, particle.value().event_wait_list());
+        particle.value().wait();
+    }
+
+    void operator() (std::size_t iter, std::size_t dim,
+            const Particle<T> &particle, const double *weight, double *res)
+    {
+        VSMC_STATIC_ASSERT_OPENCL_BACKEND_CL_STATE_CL_TYPE(T, MonitorEvalCL);
+
+        if (!run(iter, dim, particle))
+            return;
+
+        particle.value().integrate(dim, buffer_.data(),
+                weight_buffer(particle.weight_set(), weight), res);
     }
 
     virtual void monitor_state (std::size_t, std::string &) {}
@@ -803,6 +1701,42 @@ class MonitorEvalCL
 
     VSMC_DEFINE_OPENCL_MEMBER_DATA;
     CLBuffer<typename T::fp_type, typename T::cl_id> buffer_;
+    CLBuffer<typename T::fp_type, typename T::cl_id> weight_buffer_;
+
+    bool run (std::size_t iter, std::size_t dim, const Particle<T> &particle)
+    {
+        set_kernel(iter, dim, particle);
+        if (kernel_name_.empty())
+            return false;
+
+        set_kernel_args(iter, dim, particle);
+        pre_processor(iter, particle);
+        ::cl::Event event;
+        particle.value().manager().run_kernel(
+                kernel_, particle.size(), configure_.local_size(),
+                particle.value().event_wait_list(), &event,
+                !configure_.async());
+        particle.value().event(event);
+        post_processor(iter, particle);
+
+        return true;
+    }
+
+    const ::cl::Buffer &weight_buffer (
+            const WeightSetCL<typename T::fp_type, typename T::cl_id> &ws,
+            const double *)
+    {return ws.weight_buffer().data();}
+
+    template <typename WeightSetType>
+    const ::cl::Buffer &weight_buffer (const WeightSetType &ws,
+            const double *weight)
+    {
+        weight_buffer_.resize(ws.size(), CL_MEM_READ_ONLY);
+        weight_buffer_.manager().template write_buffer<
+            typename T::fp_type>(weight_buffer_.data(), ws.size(), weight);
+
+        return weight_buffer_.data();
+    }
 }; // class MonitorEvalCL
 
 /// \brief Path<T>::eval_type subtype using OpenCL
@@ -838,14 +1772,21 @@ class PathEvalCL
 
         set_kernel_args(iter, particle);
         pre_processor(iter, particle);
+        ::cl::Event event;
         particle.value().manager().run_kernel(
-                kernel_, particle.size(), configure_.local_size());
+                kernel_, particle.size(), configure_.local_size(),
+                particle.value().event_wait_list(), &event,
+                !configure_.async());
+        particle.value().event(event);
+        post_processor(iter, particle);
+        double grid = this->path_grid(iter, particle);
         particle.value().manager().template
             read_buffer<typename T::fp_type>(
-                    buffer_.data(), particle.value().size(), res);
-        post_processor(iter, particle);
+                    buffer_.data(), particle.value().size(), res,
+                    0, particle.value().event_wait_list());
+        particle.value().wait();
 
-        return this->path_grid(iter, particle);
+        return grid;
     }
 
     virtual void path_state (std::size_t, std::string &) {}
@@ -44,7 +44,7 @@ class CLConfigure
 {
     public :
 
-    CLConfigure () : local_size_(0) {}
+    CLConfigure () : local_size_(0), async_(false) {}
 
     std::size_t local_size () const {return local_size_;}
 
@@ -57,9 +57,21 @@ class CLConfigure
         cl_preferred_work_size(N, kern, dev, global_size, local_size_);
     }
 
+    /// \brief Whether kernels are enqueued without waiting for them
+    ///
+    /// \details
+    /// If `true`, commands are enqueued with the events of previous commands
+    /// as dependencies and the host waits only when it needs the results.
+    /// See StateCL::events
+    bool async () const {return async_;}
+
+    /// \brief Set whether kernels are enqueued without waiting for them
+    void async (bool flag) {async_ = flag;}
+
     private :
 
     std::size_t local_size_;
+    bool async_;
 }; // class CLConfigure
 
 } // namespace vsmc
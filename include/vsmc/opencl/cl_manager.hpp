@@ -39,6 +39,12 @@
 #include <vsmc/opencl/internal/cl_wrapper.hpp>
 #include <vsmc/utility/stop_watch.hpp>
 
+#if VSMC_HAS_POSIX
+#include <unistd.h>
+#elif defined(VSMC_MSVC)
+#include <process.h>
+#endif
+
 #define VSMC_RUNTIME_ASSERT_OPENCL_CL_MANAGER_SETUP(func) \
     VSMC_RUNTIME_ASSERT((setup()),                                           \
             ("**CLManager::"#func"** CAN ONLY BE CALLED AFTER TRUE "         \
@@ -66,6 +72,153 @@
 
 namespace vsmc {
 
+namespace internal {
+
+// The key of a program binary in the cache. It identifies the platform, the
+// device, the driver, the build flags and the source
+inline std::string cl_cache_key (const ::cl::Platform &plat,
+        const ::cl::Device &dev,
+        const std::string &source, const std::string &flags)
+{
+    std::string str;
+    std::stringstream ss;
+    plat.getInfo(CL_PLATFORM_NAME, &str);
+    ss << str << '\0';
+    plat.getInfo(CL_PLATFORM_VERSION, &str);
+    ss << str << '\0';
+    dev.getInfo(CL_DEVICE_VENDOR, &str);
+    ss << str << '\0';
+    dev.getInfo(CL_DEVICE_NAME, &str);
+    ss << str << '\0';
+    dev.getInfo(CL_DEVICE_VERSION, &str);
+    ss << str << '\0';
+    dev.getInfo(CL_DRIVER_VERSION, &str);
+    ss << str << '\0';
+    ss << flags << '\0' << source;
+
+    return ss.str();
+}
+
+// The file of a program binary in the cache, named by the 64-bit FNV-1a hash
+// of the key
+inline std::string cl_cache_file (const std::string &dir,
+        const std::string &key)
+{
+    ::cl_ulong hash = static_cast< ::cl_ulong>(14695981039346656037ULL);
+    for (std::size_t i = 0; i != key.size(); ++i) {
+        hash ^= static_cast< ::cl_ulong>(static_cast<unsigned char>(key[i]));
+        hash *= static_cast< ::cl_ulong>(1099511628211ULL);
+    }
+
+    std::stringstream ss;
+    ss << dir;
+    if (dir[dir.size() - 1] != '/' && dir[dir.size() - 1] != '\\')
+        ss << '/';
+    ss << "vsmc-" << std::hex << std::setw(16) << std::setfill('0') << hash;
+    ss << ".clbin";
+
+    return ss.str();
+}
+
+// A cache file contains the sizes of the key and the binary in the first
+// line, followed by the key and the binary. The key is checked upon reading
+// such that a collision of the hash is not an error.
+inline bool cl_cache_read (const std::string &file, const std::string &key,
+        std::string &binary)
+{
+    std::ifstream is(file.c_str(), std::ios_base::in|std::ios_base::binary);
+    if (!is)
+        return false;
+
+    std::size_t key_size = 0;
+    std::size_t binary_size = 0;
+    is >> key_size >> binary_size;
+    is.get();
+    if (!is || key_size != key.size() || binary_size == 0)
+        return false;
+
+    std::string k(key_size, '\0');
+    is.read(&k[0], static_cast<std::streamsize>(key_size));
+    if (!is || k != key)
+        return false;
+
+    binary.resize(binary_size);
+    is.read(&binary[0], static_cast<std::streamsize>(binary_size));
+
+    return !is.fail();
+}
+
+// The host name and the process id, which together distinguish the temporary
+// files of processes that write the same cache file at the same time, even
+// if they run on different hosts sharing the cache directory
+inline std::string cl_cache_process ()
+{
+    std::stringstream ss;
+#if VSMC_HAS_POSIX
+    char host[256] = {0};
+    if (::gethostname(host, sizeof(host) - 1) == 0)
+        ss << host << '.';
+    ss << static_cast<long>(::getpid());
+#elif defined(VSMC_MSVC)
+    const char *host = std::getenv("COMPUTERNAME");
+    if (host != VSMC_NULLPTR)
+        ss << host << '.';
+    ss << static_cast<long>(::_getpid());
+#else
+    ss << 0;
+#endif
+
+    return ss.str();
+}
+
+// The binary is written to a temporary file first, which is then renamed, so
+// that concurrent readers, such as other processes of the same job, never see
+// a partially written file. All errors are ignored.
+inline void cl_cache_write (const std::string &file, const std::string &key,
+        const std::string &binary)
+{
+    if (binary.size() == 0)
+        return;
+
+    std::stringstream ss;
+    ss << file << '.' << cl_cache_process() << ".tmp";
+    const std::string tmp(ss.str());
+
+    std::ofstream os(tmp.c_str(),
+            std::ios_base::out|std::ios_base::binary|std::ios_base::trunc);
+    if (!os)
+        return;
+
+    os << key.size() << ' ' << binary.size() << '\n';
+    os.write(key.data(), static_cast<std::streamsize>(key.size()));
+    os.write(binary.data(), static_cast<std::streamsize>(binary.size()));
+    os.close();
+    if (os.fail() || std::rename(tmp.c_str(), file.c_str()) != 0)
+        std::remove(tmp.c_str());
+}
+
+// The binaries of a built program and the devices they are built for
+inline void cl_program_binary (const ::cl::Program &program,
+        std::vector< ::cl::Device> &devices, std::vector<std::string> &binary)
+{
+    std::vector<std::size_t> binary_size;
+    program.getInfo(CL_PROGRAM_DEVICES, &devices);
+    program.getInfo(CL_PROGRAM_BINARY_SIZES, &binary_size);
+    binary.clear();
+    binary.resize(binary_size.size());
+    if (binary_size.size() == 0)
+        return;
+
+    std::vector<char *> ptr(binary_size.size());
+    for (std::size_t i = 0; i != binary_size.size(); ++i) {
+        binary[i].resize(binary_size[i]);
+        ptr[i] = binary_size[i] == 0 ? VSMC_NULLPTR : &binary[i][0];
+    }
+    program.getInfo(CL_PROGRAM_BINARIES, &ptr);
+}
+
+} // namespace vsmc::internal
+
 /// \brief OpenCL Manager
 /// \ingroup OpenCL
 ///
@@ -484,6 +637,77 @@ class CLManager
             ::cl::Program(context_, *devices, bin, status);
     }
 
+    /// \brief Create a program given the source and build it for all devices
+    /// in the current context
+    ///
+    /// \param program The program created. If the build fails, it can be
+    /// used to query the build log
+    /// \param source The source of the program
+    /// \param flags The OpenCL compiler flags
+    ///
+    /// \details
+    /// If the program binary cache is enabled (see CLSetup::cache_dir), then
+    /// the binaries are looked up in the cache directory first. Each binary
+    /// is identified by the source, the flags, the platform, the device and
+    /// the driver version. If the binaries for all devices are found, the
+    /// program is created from them and the compiler is not invoked.
+    /// Otherwise, or if the binaries fail to load, the program is built from
+    /// the source and its binaries (`CL_PROGRAM_BINARIES`) are stored in the
+    /// cache. Errors of reading and writing the cache are silently ignored.
+    /// Errors of building the program from the source are thrown as
+    /// `cl::Error` as usual.
+    ///
+    /// Note that all of the source is part of the key. For example, values
+    /// that change from run to run, such as seeds, shall be passed to the
+    /// kernels as arguments instead of macros in the source.
+    void build_program (::cl::Program &program, const std::string &source,
+            const std::string &flags = std::string()) const
+    {
+        VSMC_RUNTIME_ASSERT_OPENCL_CL_MANAGER_SETUP(build_program);
+
+        const std::string &dir = setup_default_.cache_dir();
+        if (dir.empty()) {
+            program = create_program(source);
+            program.build(device_vec_, flags.c_str());
+            return;
+        }
+
+        std::vector<std::string> key(device_vec_.size());
+        std::vector<std::string> binary(device_vec_.size());
+        bool cached = true;
+        try {
+            for (std::size_t i = 0; i != device_vec_.size(); ++i) {
+                key[i] = internal::cl_cache_key(
+                        platform_, device_vec_[i], source, flags);
+                if (!internal::cl_cache_read(
+                            internal::cl_cache_file(dir, key[i]),
+                            key[i], binary[i])) {
+                    cached = false;
+                }
+            }
+            if (cached) {
+                std::vector< ::cl_int> status;
+                program = create_program(binary, &device_vec_, &status);
+                program.build(device_vec_, flags.c_str());
+                return;
+            }
+        } catch (const ::cl::Error &) {}
+
+        program = create_program(source);
+        program.build(device_vec_, flags.c_str());
+
+        try {
+            std::vector< ::cl::Device> devices;
+            internal::cl_program_binary(program, devices, binary);
+            for (std::size_t i = 0; i != devices.size(); ++i) {
+                std::string k(internal::cl_cache_key(
+                            platform_, devices[i], source, flags));
+                internal::cl_cache_write(
+                        internal::cl_cache_file(dir, k), k, binary[i]);
+            }
+        } catch (const ::cl::Error &) {}
+    }
+
     private :
 
     struct profile_kernel_func_ {void operator() (::cl::Kernel &) const {}};
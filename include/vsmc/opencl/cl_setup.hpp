@@ -103,6 +103,26 @@ class CLSetup
     bool check_platform (const std::string &name) const
     {return check_name(name, platform_);}
 
+    /// \brief The directory of the program binary cache
+    ///
+    /// \details
+    /// By default, it is the value of the environment variable
+    /// `VSMC_OPENCL_CACHE_DIR` if it is set, otherwise an empty string. If it
+    /// is empty, the cache is disabled. See CLManager::build_program
+    const std::string &cache_dir () const {return cache_dir_;}
+
+    /// \brief Set the directory of the program binary cache
+    ///
+    /// \details
+    /// The directory shall exist and be writable. An empty string disables
+    /// the cache.
+    ///
+    /// With the cache enabled, the source built by StateCL::build does not
+    /// define the `SEED` macro, since otherwise the source, and thus the
+    /// cache key, would change with every seed. Kernels that use the cache
+    /// shall take the seed as an argument, for example `StateCL::seed()`.
+    void cache_dir (const std::string &dir) {cache_dir_ = dir;}
+
     private :
 
     ::cl_device_type device_type_;
@@ -110,10 +130,23 @@ class CLSetup
     std::string device_;
     std::string device_vendor_;
     std::string platform_;
+    std::string cache_dir_;
 
     CLSetup () :
         device_type_(CL_DEVICE_TYPE_DEFAULT), default_("vSMCOpenCLDefault"),
-        device_(default_), device_vendor_(default_), platform_(default_) {}
+        device_(default_), device_vendor_(default_), platform_(default_)
+    {
+#ifdef VSMC_MSVC
+#pragma warning(push)
+#pragma warning(disable:4996)
+#endif
+        const char *dir = std::getenv("VSMC_OPENCL_CACHE_DIR");
+#ifdef VSMC_MSVC
+#pragma warning(pop)
+#endif
+        if (dir)
+            cache_dir_ = dir;
+    }
 
     CLSetup (const CLSetup<ID> &);
     CLSetup<ID> &operator= (const CLSetup<ID> &);
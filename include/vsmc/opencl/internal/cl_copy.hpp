@@ -53,18 +53,23 @@ class CLCopy
 
     static manager_type &manager() { return manager_type::instance(); }
 
-    void operator()(const ::cl::Buffer &copy_from, const ::cl::Buffer &state)
+    void operator()(const ::cl::Buffer &copy_from, const ::cl::Buffer &state,
+        const std::vector< ::cl::Event> *events = VSMC_NULLPTR,
+        ::cl::Event *event = VSMC_NULLPTR, bool block = true)
     {
         cl_set_kernel_args(kernel_, 0, copy_from, state);
-        manager().run_kernel(kernel_, size_, configure_.local_size());
+        manager().run_kernel(
+            kernel_, size_, configure_.local_size(), events, event, block);
     }
 
     void operator()(const ::cl::Buffer &idx, const ::cl::Buffer &tmp,
-        const ::cl::Buffer &state)
+        const ::cl::Buffer &state,
+        const std::vector< ::cl::Event> *events = VSMC_NULLPTR,
+        ::cl::Event *event = VSMC_NULLPTR, bool block = true)
     {
         cl_set_kernel_args(kernel_post_, 0, idx, tmp, state);
-        manager().run_kernel(
-            kernel_post_, size_, configure_post_.local_size());
+        manager().run_kernel(kernel_post_, size_,
+            configure_post_.local_size(), events, event, block);
     }
 
     void build(std::size_t size, std::size_t state_size)
@@ -95,8 +100,7 @@ class CLCopy
         ss << "    if (idx[id] != 0) state[id] = tmp[id];\n";
         ss << "}\n";
 
-        program_ = manager().create_program(ss.str());
-        program_.build(manager().device_vec());
+        manager().build_program(program_, ss.str());
         kernel_ = ::cl::Kernel(program_, "copy");
         kernel_post_ = ::cl::Kernel(program_, "copy_post");
         configure_.local_size(size, kernel_, manager().device());
@@ -48,10 +48,117 @@
 #define VSMC_RESAMPLE_RNG_TYPE ::vsmc::Threefry4x64
 #endif
 
+/// \brief Number of weights in each block of cumulative sums in resampling
+/// algorithms
+/// \ingroup Config
+#ifndef VSMC_RESAMPLE_BLOCK_SIZE
+#define VSMC_RESAMPLE_BLOCK_SIZE 4096
+#endif
+
 namespace vsmc {
 
 namespace internal {
 
+// Cumulative sums of weights are computed in blocks of
+// VSMC_RESAMPLE_BLOCK_SIZE weights. Weights are summed sequentially within
+// each block, and the sum of all weights before a block is the sequential sum
+// of the totals of the blocks before it. Parallel implementations, which
+// compute the totals of blocks independently, thus produce results identical
+// to the sequential ones.
+
+inline std::size_t resample_block_num (std::size_t M)
+{return (M + VSMC_RESAMPLE_BLOCK_SIZE - 1) / VSMC_RESAMPLE_BLOCK_SIZE;}
+
+inline std::size_t resample_block_size (std::size_t M, std::size_t b)
+{
+    const std::size_t f = b * VSMC_RESAMPLE_BLOCK_SIZE;
+
+    return M - f < VSMC_RESAMPLE_BLOCK_SIZE ?
+        M - f : VSMC_RESAMPLE_BLOCK_SIZE;
+}
+
+inline double resample_block_sum (std::size_t n, const double *weight)
+{
+    double sum = 0;
+    for (std::size_t i = 0; i != n; ++i)
+        sum += weight[i];
+
+    return sum;
+}
+
+inline double resample_sum (std::size_t M, const double *weight)
+{
+    const std::size_t B = resample_block_num(M);
+    double sum = 0;
+    for (std::size_t b = 0; b != B; ++b) {
+        sum += resample_block_sum(resample_block_size(M, b),
+                weight + b * VSMC_RESAMPLE_BLOCK_SIZE);
+    }
+
+    return sum;
+}
+
+inline double resample_max (std::size_t M, const double *weight)
+{
+    double wmax = 0;
+    for (std::size_t i = 0; i != M; ++i)
+        if (wmax < weight[i])
+            wmax = weight[i];
+
+    return wmax;
+}
+
+// The engine of new particles in block b of schemes that draw blocks
+// independently. All blocks share the key, seed, and block b sets the most
+// significant word of the counter to b. Thus the streams of blocks are
+// disjoint and do not depend on how blocks are assigned to threads
+typedef Threefry4x64 ResampleBlockRng;
+
+inline void resample_block_rng (ResampleBlockRng &rng, uint64_t seed,
+        std::size_t b)
+{
+    rng.seed(seed);
+    ResampleBlockRng::ctr_type ctr;
+    ctr.fill(0);
+    ctr.back() = static_cast<uint64_t>(b);
+    rng.ctr(ctr);
+}
+
+// Given N ancestors, compute M replication numbers
+template <typename IntType>
+inline void resample_count (std::size_t M, std::size_t N,
+        const std::size_t *ancestor, IntType *replication)
+{
+    std::memset(replication, 0, sizeof(IntType) * M);
+    for (std::size_t i = 0; i != N; ++i)
+        ++replication[ancestor[i]];
+}
+
+// Compute replication numbers of a block of n weights, given the sum of all
+// weights before it, offset, and the number of the N U01 random variates less
+// than or equal to it, k. On return, offset is the sum of all weights up to
+// the end of the block and the new number of such variates is returned
+template <typename IntType, typename U01SeqType>
+inline std::size_t inversion_block (std::size_t n, std::size_t N,
+        const double *weight, double &offset, U01SeqType &u01seq,
+        std::size_t k, IntType *replication)
+{
+    double accw = 0;
+    for (std::size_t i = 0; i != n; ++i) {
+        accw += weight[i];
+        const double w = offset + accw;
+        IntType r = 0;
+        while (k != N && u01seq[k] <= w) {
+            ++r;
+            ++k;
+        }
+        replication[i] = r;
+    }
+    offset += accw;
+
+    return k;
+}
+
 // Given N sorted U01 random variates
 // Compute M replication numbers based on M weights
 template <typename IntType, typename U01SeqType>
@@ -66,21 +173,37 @@ inline void inversion (std::size_t M, std::size_t N,
         return;
     }
 
-    std::memset(replication, 0, sizeof(IntType) * M);
-
-    if (N == 0)
+    if (N == 0) {
+        std::memset(replication, 0, sizeof(IntType) * M);
         return;
+    }
 
+    const std::size_t B = resample_block_num(M - 1);
     std::size_t n = 0;
-    double accw = 0;
-    for (std::size_t i = 0; i != M - 1; ++i) {
-        accw += weight[i];
-        while (n != N && u01seq[n] <= accw) {
-            ++replication[i];
-            ++n;
-        }
+    double offset = 0;
+    for (std::size_t b = 0; b != B; ++b) {
+        const std::size_t f = b * VSMC_RESAMPLE_BLOCK_SIZE;
+        n = inversion_block(resample_block_size(M - 1, b), N, weight + f,
+                offset, u01seq, n, replication + f);
     }
-    replication[M - 1] = N - n;
+    replication[M - 1] = static_cast<IntType>(N - n);
+}
+
+// Given U01SequenceSorted, generate the whole sequence into u01 first
+template <typename IntType, typename RngType>
+inline void inversion (std::size_t M, std::size_t N, const double *weight,
+        U01SequenceSorted<RngType> &u01seq, IntType *replication,
+        std::vector<double, AlignedAllocator<double> > &u01)
+{
+    if (M < 2 || N == 0) {
+        inversion(M, N, weight, u01seq, replication);
+        return;
+    }
+
+    u01.resize(N);
+    u01seq.generate(&u01[0]);
+    const double *const u = &u01[0];
+    inversion(M, N, weight, u, replication);
 }
 
 // Given replication numbers, transfer them to copy_from index
@@ -127,7 +250,9 @@ enum ResampleScheme {
     Stratified,         ///< Stratified resampling
     Systematic,         ///< Systematic resampling
     ResidualStratified, ///< Stratified resampling on residuals
-    ResidualSystematic  ///< Systematic resampling on residuals
+    ResidualSystematic, ///< Systematic resampling on residuals
+    Metropolis,         ///< Metropolis resampling
+    Rejection           ///< Rejection resampling
 }; // enum ResampleScheme
 
 /// \brief Resample forward decleration
@@ -147,6 +272,16 @@ namespace traits {
 VSMC_DEFINE_TYPE_DISPATCH_TRAIT(ResampleRngType, resample_rng_type,
         VSMC_RESAMPLE_RNG_TYPE)
 
+/// \brief Particle::resample_local_type trait
+/// \ingroup Traits
+///
+/// \details
+/// If the type is `cxx11::true_type`, then the value collection type
+/// computes replication numbers of its own particles and copies them itself.
+/// See Particle::resample and StateMPI::resample_copy.
+VSMC_DEFINE_TYPE_DISPATCH_TRAIT(ResampleLocalType, resample_local_type,
+        cxx11::false_type)
+
 } // namespace vsmc::traits
 
 } // namespace vsmc
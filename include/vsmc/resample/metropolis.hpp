@@ -0,0 +1,143 @@
+//============================================================================
+// vSMC/include/vsmc/resample/metropolis.hpp
+//----------------------------------------------------------------------------
+//                         vSMC: Scalable Monte Carlo
+//----------------------------------------------------------------------------
+// Copyright (c) 2013-2015, Yan Zhou
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//   Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+//   Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//============================================================================
+
+
+#ifndef VSMC_RESAMPLE_METROPOLIS_HPP
+#define VSMC_RESAMPLE_METROPOLIS_HPP
+
+#include <vsmc/resample/common.hpp>
+
+/// \brief Bound of the bias of Metropolis resampling
+/// \ingroup Config
+#ifndef VSMC_RESAMPLE_METROPOLIS_EPSILON
+#define VSMC_RESAMPLE_METROPOLIS_EPSILON 0.01
+#endif
+
+namespace vsmc {
+
+namespace internal {
+
+typedef cxx11::integral_constant<ResampleScheme, Metropolis>
+    ResampleMetropolis;
+
+// The number of steps B such that (1 - beta)^B <= epsilon, where beta is the
+// ratio of the average weight to the maximum
+inline std::size_t resample_metropolis_steps (std::size_t M, double wsum,
+        double wmax)
+{
+    using std::ceil;
+    using std::log;
+
+    const double beta = wsum / (M * wmax);
+    if (!(beta < 1))
+        return 0;
+
+    return static_cast<std::size_t>(ceil(
+                log(VSMC_RESAMPLE_METROPOLIS_EPSILON) / cxx11::log1p(-beta)));
+}
+
+// Ancestors of new particles in block b, drawn from the stream of block b
+// (see resample_block_rng). Each new particle i starts from old particle
+// i % M, and at each step moves to a uniformly chosen j with probability
+// min(1, w[j] / w[k])
+inline void resample_metropolis (std::size_t M, std::size_t N,
+        std::size_t b, uint64_t seed, std::size_t steps,
+        const double *weight, std::size_t *ancestor)
+{
+    ResampleBlockRng rng;
+    resample_block_rng(rng, seed, b);
+    cxx11::uniform_int_distribution<std::size_t> rindex(0, M - 1);
+    cxx11::uniform_real_distribution<double> runif(0, 1);
+    const std::size_t f = b * VSMC_RESAMPLE_BLOCK_SIZE;
+    const std::size_t l = f + resample_block_size(N, b);
+    for (std::size_t i = f; i != l; ++i) {
+        std::size_t k = i % M;
+        for (std::size_t s = 0; s != steps; ++s) {
+            const std::size_t j = rindex(rng);
+            if (runif(rng) * weight[k] < weight[j])
+                k = j;
+        }
+        ancestor[i] = k;
+    }
+}
+
+} // namespace vsmc::internal
+
+/// \brief Metropolis resampling
+/// \ingroup Resample
+///
+/// \details
+/// Each new particle is the result of a Metropolis chain over the old
+/// particles, with uniform proposals and the weights as the target (Murray,
+/// Lee and Jacob, 2016). It needs only ratios of pairs of weights, besides the
+/// maximum and the sum of the weights to determine the number of steps, and
+/// no cumulative sums. The results are biased, and the number of steps `B`
+/// is chosen such that \f$(1 - \beta)^B \le \epsilon\f$, where \f$\beta\f$
+/// is the ratio of the average weight to the maximum and \f$\epsilon\f$ is
+/// `VSMC_RESAMPLE_METROPOLIS_EPSILON`. Thus the cost grows as the weights
+/// become degenerate. New particles are processed in blocks of
+/// `VSMC_RESAMPLE_BLOCK_SIZE`. One number drawn from `rng` is the key of a
+/// `Threefry4x64` engine, and each block draws from its own range of the
+/// counter.
+template <>
+class Resample<internal::ResampleMetropolis>
+{
+    public :
+
+    template <typename IntType, typename RngType>
+    void operator() (std::size_t M, std::size_t N, RngType &rng,
+            const double *weight, IntType *replication)
+    {
+        if (M == 0)
+            return;
+
+        const std::size_t steps = internal::resample_metropolis_steps(M,
+                internal::resample_sum(M, weight),
+                internal::resample_max(M, weight));
+        const uint64_t seed = static_cast<uint64_t>(rng());
+        ancestor_.resize(N);
+        std::size_t *const aptr = N == 0 ? VSMC_NULLPTR : &ancestor_[0];
+        const std::size_t B = internal::resample_block_num(N);
+        for (std::size_t b = 0; b != B; ++b) {
+            internal::resample_metropolis(M, N, b, seed, steps,
+                    weight, aptr);
+        }
+        internal::resample_count(M, N, aptr, replication);
+    }
+
+    private :
+
+    std::vector<std::size_t> ancestor_;
+}; // Metropolis resampling
+
+} // namespace vsmc
+
+#endif // VSMC_RESAMPLE_METROPOLIS_HPP
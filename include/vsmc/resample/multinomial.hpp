@@ -55,8 +55,12 @@ class Resample<internal::ResampleMultinomial>
             const double *weight, IntType *replication)
     {
         U01SequenceSorted<RngType> u01seq(N, rng);
-        internal::inversion(M, N, weight, u01seq, replication);
+        internal::inversion(M, N, weight, u01seq, replication, u01_);
     }
+
+    private :
+
+    std::vector<double, AlignedAllocator<double> > u01_;
 }; // Mulitnomial resampling
 
 } // namespace vsmc
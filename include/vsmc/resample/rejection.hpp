@@ -0,0 +1,130 @@
+//============================================================================
+// vSMC/include/vsmc/resample/rejection.hpp
+//----------------------------------------------------------------------------
+//                         vSMC: Scalable Monte Carlo
+//----------------------------------------------------------------------------
+// Copyright (c) 2013-2015, Yan Zhou
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//   Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+//   Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//============================================================================
+
+
+#ifndef VSMC_RESAMPLE_REJECTION_HPP
+#define VSMC_RESAMPLE_REJECTION_HPP
+
+#include <vsmc/resample/common.hpp>
+
+#define VSMC_RUNTIME_ASSERT_RESAMPLE_REJECTION_MAX(wmax) \
+    VSMC_RUNTIME_ASSERT((wmax > 0 &&                                         \
+                wmax < std::numeric_limits<double>::infinity()),             \
+            ("**Resample<Rejection>** "                                      \
+             "THE MAXIMUM OF WEIGHTS IS NOT POSITIVE AND FINITE"))
+
+namespace vsmc {
+
+namespace internal {
+
+typedef cxx11::integral_constant<ResampleScheme, Rejection>
+    ResampleRejection;
+
+// Ancestors of new particles in block b, drawn from the stream of block b
+// (see resample_block_rng). Each new particle i proposes old particle i % M
+// first, and then uniformly chosen ones, until one is accepted with
+// probability w[j] / wmax. If wmax is not positive and finite, which happens
+// if all weights are zero or NaN, or some are infinite, no proposal can be
+// accepted. In this case each new particle keeps its first proposal, as if
+// all weights were equal
+inline void resample_rejection (std::size_t M, std::size_t N,
+        std::size_t b, uint64_t seed, double wmax,
+        const double *weight, std::size_t *ancestor)
+{
+    VSMC_RUNTIME_ASSERT_RESAMPLE_REJECTION_MAX(wmax);
+
+    const std::size_t f = b * VSMC_RESAMPLE_BLOCK_SIZE;
+    const std::size_t l = f + resample_block_size(N, b);
+    if (!(wmax > 0 && wmax < std::numeric_limits<double>::infinity())) {
+        for (std::size_t i = f; i != l; ++i)
+            ancestor[i] = i % M;
+        return;
+    }
+
+    ResampleBlockRng rng;
+    resample_block_rng(rng, seed, b);
+    cxx11::uniform_int_distribution<std::size_t> rindex(0, M - 1);
+    cxx11::uniform_real_distribution<double> runif(0, 1);
+    for (std::size_t i = f; i != l; ++i) {
+        std::size_t j = i % M;
+        while (!(runif(rng) * wmax < weight[j]))
+            j = rindex(rng);
+        ancestor[i] = j;
+    }
+}
+
+} // namespace vsmc::internal
+
+/// \brief Rejection resampling
+/// \ingroup Resample
+///
+/// \details
+/// Each new particle is drawn by rejection sampling over the old particles,
+/// with uniform proposals and the maximum weight as the bound (Murray, Lee
+/// and Jacob, 2016). It needs only the maximum of the weights and no
+/// cumulative sums. The results are unbiased, while the expected number of
+/// proposals of each new particle is the ratio of the maximum weight to the
+/// average. The maximum weight shall be positive and finite. New particles
+/// are processed in blocks of `VSMC_RESAMPLE_BLOCK_SIZE`. One number drawn
+/// from `rng` is the key of a `Threefry4x64` engine, and each block draws
+/// from its own range of the counter.
+template <>
+class Resample<internal::ResampleRejection>
+{
+    public :
+
+    template <typename IntType, typename RngType>
+    void operator() (std::size_t M, std::size_t N, RngType &rng,
+            const double *weight, IntType *replication)
+    {
+        if (M == 0)
+            return;
+
+        const double wmax = internal::resample_max(M, weight);
+        const uint64_t seed = static_cast<uint64_t>(rng());
+        ancestor_.resize(N);
+        std::size_t *const aptr = N == 0 ? VSMC_NULLPTR : &ancestor_[0];
+        const std::size_t B = internal::resample_block_num(N);
+        for (std::size_t b = 0; b != B; ++b) {
+            internal::resample_rejection(M, N, b, seed, wmax,
+                    weight, aptr);
+        }
+        internal::resample_count(M, N, aptr, replication);
+    }
+
+    private :
+
+    std::vector<std::size_t> ancestor_;
+}; // Rejection resampling
+
+} // namespace vsmc
+
+#endif // VSMC_RESAMPLE_REJECTION_HPP
@@ -40,5 +40,7 @@
 #include <vsmc/resample/systematic.hpp>
 #include <vsmc/resample/residual_stratified.hpp>
 #include <vsmc/resample/residual_systematic.hpp>
+#include <vsmc/resample/metropolis.hpp>
+#include <vsmc/resample/rejection.hpp>
 
 #endif // VSMC_RESAMPLE_RESAMPLE_HPP
@@ -62,7 +62,7 @@ class Resample<internal::ResampleResidual>
         double *const iptr = &integral_[0];
         for (std::size_t i = 0; i != M; ++i)
             rptr[i] = modf(N * weight[i], iptr + i);
-        double coeff = 1 / math::asum(M, rptr);
+        double coeff = 1 / internal::resample_sum(M, rptr);
         math::scal(M, coeff, rptr);
 
         IntType R = 0;
@@ -70,7 +70,7 @@ class Resample<internal::ResampleResidual>
             R += static_cast<IntType>(iptr[i]);
         std::size_t NN = N - static_cast<std::size_t>(R);
         U01SequenceSorted<RngType> u01seq(NN, rng);
-        internal::inversion(M, NN, rptr, u01seq, replication);
+        internal::inversion(M, NN, rptr, u01seq, replication, u01_);
 
         for (std::size_t i = 0; i != M; ++i)
             replication[i] += static_cast<IntType>(iptr[i]);
@@ -80,6 +80,7 @@ class Resample<internal::ResampleResidual>
 
     std::vector<double, AlignedAllocator<double> > residual_;
     std::vector<double, AlignedAllocator<double> > integral_;
+    std::vector<double, AlignedAllocator<double> > u01_;
 }; // Residual resampling
 
 } // namespace vsmc
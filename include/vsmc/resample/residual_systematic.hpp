@@ -62,7 +62,7 @@ class Resample<internal::ResampleResidualSystematic>
         double *const iptr = &integral_[0];
         for (std::size_t i = 0; i != M; ++i)
             rptr[i] = modf(N * weight[i], iptr + i);
-        double coeff = 1 / math::asum(M, rptr);
+        double coeff = 1 / internal::resample_sum(M, rptr);
         math::scal(M, coeff, rptr);
 
         IntType R = 0;
@@ -43,6 +43,14 @@ namespace vsmc {
 
 /// \brief Draw a single sample given weights
 /// \ingroup Distribution
+///
+/// \details
+/// When the weights are set, through the constructors or `param`, an alias
+/// table is built with Vose's algorithm in O(K) time, where K is the number
+/// of categories. Each draw with the stored weights, `operator()(eng)` or
+/// `generate`, then costs O(1) time and one uniform random number,
+/// regardless of K. The overload of `operator()` with external weights
+/// does not use the table.
 template <typename IntType = int>
 class DiscreteDistribution
 {
@@ -127,7 +135,28 @@ class DiscreteDistribution
 
     template <typename URNG>
     result_type operator() (URNG &eng) const
-    {return operator()(eng, param_.begin(), param_.end(), true);}
+    {
+        if (param_.size() == 0)
+            return 0;
+
+        cxx11::uniform_real_distribution<double> runif(0, 1);
+
+        return alias_draw(runif(eng));
+    }
+
+    /// \brief Draw `n` samples with the alias table
+    template <typename URNG>
+    void generate (URNG &eng, std::size_t n, result_type *r) const
+    {
+        if (param_.size() == 0) {
+            std::fill_n(r, n, static_cast<result_type>(0));
+            return;
+        }
+
+        cxx11::uniform_real_distribution<double> runif(0, 1);
+        for (std::size_t i = 0; i != n; ++i)
+            r[i] = alias_draw(runif(eng));
+    }
 
     /// \brief Draw sample with external probabilities
     ///
@@ -146,7 +175,10 @@ class DiscreteDistribution
     /// distribution is implementation defined and cannot be used to write
     /// portable code), which will lead to uncessary
     /// dynamic memory allocation. This function does not use dynamic memory
-    /// and improve performance for normalized weights.
+    /// and improve performance for normalized weights. Unnormalized weights
+    /// are not normalized either. Instead, the uniform random number is
+    /// scaled by their sum. Each draw costs O(N) time. For many draws with
+    /// the same weights, set them with `param` and use the alias table.
     template <typename URNG, typename InputIter>
     result_type operator() (URNG &eng, InputIter first, InputIter last,
             bool normalized = false) const
@@ -157,21 +189,8 @@ class DiscreteDistribution
         cxx11::uniform_real_distribution<value_type> runif(0, 1);
         value_type u = runif(eng);
 
-        if (!normalized) {
-            value_type mulw = 1 / std::accumulate(first, last,
-                    static_cast<value_type>(0));
-            value_type accw = 0;
-            result_type index = 0;
-            while (first != last) {
-                accw += *first * mulw;
-                if (u <= accw)
-                    return index;
-                ++first;
-                ++index;
-            }
-
-            return index - 1;
-        }
+        if (!normalized)
+            u *= std::accumulate(first, last, static_cast<value_type>(0));
 
         value_type accw = 0;
         result_type index = 0;
@@ -251,14 +270,75 @@ class DiscreteDistribution
     private :
 
     param_type param_;
+    std::vector<double> alias_prob_;
+    std::vector<std::size_t> alias_index_;
 
     void normalize ()
     {
-        if (param_.size() == 0)
+        if (param_.size() == 0) {
+            alias_prob_.clear();
+            alias_index_.clear();
             return;
+        }
 
         double sumw = std::accumulate(param_.begin(), param_.end(), 0.0);
         math::scal(param_.size(), 1 / sumw, &param_[0]);
+        alias_table();
+    }
+
+    // Vose's algorithm. Categories with probabilities below and above the
+    // average are kept at the front and the back of the same work vector.
+    // Each slot i is split between category i, with probability
+    // alias_prob_[i], and category alias_index_[i]
+    void alias_table ()
+    {
+        const std::size_t K = param_.size();
+        alias_prob_.resize(K);
+        alias_index_.resize(K);
+        std::vector<std::size_t> work(K);
+        std::size_t ns = 0;
+        std::size_t nl = K;
+        for (std::size_t i = 0; i != K; ++i) {
+            alias_prob_[i] = param_[i] * static_cast<double>(K);
+            alias_index_[i] = i;
+            if (alias_prob_[i] < 1)
+                work[ns++] = i;
+            else
+                work[--nl] = i;
+        }
+
+        while (ns != 0 && nl != K) {
+            const std::size_t below = work[--ns];
+            const std::size_t above = work[nl];
+            alias_index_[below] = above;
+            alias_prob_[above] = (alias_prob_[above] + alias_prob_[below]) - 1;
+            if (alias_prob_[above] < 1) {
+                ++nl;
+                work[ns++] = above;
+            }
+        }
+
+        // Remaining categories have probabilities equal to the average up to
+        // rounding errors
+        for (std::size_t i = 0; i != ns; ++i)
+            alias_prob_[work[i]] = 1;
+        for (std::size_t i = nl; i != K; ++i)
+            alias_prob_[work[i]] = 1;
+    }
+
+    // The integer part of u * K selects the slot and the fractional part
+    // selects between the category and its alias
+    result_type alias_draw (double u) const
+    {
+        const std::size_t K = alias_prob_.size();
+        const double x = u * static_cast<double>(K);
+        std::size_t i = static_cast<std::size_t>(x);
+        if (i >= K)
+            i = K - 1;
+        const double f = x - static_cast<double>(i);
+
+        return static_cast<result_type>(
+                f < alias_prob_[i] ? i : alias_index_[i]);
     }
 
     bool is_positive (const param_type &param)
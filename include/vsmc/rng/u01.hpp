@@ -162,6 +162,10 @@ VSMC_DEFINE_RNG_U01(double, Open, Open, open, open, 64, 53)
 /// last time it is called.
 /// - `n` can only be either `0`, `nlast`, or `nlast + 1`
 /// - `n` can be at most `N - 1`.
+///
+/// Alternatively, when the whole sequence is needed, `generate` writes it to
+/// a buffer in one pass, with the transcendental functions computed by the
+/// vectorized `math::vLn` and `math::vExp`.
 template <typename RngType>
 class U01SequenceSorted
 {
@@ -191,6 +195,37 @@ class U01SequenceSorted
 
     double operator() (std::size_t n) {return operator[](n);}
 
+    /// \brief Generate the whole sequence
+    ///
+    /// \details
+    /// The results are the same as setting `u[n] = operator[](n)` for `n` in
+    /// `[0, N)`, up to the accuracy of `math::vLn` and `math::vExp`. It
+    /// always draws `N` random variates, while a caller of `operator[]` may
+    /// stop before `N - 1` and leave the RNG in a different state. It shall
+    /// be called before `operator[]`, after which only `N - 1` is a valid
+    /// argument of the latter.
+    void generate (double *u)
+    {
+        if (N_ == 0)
+            return;
+
+        for (std::size_t n = 0; n != N_; ++n)
+            u[n] = 1 - runif_(rng_);
+        math::vLn(N_, u, u);
+        double lmax = 0;
+        for (std::size_t n = 0; n != N_; ++n) {
+            lmax += u[n] / (N_ - n);
+            u[n] = lmax;
+        }
+        math::vExp(N_, u, u);
+        for (std::size_t n = 0; n != N_; ++n)
+            u[n] = 1 - u[n];
+
+        n_ = N_ - 1;
+        u_ = u[n_];
+        lmax_ = lmax;
+    }
+
     private :
 
     std::size_t N_;
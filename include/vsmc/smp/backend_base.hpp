@@ -72,6 +72,92 @@ Name##Impl<T, Derived> &operator= (const Name##Impl<T, Derived> &other)      \
 
 namespace vsmc {
 
+namespace internal {
+
+// The b-th of n blocks of [0, N) with nearly equal sizes
+template <typename SizeType>
+inline void backend_block_range (SizeType N, SizeType n, SizeType b,
+        SizeType &first, SizeType &last)
+{
+    const SizeType m = N / n;
+    const SizeType r = N % n;
+    first = b * m + (b < r ? b : r);
+    last = first + m + (b < r ? 1 : 0);
+}
+
+// Number of blocks of [0, N) for backends with dynamic scheduling, a few for
+// each worker such that the load can still be balanced
+template <typename SizeType>
+inline SizeType backend_block_num (SizeType N, SizeType worker)
+{
+    const SizeType n = (worker > 1 ? worker : 1) * 8;
+
+    return n < N ? n : N;
+}
+
+// Copying particles of states which have double_buffer(), copy_gather and
+// swap_buffer, such as StateMatrix, by gathering them into the back buffer
+template <typename T>
+class ParallelCopyBuffer
+{
+    struct char2 {char c1; char c2;};
+    template <std::size_t> struct sfinae_;
+    template <typename U>
+    static char test (sfinae_<sizeof(&U::swap_buffer)> *);
+    template <typename U> static char2 test (...);
+
+    public :
+
+    static VSMC_CONSTEXPR const bool value =
+        sizeof(test<T>(VSMC_NULLPTR)) == sizeof(char);
+
+    static bool gather (const T *state)
+    {return gather(state, cxx11::integral_constant<bool, value>());}
+
+    template <typename SizeType, typename IntType>
+    static void copy (T *state, SizeType first, SizeType last,
+            const IntType *copy_from)
+    {
+        copy(state, first, last, copy_from,
+                cxx11::integral_constant<bool, value>());
+    }
+
+    // Swap the buffers if the particles have been gathered
+    static void swap (T *state)
+    {swap(state, cxx11::integral_constant<bool, value>());}
+
+    private :
+
+    static bool gather (const T *state, cxx11::true_type)
+    {return state->double_buffer();}
+
+    static bool gather (const T *, cxx11::false_type) {return false;}
+
+    template <typename SizeType, typename IntType>
+    static void copy (T *state, SizeType first, SizeType last,
+            const IntType *copy_from, cxx11::true_type)
+    {
+        typedef typename traits::SizeTypeTrait<T>::type size_type;
+
+        state->copy_gather(static_cast<size_type>(first),
+                static_cast<size_type>(last), copy_from);
+    }
+
+    template <typename SizeType, typename IntType>
+    static void copy (T *, SizeType, SizeType, const IntType *,
+            cxx11::false_type) {}
+
+    static void swap (T *state, cxx11::true_type)
+    {
+        if (state->double_buffer())
+            state->swap_buffer();
+    }
+
+    static void swap (T *, cxx11::false_type) {}
+}; // class ParallelCopyBuffer
+
+} // namespace vsmc::internal
+
 /// \brief Initialize base dispatch class
 /// \ingroup SMP
 template <typename T, typename Derived>
@@ -79,9 +165,20 @@ class InitializeBase
 {
     public :
 
+    typedef typename traits::SizeTypeTrait<T>::type size_type;
+
     std::size_t initialize_state (SingleParticle<T> sp)
     {return initialize_state_dispatch(sp, &Derived::initialize_state);}
 
+    /// \brief Initialize particles with id in `[first, last)`, by default
+    /// calling `initialize_state` on each of them
+    std::size_t initialize_range (size_type first, size_type last,
+            Particle<T> &particle)
+    {
+        return initialize_range_dispatch(first, last, particle,
+                &Derived::initialize_range);
+    }
+
     void initialize_param (Particle<T> &particle, void *param)
     {initialize_param_dispatch(particle, param, &Derived::initialize_param);}
 
@@ -104,6 +201,15 @@ class InitializeBase
             std::size_t (D::*) (SingleParticle<T>))
     {return static_cast<Derived *>(this)->initialize_state(sp);}
 
+    template <typename D>
+    std::size_t initialize_range_dispatch (size_type first, size_type last,
+            Particle<T> &particle,
+            std::size_t (D::*) (size_type, size_type, Particle<T> &))
+    {
+        return static_cast<Derived *>(this)->initialize_range(
+                first, last, particle);
+    }
+
     template <typename D>
     void initialize_param_dispatch (Particle<T> &particle, void *param,
             void (D::*) (Particle<T> &, void *))
@@ -126,6 +232,15 @@ class InitializeBase
             std::size_t (D::*) (SingleParticle<T>) const)
     {return static_cast<Derived *>(this)->initialize_state(sp);}
 
+    template <typename D>
+    std::size_t initialize_range_dispatch (size_type first, size_type last,
+            Particle<T> &particle,
+            std::size_t (D::*) (size_type, size_type, Particle<T> &) const)
+    {
+        return static_cast<Derived *>(this)->initialize_range(
+                first, last, particle);
+    }
+
     template <typename D>
     void initialize_param_dispatch (Particle<T> &particle, void *param,
             void (D::*) (Particle<T> &, void *) const)
@@ -147,6 +262,11 @@ class InitializeBase
             std::size_t (*) (SingleParticle<T>))
     {return Derived::initialize_state(sp);}
 
+    std::size_t initialize_range_dispatch (size_type first, size_type last,
+            Particle<T> &particle,
+            std::size_t (*) (size_type, size_type, Particle<T> &))
+    {return Derived::initialize_range(first, last, particle);}
+
     void initialize_param_dispatch (Particle<T> &particle, void *param,
             void (*) (Particle<T> &, void *))
     {Derived::initialize_param(particle, param);}
@@ -165,6 +285,18 @@ class InitializeBase
             std::size_t (InitializeBase::*) (SingleParticle<T>))
     {return 0;}
 
+    std::size_t initialize_range_dispatch (size_type first, size_type last,
+            Particle<T> &particle,
+            std::size_t (InitializeBase::*) (
+                size_type, size_type, Particle<T> &))
+    {
+        std::size_t accept = 0;
+        for (size_type i = first; i != last; ++i)
+            accept += initialize_state(SingleParticle<T>(i, &particle));
+
+        return accept;
+    }
+
     void initialize_param_dispatch (Particle<T> &, void *,
             void (InitializeBase::*) (Particle<T> &, void *)) {}
 
@@ -182,11 +314,23 @@ class InitializeBase<T, Virtual>
 {
     public :
 
+    typedef typename traits::SizeTypeTrait<T>::type size_type;
+
     virtual std::size_t initialize_state (SingleParticle<T>) {return 0;}
     virtual void initialize_param (Particle<T> &, void *) {}
     virtual void pre_processor (Particle<T> &) {}
     virtual void post_processor (Particle<T> &) {}
 
+    virtual std::size_t initialize_range (size_type first, size_type last,
+            Particle<T> &particle)
+    {
+        std::size_t accept = 0;
+        for (size_type i = first; i != last; ++i)
+            accept += initialize_state(SingleParticle<T>(i, &particle));
+
+        return accept;
+    }
+
     protected :
 
     VSMC_DEFINE_SMP_BASE_COPY_VIRTUAL(Initialize)
@@ -199,9 +343,20 @@ class MoveBase
 {
     public :
 
+    typedef typename traits::SizeTypeTrait<T>::type size_type;
+
     std::size_t move_state (std::size_t iter, SingleParticle<T> sp)
     {return move_state_dispatch(iter, sp, &Derived::move_state);}
 
+    /// \brief Move particles with id in `[first, last)`, by default calling
+    /// `move_state` on each of them
+    std::size_t move_range (std::size_t iter, size_type first,
+            size_type last, Particle<T> &particle)
+    {
+        return move_range_dispatch(iter, first, last, particle,
+                &Derived::move_range);
+    }
+
     void pre_processor (std::size_t iter, Particle<T> &particle)
     {pre_processor_dispatch(iter, particle, &Derived::pre_processor);}
 
@@ -221,6 +376,16 @@ class MoveBase
             std::size_t (D::*) (std::size_t, SingleParticle<T>))
     {return static_cast<Derived *>(this)->move_state(iter, sp);}
 
+    template <typename D>
+    std::size_t move_range_dispatch (std::size_t iter, size_type first,
+            size_type last, Particle<T> &particle,
+            std::size_t (D::*) (std::size_t, size_type, size_type,
+                Particle<T> &))
+    {
+        return static_cast<Derived *>(this)->move_range(
+                iter, first, last, particle);
+    }
+
     template <typename D>
     void pre_processor_dispatch (std::size_t iter, Particle<T> &particle,
             void (D::*) (std::size_t, Particle<T> &))
@@ -238,6 +403,16 @@ class MoveBase
             std::size_t (D::*) (std::size_t, SingleParticle<T>) const)
     {return static_cast<Derived *>(this)->move_state(iter, sp);}
 
+    template <typename D>
+    std::size_t move_range_dispatch (std::size_t iter, size_type first,
+            size_type last, Particle<T> &particle,
+            std::size_t (D::*) (std::size_t, size_type, size_type,
+                Particle<T> &) const)
+    {
+        return static_cast<Derived *>(this)->move_range(
+                iter, first, last, particle);
+    }
+
     template <typename D>
     void pre_processor_dispatch (std::size_t iter, Particle<T> &particle,
             void (D::*) (std::size_t, Particle<T> &) const)
@@ -254,6 +429,12 @@ class MoveBase
             std::size_t (*) (std::size_t, SingleParticle<T>))
     {return Derived::move_state(iter, sp);}
 
+    std::size_t move_range_dispatch (std::size_t iter, size_type first,
+            size_type last, Particle<T> &particle,
+            std::size_t (*) (std::size_t, size_type, size_type,
+                Particle<T> &))
+    {return Derived::move_range(iter, first, last, particle);}
+
     void pre_processor_dispatch (std::size_t iter, Particle<T> &particle,
             void (*) (std::size_t, Particle<T> &))
     {Derived::pre_processor(iter, particle);}
@@ -268,6 +449,18 @@ class MoveBase
             std::size_t (MoveBase::*) (std::size_t, SingleParticle<T>))
     {return 0;}
 
+    std::size_t move_range_dispatch (std::size_t iter, size_type first,
+            size_type last, Particle<T> &particle,
+            std::size_t (MoveBase::*) (std::size_t, size_type, size_type,
+                Particle<T> &))
+    {
+        std::size_t accept = 0;
+        for (size_type i = first; i != last; ++i)
+            accept += move_state(iter, SingleParticle<T>(i, &particle));
+
+        return accept;
+    }
+
     void pre_processor_dispatch (std::size_t, Particle<T> &,
             void (MoveBase::*) (std::size_t, Particle<T> &)) {}
 
@@ -282,10 +475,22 @@ class MoveBase<T, Virtual>
 {
     public :
 
+    typedef typename traits::SizeTypeTrait<T>::type size_type;
+
     virtual std::size_t move_state (std::size_t, SingleParticle<T>) {return 0;}
     virtual void pre_processor (std::size_t, Particle<T> &) {}
     virtual void post_processor (std::size_t, Particle<T> &) {}
 
+    virtual std::size_t move_range (std::size_t iter, size_type first,
+            size_type last, Particle<T> &particle)
+    {
+        std::size_t accept = 0;
+        for (size_type i = first; i != last; ++i)
+            accept += move_state(iter, SingleParticle<T>(i, &particle));
+
+        return accept;
+    }
+
     protected :
 
     VSMC_DEFINE_SMP_BASE_COPY_VIRTUAL(Move)
@@ -298,10 +503,26 @@ class MonitorEvalBase
 {
     public :
 
+    typedef typename traits::SizeTypeTrait<T>::type size_type;
+
     void monitor_state (std::size_t iter, std::size_t dim,
             ConstSingleParticle<T> csp, double *res)
     {monitor_state_dispatch(iter, dim, csp, res, &Derived::monitor_state);}
 
+    /// \brief Evaluate particles with id in `[first, last)`, by default
+    /// calling `monitor_state` on each of them
+    ///
+    /// \details
+    /// `res` points to the results of particle `first`, that is, the results
+    /// of particle `i` are written to `res + (i - first) * dim`.
+    void monitor_range (std::size_t iter, std::size_t dim,
+            size_type first, size_type last, const Particle<T> &particle,
+            double *res)
+    {
+        monitor_range_dispatch(iter, dim, first, last, particle, res,
+                &Derived::monitor_range);
+    }
+
     void pre_processor (std::size_t iter, const Particle<T> &particle)
     {pre_processor_dispatch(iter, particle, &Derived::pre_processor);}
 
@@ -323,6 +544,17 @@ class MonitorEvalBase
                 double *))
     {static_cast<Derived *>(this)->monitor_state(iter, dim, csp, res);}
 
+    template <typename D>
+    void monitor_range_dispatch (std::size_t iter, std::size_t dim,
+            size_type first, size_type last, const Particle<T> &particle,
+            double *res,
+            void (D::*) (std::size_t, std::size_t, size_type, size_type,
+                const Particle<T> &, double *))
+    {
+        static_cast<Derived *>(this)->monitor_range(
+                iter, dim, first, last, particle, res);
+    }
+
     template <typename D>
     void pre_processor_dispatch (std::size_t iter,
             const Particle<T> &particle,
@@ -344,6 +576,17 @@ class MonitorEvalBase
                 double *) const)
     {static_cast<Derived *>(this)->monitor_state(iter, dim, csp, res);}
 
+    template <typename D>
+    void monitor_range_dispatch (std::size_t iter, std::size_t dim,
+            size_type first, size_type last, const Particle<T> &particle,
+            double *res,
+            void (D::*) (std::size_t, std::size_t, size_type, size_type,
+                const Particle<T> &, double *) const)
+    {
+        static_cast<Derived *>(this)->monitor_range(
+                iter, dim, first, last, particle, res);
+    }
+
     template <typename D>
     void pre_processor_dispatch (std::size_t iter,
             const Particle<T> &particle,
@@ -364,6 +607,13 @@ class MonitorEvalBase
                 double *))
     {Derived::monitor_state(iter, dim, csp, res);}
 
+    void monitor_range_dispatch (std::size_t iter, std::size_t dim,
+            size_type first, size_type last, const Particle<T> &particle,
+            double *res,
+            void (*) (std::size_t, std::size_t, size_type, size_type,
+                const Particle<T> &, double *))
+    {Derived::monitor_range(iter, dim, first, last, particle, res);}
+
     void pre_processor_dispatch (std::size_t iter,
             const Particle<T> &particle,
             void (*) (std::size_t, const Particle<T> &))
@@ -381,6 +631,18 @@ class MonitorEvalBase
             void (MonitorEvalBase::*)
             (std::size_t, std::size_t, ConstSingleParticle<T>, double *)) {}
 
+    void monitor_range_dispatch (std::size_t iter, std::size_t dim,
+            size_type first, size_type last, const Particle<T> &particle,
+            double *res,
+            void (MonitorEvalBase::*) (std::size_t, std::size_t,
+                size_type, size_type, const Particle<T> &, double *))
+    {
+        for (size_type i = first; i != last; ++i, res += dim) {
+            monitor_state(iter, dim,
+                    ConstSingleParticle<T>(i, &particle), res);
+        }
+    }
+
     void pre_processor_dispatch (std::size_t, const Particle<T> &,
             void (MonitorEvalBase::*) (std::size_t, const Particle<T> &)) {}
 
@@ -395,11 +657,23 @@ class MonitorEvalBase<T, Virtual>
 {
     public :
 
+    typedef typename traits::SizeTypeTrait<T>::type size_type;
+
     virtual void monitor_state (std::size_t, std::size_t,
             ConstSingleParticle<T>, double *) {}
     virtual void pre_processor (std::size_t, const Particle<T> &) {}
     virtual void post_processor (std::size_t, const Particle<T> &) {}
 
+    virtual void monitor_range (std::size_t iter, std::size_t dim,
+            size_type first, size_type last, const Particle<T> &particle,
+            double *res)
+    {
+        for (size_type i = first; i != last; ++i, res += dim) {
+            monitor_state(iter, dim,
+                    ConstSingleParticle<T>(i, &particle), res);
+        }
+    }
+
     protected :
 
     VSMC_DEFINE_SMP_BASE_COPY_VIRTUAL(MonitorEval)
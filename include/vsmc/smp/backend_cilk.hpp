@@ -33,6 +33,10 @@
 #define VSMC_SMP_BACKEND_CILK_HPP
 
 #include <vsmc/smp/backend_base.hpp>
+#include <vsmc/smp/internal/parallel_resample.hpp>
+#include <vsmc/smp/internal/parallel_weight.hpp>
+#include <vsmc/smp/internal/parallel_work.hpp>
+#include <vsmc/thread/blocked_range.hpp>
 #include <cilk/cilk.h>
 #include <cilk/cilk_api.h>
 #include <cilk/reducer_opadd.h>
@@ -57,11 +61,77 @@ class StateCILK : public BaseState
     {
         VSMC_RUNTIME_ASSERT_SMP_BACKEND_BASE_COPY_SIZE_MISMATCH(CILK);
 
-        cilk_for (size_type to = 0; to != N; ++to)
-            this->copy_particle(copy_from[to], to);
+        // Each block of particles is copied at once, such that a gather into
+        // the back buffer issues one store fence per block instead of one
+        // per particle
+        internal::ParallelCopyParticle<StateCILK<BaseState>, IntType> work(
+                this, copy_from);
+        const size_type n = internal::backend_block_num(N,
+                static_cast<size_type>(__cilkrts_get_nworkers()));
+        cilk_for (size_type b = 0; b != n; ++b) {
+            size_type first = 0;
+            size_type last = 0;
+            internal::backend_block_range(N, n, b, first, last);
+            work(BlockedRange<size_type>(first, last));
+        }
+        work.finish();
     }
 }; // class StateCILK
 
+/// \brief Particle::weight_set_type subtype using Intel Cilk Plus
+/// \ingroup CILK
+///
+/// \details
+/// Weight operations are parallelized over blocks of weights. Reductions are
+/// combined in block order and the results do not depend on the number of
+/// threads. To use it, define `weight_set_type` in the value type of
+/// Particle, for example,
+/// ~~~{.cpp}
+/// typedef WeightSetCILK<> weight_set_type;
+/// ~~~
+template <typename WeightSetBase = WeightSet>
+class WeightSetCILK : public internal::WeightSetSMP<
+    WeightSetBase, WeightSetCILK<WeightSetBase> >
+{
+    public :
+
+    typedef typename WeightSetBase::size_type size_type;
+
+    explicit WeightSetCILK (size_type N) : internal::WeightSetSMP<
+        WeightSetBase, WeightSetCILK<WeightSetBase> >(N) {}
+
+    template <typename WorkType>
+    void parallel_run (std::size_t n, const WorkType &work) const
+    {
+        cilk_for (std::size_t b = 0; b != n; ++b)
+            work(b);
+    }
+}; // class WeightSetCILK
+
+/// \brief Resampling algorithms using Intel Cilk Plus
+/// \ingroup CILK
+///
+/// \details
+/// Cumulative sums of weights and replication numbers are computed in
+/// parallel over blocks of weights. The results are identical to those of
+/// `Resample` with the same state of the RNG. To use it, for example,
+/// ~~~{.cpp}
+/// sampler.resample_scheme(ResampleCILK<Systematic>());
+/// ~~~
+template <ResampleScheme Scheme>
+class ResampleCILK : public internal::ResampleSMP<
+    Scheme, ResampleCILK<Scheme> >
+{
+    public :
+
+    template <typename WorkType>
+    void parallel_run (std::size_t n, const WorkType &work) const
+    {
+        cilk_for (std::size_t b = 0; b != n; ++b)
+            work(b);
+    }
+}; // class ResampleCILK
+
 /// \brief Sampler<T>::init_type subtype using Intel Cilk Plus
 /// \ingroup CILK
 template <typename T, typename Derived>
@@ -76,8 +146,14 @@ class InitializeCILK : public InitializeBase<T, Derived>
         this->initialize_param(particle, param);
         this->pre_processor(particle);
         cilk::reducer_opadd<std::size_t> accept;
-        cilk_for (size_type i = 0; i != N; ++i)
-            accept += this->initialize_state(SingleParticle<T>(i, &particle));
+        const size_type n = internal::backend_block_num(N,
+                static_cast<size_type>(__cilkrts_get_nworkers()));
+        cilk_for (size_type b = 0; b != n; ++b) {
+            size_type first = 0;
+            size_type last = 0;
+            internal::backend_block_range(N, n, b, first, last);
+            accept += this->initialize_range(first, last, particle);
+        }
         this->post_processor(particle);
 
         return accept.get_value();
@@ -101,8 +177,14 @@ class MoveCILK : public MoveBase<T, Derived>
         const size_type N = static_cast<size_type>(particle.size());
         this->pre_processor(iter, particle);
         cilk::reducer_opadd<std::size_t> accept;
-        cilk_for (size_type i = 0; i != N; ++i)
-            accept += this->move_state(iter, SingleParticle<T>(i, &particle));
+        const size_type n = internal::backend_block_num(N,
+                static_cast<size_type>(__cilkrts_get_nworkers()));
+        cilk_for (size_type b = 0; b != n; ++b) {
+            size_type first = 0;
+            size_type last = 0;
+            internal::backend_block_range(N, n, b, first, last);
+            accept += this->move_range(iter, first, last, particle);
+        }
         this->post_processor(iter, particle);
 
         return accept.get_value();
@@ -126,13 +208,31 @@ class MonitorEvalCILK : public MonitorEvalBase<T, Derived>
         typedef typename Particle<T>::size_type size_type;
         const size_type N = static_cast<size_type>(particle.size());
         this->pre_processor(iter, particle);
-        cilk_for (size_type i = 0; i != N; ++i) {
-            this->monitor_state(iter, dim,
-                    ConstSingleParticle<T>(i, &particle), res + i * dim);
+        const size_type n = internal::backend_block_num(N,
+                static_cast<size_type>(__cilkrts_get_nworkers()));
+        cilk_for (size_type b = 0; b != n; ++b) {
+            size_type first = 0;
+            size_type last = 0;
+            internal::backend_block_range(N, n, b, first, last);
+            this->monitor_range(iter, dim, first, last, particle,
+                    res + first * dim);
         }
         this->post_processor(iter, particle);
     }
 
+    void operator() (std::size_t iter, std::size_t dim,
+            const Particle<T> &particle, const double *weight, double *res)
+    {
+        this->pre_processor(iter, particle);
+        std::vector<double, AlignedAllocator<double> > partial;
+        internal::ParallelMonitorIntegrate<T, MonitorEvalCILK<T, Derived> >
+            work(this, iter, dim, &particle, weight, partial);
+        cilk_for (std::size_t b = 0; b != work.num(); ++b)
+            work(b);
+        work.finish(res);
+        this->post_processor(iter, particle);
+    }
+
     protected :
 
     VSMC_DEFINE_SMP_IMPL_COPY(CILK, MonitorEval)
@@ -33,12 +33,28 @@
 #define VSMC_SMP_BACKEND_GCD_HPP
 
 #include <vsmc/smp/backend_base.hpp>
+#include <vsmc/smp/internal/parallel_resample.hpp>
+#include <vsmc/smp/internal/parallel_weight.hpp>
+#include <vsmc/smp/internal/parallel_work.hpp>
 #include <vsmc/gcd/gcd.hpp>
+#include <unistd.h>
 
 namespace vsmc {
 
 VSMC_DEFINE_SMP_FORWARD(GCD)
 
+namespace internal {
+
+template <typename SizeType>
+inline SizeType backend_gcd_block_num (SizeType N)
+{
+    long ncpu = ::sysconf(_SC_NPROCESSORS_ONLN);
+
+    return backend_block_num(N, static_cast<SizeType>(ncpu > 0 ? ncpu : 1));
+}
+
+} // namespace vsmc::internal
+
 /// \brief Particle::value_type subtype usingt Apple Grand Central Dispatch
 /// \ingroup GCD
 template <typename BaseState>
@@ -51,6 +67,74 @@ class StateGCD : public BaseState
     explicit StateGCD (size_type N) : BaseState(N) {}
 }; // class StateGCD
 
+/// \brief Particle::weight_set_type subtype using Apple Grand Central Dispatch
+/// \ingroup GCD
+///
+/// \details
+/// Weight operations are parallelized over blocks of weights. Reductions are
+/// combined in block order and the results do not depend on the number of
+/// threads. To use it, define `weight_set_type` in the value type of
+/// Particle, for example,
+/// ~~~{.cpp}
+/// typedef WeightSetGCD<> weight_set_type;
+/// ~~~
+template <typename WeightSetBase = WeightSet>
+class WeightSetGCD : public internal::WeightSetSMP<
+    WeightSetBase, WeightSetGCD<WeightSetBase> >
+{
+    public :
+
+    typedef typename WeightSetBase::size_type size_type;
+
+    explicit WeightSetGCD (size_type N) : internal::WeightSetSMP<
+        WeightSetBase, WeightSetGCD<WeightSetBase> >(N) {}
+
+    template <typename WorkType>
+    void parallel_run (std::size_t n, const WorkType &work) const
+    {
+        DispatchQueue<DispatchGlobal> queue;
+        queue.apply_f(n, const_cast<void *>(static_cast<const void *>(&work)),
+                gcd_work_<WorkType>);
+    }
+
+    private :
+
+    template <typename WorkType>
+    static void gcd_work_ (void *work, std::size_t b)
+    {(*static_cast<const WorkType *>(work))(b);}
+}; // class WeightSetGCD
+
+/// \brief Resampling algorithms using Apple Grand Central Dispatch
+/// \ingroup GCD
+///
+/// \details
+/// Cumulative sums of weights and replication numbers are computed in
+/// parallel over blocks of weights. The results are identical to those of
+/// `Resample` with the same state of the RNG. To use it, for example,
+/// ~~~{.cpp}
+/// sampler.resample_scheme(ResampleGCD<Systematic>());
+/// ~~~
+template <ResampleScheme Scheme>
+class ResampleGCD : public internal::ResampleSMP<
+    Scheme, ResampleGCD<Scheme> >
+{
+    public :
+
+    template <typename WorkType>
+    void parallel_run (std::size_t n, const WorkType &work) const
+    {
+        DispatchQueue<DispatchGlobal> queue;
+        queue.apply_f(n, const_cast<void *>(static_cast<const void *>(&work)),
+                gcd_work_<WorkType>);
+    }
+
+    private :
+
+    template <typename WorkType>
+    static void gcd_work_ (void *work, std::size_t b)
+    {(*static_cast<const WorkType *>(work))(b);}
+}; // class ResampleGCD
+
 /// \brief Sampler<T>::init_type subtype usingt Apple Grand Central Dispatch
 /// \ingroup GCD
 template <typename T, typename Derived>
@@ -64,14 +148,15 @@ class InitializeGCD : public InitializeBase<T, Derived>
         const size_type N = static_cast<size_type>(particle.size());
         this->initialize_param(particle, param);
         this->pre_processor(particle);
-        accept_.resize(N);
-        work_param_ wp(this, &particle, &accept_[0]);
-        queue_.apply_f(N, &wp, work_);
+        const size_type n = internal::backend_gcd_block_num(N);
+        accept_.resize(n);
+        work_param_ wp(this, &particle, &accept_[0], N, n);
+        queue_.apply_f(n, &wp, work_);
         this->post_processor(particle);
 
         std::size_t acc = 0;
-        for (size_type i = 0; i != N; ++i)
-            acc += accept_[i];
+        for (size_type b = 0; b != n; ++b)
+            acc += accept_[b];
 
         return acc;
     }
@@ -87,21 +172,30 @@ class InitializeGCD : public InitializeBase<T, Derived>
 
     struct work_param_
     {
+        typedef typename Particle<T>::size_type size_type;
+
         work_param_ (InitializeGCD<T, Derived> *dptr, Particle<T> *pptr,
-                std::size_t *aptr) :
-            dispatcher(dptr), particle(pptr), accept(aptr) {}
+                std::size_t *aptr, size_type size, size_type bnum) :
+            dispatcher(dptr), particle(pptr), accept(aptr),
+            N(size), n(bnum) {}
 
         InitializeGCD<T, Derived> *const dispatcher;
         Particle<T> *const particle;
         std::size_t *const accept;
+        size_type N;
+        size_type n;
     };
 
-    static void work_ (void *wp, std::size_t i)
+    static void work_ (void *wp, std::size_t b)
     {
         typedef typename Particle<T>::size_type size_type;
         const work_param_ *const wptr = static_cast<const work_param_ *>(wp);
-        wptr->accept[i] = wptr->dispatcher->initialize_state(
-                SingleParticle<T>(static_cast<size_type>(i), wptr->particle));
+        size_type first = 0;
+        size_type last = 0;
+        internal::backend_block_range(wptr->N, wptr->n,
+                static_cast<size_type>(b), first, last);
+        wptr->accept[b] = wptr->dispatcher->initialize_range(
+                first, last, *wptr->particle);
     }
 }; // class InitializeGCD
 
@@ -117,14 +211,15 @@ class MoveGCD : public MoveBase<T, Derived>
         typedef typename Particle<T>::size_type size_type;
         const size_type N = static_cast<size_type>(particle.size());
         this->pre_processor(iter, particle);
-        accept_.resize(N);
-        work_param_ wp(this, &particle, &accept_[0], iter);
-        queue_.apply_f(N, &wp, work_);
+        const size_type n = internal::backend_gcd_block_num(N);
+        accept_.resize(n);
+        work_param_ wp(this, &particle, &accept_[0], iter, N, n);
+        queue_.apply_f(n, &wp, work_);
         this->post_processor(iter, particle);
 
         std::size_t acc = 0;
-        for (size_type i = 0; i != N; ++i)
-            acc += accept_[i];
+        for (size_type b = 0; b != n; ++b)
+            acc += accept_[b];
 
         return acc;
     }
@@ -140,22 +235,32 @@ class MoveGCD : public MoveBase<T, Derived>
 
     struct work_param_
     {
+        typedef typename Particle<T>::size_type size_type;
+
         work_param_ (MoveGCD<T, Derived> *dptr, Particle<T> *pptr,
-                std::size_t *aptr, std::size_t i) :
-            dispatcher(dptr), particle(pptr), accept(aptr), iter(i) {}
+                std::size_t *aptr, std::size_t i,
+                size_type size, size_type bnum) :
+            dispatcher(dptr), particle(pptr), accept(aptr), iter(i),
+            N(size), n(bnum) {}
 
         MoveGCD<T, Derived> *const dispatcher;
         Particle<T> *const particle;
         std::size_t *const accept;
         std::size_t iter;
+        size_type N;
+        size_type n;
     };
 
-    static void work_ (void *wp, std::size_t i)
+    static void work_ (void *wp, std::size_t b)
     {
         typedef typename Particle<T>::size_type size_type;
         const work_param_ *const wptr = static_cast<const work_param_ *>(wp);
-        wptr->accept[i] = wptr->dispatcher->move_state(wptr->iter,
-                SingleParticle<T>(static_cast<size_type>(i), wptr->particle));
+        size_type first = 0;
+        size_type last = 0;
+        internal::backend_block_range(wptr->N, wptr->n,
+                static_cast<size_type>(b), first, last);
+        wptr->accept[b] = wptr->dispatcher->move_range(wptr->iter,
+                first, last, *wptr->particle);
     }
 }; // class MoveGCD
 
@@ -172,8 +277,21 @@ class MonitorEvalGCD : public MonitorEvalBase<T, Derived>
         typedef typename Particle<T>::size_type size_type;
         const size_type N = static_cast<size_type>(particle.size());
         this->pre_processor(iter, particle);
-        work_param_ wp(this, &particle, res, iter, dim);
-        queue_.apply_f(N, &wp, work_);
+        const size_type n = internal::backend_gcd_block_num(N);
+        work_param_ wp(this, &particle, res, iter, dim, N, n);
+        queue_.apply_f(n, &wp, work_);
+        this->post_processor(iter, particle);
+    }
+
+    void operator() (std::size_t iter, std::size_t dim,
+            const Particle<T> &particle, const double *weight, double *res)
+    {
+        this->pre_processor(iter, particle);
+        std::vector<double, AlignedAllocator<double> > partial;
+        internal::ParallelMonitorIntegrate<T, MonitorEvalGCD<T, Derived> >
+            work(this, iter, dim, &particle, weight, partial);
+        queue_.apply_f(work.num(), &work, integrate_work_);
+        work.finish(res);
         this->post_processor(iter, particle);
     }
 
@@ -187,25 +305,40 @@ class MonitorEvalGCD : public MonitorEvalBase<T, Derived>
 
     struct work_param_
     {
+        typedef typename Particle<T>::size_type size_type;
+
         work_param_ (MonitorEvalGCD<T, Derived> *dptr, const Particle<T> *pptr,
-                double *rptr, std::size_t i, std::size_t d) :
-            dispatcher(dptr), particle(pptr), res(rptr), iter(i), dim(d) {}
+                double *rptr, std::size_t i, std::size_t d,
+                size_type size, size_type bnum) :
+            dispatcher(dptr), particle(pptr), res(rptr), iter(i), dim(d),
+            N(size), n(bnum) {}
 
         MonitorEvalGCD<T, Derived> *const dispatcher;
         const Particle<T> *const particle;
         double *const res;
         std::size_t iter;
         std::size_t dim;
+        size_type N;
+        size_type n;
     };
 
-    static void work_ (void *wp, std::size_t i)
+    static void work_ (void *wp, std::size_t b)
     {
         typedef typename Particle<T>::size_type size_type;
         const work_param_ *const wptr = static_cast<const work_param_ *>(wp);
-        wptr->dispatcher->monitor_state(wptr->iter, wptr->dim,
-                ConstSingleParticle<T>(
-                    static_cast<size_type>(i), wptr->particle),
-                wptr->res + i * wptr->dim);
+        size_type first = 0;
+        size_type last = 0;
+        internal::backend_block_range(wptr->N, wptr->n,
+                static_cast<size_type>(b), first, last);
+        wptr->dispatcher->monitor_range(wptr->iter, wptr->dim,
+                first, last, *wptr->particle,
+                wptr->res + static_cast<std::size_t>(first) * wptr->dim);
+    }
+
+    static void integrate_work_ (void *work, std::size_t b)
+    {
+        (*static_cast<const internal::ParallelMonitorIntegrate<
+         T, MonitorEvalGCD<T, Derived> > *>(work))(b);
     }
 }; // class MonitorEvalGCD
 
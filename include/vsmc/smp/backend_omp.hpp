@@ -33,12 +33,29 @@
 #define VSMC_SMP_BACKEND_OMP_HPP
 
 #include <vsmc/smp/backend_base.hpp>
+#include <vsmc/smp/internal/parallel_resample.hpp>
+#include <vsmc/smp/internal/parallel_weight.hpp>
+#include <vsmc/smp/internal/parallel_work.hpp>
+#include <vsmc/thread/blocked_range.hpp>
 #include <omp.h>
 
 namespace vsmc {
 
 VSMC_DEFINE_SMP_FORWARD(OMP)
 
+namespace internal {
+
+// The share of the calling thread within a parallel region
+template <typename SizeType>
+inline void backend_omp_range (SizeType N, SizeType &first, SizeType &last)
+{
+    backend_block_range(N,
+            static_cast<SizeType>(omp_get_num_threads()),
+            static_cast<SizeType>(omp_get_thread_num()), first, last);
+}
+
+} // namespace vsmc::internal
+
 /// \brief Particle::value_type subtype using OpenMP
 /// \ingroup OMP
 template <typename BaseState>
@@ -60,12 +77,83 @@ class StateOMP : public BaseState
     {
         VSMC_RUNTIME_ASSERT_SMP_BACKEND_BASE_COPY_SIZE_MISMATCH(OMP);
 
-#pragma omp parallel for default(shared)
-        for (size_type to = 0; to < N; ++to)
-            this->copy_particle(copy_from[to], to);
+        // Each thread copies a contiguous range of particles at once, such
+        // that a gather into the back buffer issues one store fence per
+        // thread instead of one per particle
+        internal::ParallelCopyParticle<StateOMP<BaseState>, IntType> work(
+                this, copy_from);
+#pragma omp parallel default(shared)
+        {
+            size_type first = 0;
+            size_type last = 0;
+            internal::backend_omp_range(N, first, last);
+            if (first < last)
+                work(BlockedRange<size_type>(first, last));
+        }
+        work.finish();
     }
 }; // class StateOMP
 
+/// \brief Particle::weight_set_type subtype using OpenMP
+/// \ingroup OMP
+///
+/// \details
+/// Weight operations are parallelized over blocks of weights. Reductions are
+/// combined in block order and the results do not depend on the number of
+/// threads. To use it, define `weight_set_type` in the value type of
+/// Particle, for example,
+/// ~~~{.cpp}
+/// typedef WeightSetOMP<> weight_set_type;
+/// ~~~
+template <typename WeightSetBase = WeightSet>
+class WeightSetOMP : public internal::WeightSetSMP<
+    WeightSetBase, WeightSetOMP<WeightSetBase> >
+{
+    public :
+
+    typedef typename WeightSetBase::size_type size_type;
+
+    explicit WeightSetOMP (size_type N) : internal::WeightSetSMP<
+        WeightSetBase, WeightSetOMP<WeightSetBase> >(N) {}
+
+    template <typename WorkType>
+    void parallel_run (std::size_t n, const WorkType &work) const
+    {
+        typedef traits::OMPSizeTypeTrait<std::size_t>::type omp_size_type;
+        const omp_size_type m = static_cast<omp_size_type>(n);
+#pragma omp parallel for default(shared)
+        for (omp_size_type b = 0; b < m; ++b)
+            work(static_cast<std::size_t>(b));
+    }
+}; // class WeightSetOMP
+
+/// \brief Resampling algorithms using OpenMP
+/// \ingroup OMP
+///
+/// \details
+/// Cumulative sums of weights and replication numbers are computed in
+/// parallel over blocks of weights. The results are identical to those of
+/// `Resample` with the same state of the RNG. To use it, for example,
+/// ~~~{.cpp}
+/// sampler.resample_scheme(ResampleOMP<Systematic>());
+/// ~~~
+template <ResampleScheme Scheme>
+class ResampleOMP : public internal::ResampleSMP<
+    Scheme, ResampleOMP<Scheme> >
+{
+    public :
+
+    template <typename WorkType>
+    void parallel_run (std::size_t n, const WorkType &work) const
+    {
+        typedef traits::OMPSizeTypeTrait<std::size_t>::type omp_size_type;
+        const omp_size_type m = static_cast<omp_size_type>(n);
+#pragma omp parallel for default(shared)
+        for (omp_size_type b = 0; b < m; ++b)
+            work(static_cast<std::size_t>(b));
+    }
+}; // class ResampleOMP
+
 /// \brief Sampler<T>::init_type subtype using OpenMP
 /// \ingroup OMP
 template <typename T, typename Derived>
@@ -81,9 +169,14 @@ class InitializeOMP : public InitializeBase<T, Derived>
         this->initialize_param(particle, param);
         this->pre_processor(particle);
         std::size_t accept = 0;
-#pragma omp parallel for reduction(+ : accept) default(shared)
-        for (size_type i = 0; i < N; ++i)
-            accept += this->initialize_state(SingleParticle<T>(i, &particle));
+#pragma omp parallel reduction(+ : accept) default(shared)
+        {
+            size_type first = 0;
+            size_type last = 0;
+            internal::backend_omp_range(N, first, last);
+            if (first < last)
+                accept += this->initialize_range(first, last, particle);
+        }
         this->post_processor(particle);
 
         return accept;
@@ -108,9 +201,14 @@ class MoveOMP : public MoveBase<T, Derived>
         const size_type N = static_cast<size_type>(particle.size());
         this->pre_processor(iter, particle);
         std::size_t accept = 0;
-#pragma omp parallel for reduction(+ : accept) default(shared)
-        for (size_type i = 0; i < N; ++i)
-            accept += this->move_state(iter, SingleParticle<T>(i, &particle));
+#pragma omp parallel reduction(+ : accept) default(shared)
+        {
+            size_type first = 0;
+            size_type last = 0;
+            internal::backend_omp_range(N, first, last);
+            if (first < last)
+                accept += this->move_range(iter, first, last, particle);
+        }
         this->post_processor(iter, particle);
 
         return accept;
@@ -135,14 +233,35 @@ class MonitorEvalOMP : public MonitorEvalBase<T, Derived>
             typename Particle<T>::size_type>::type size_type;
         const size_type N = static_cast<size_type>(particle.size());
         this->pre_processor(iter, particle);
-#pragma omp parallel for default(shared)
-        for (size_type i = 0; i < N; ++i) {
-            this->monitor_state(iter, dim,
-                    ConstSingleParticle<T>(i, &particle), res + i * dim);
+#pragma omp parallel default(shared)
+        {
+            size_type first = 0;
+            size_type last = 0;
+            internal::backend_omp_range(N, first, last);
+            if (first < last) {
+                this->monitor_range(iter, dim, first, last, particle,
+                        res + first * dim);
+            }
         }
         this->post_processor(iter, particle);
     }
 
+    void operator() (std::size_t iter, std::size_t dim,
+            const Particle<T> &particle, const double *weight, double *res)
+    {
+        typedef traits::OMPSizeTypeTrait<std::size_t>::type omp_size_type;
+        this->pre_processor(iter, particle);
+        std::vector<double, AlignedAllocator<double> > partial;
+        internal::ParallelMonitorIntegrate<T, MonitorEvalOMP<T, Derived> >
+            work(this, iter, dim, &particle, weight, partial);
+        const omp_size_type n = static_cast<omp_size_type>(work.num());
+#pragma omp parallel for default(shared)
+        for (omp_size_type b = 0; b < n; ++b)
+            work(static_cast<std::size_t>(b));
+        work.finish(res);
+        this->post_processor(iter, particle);
+    }
+
     protected :
 
     VSMC_DEFINE_SMP_IMPL_COPY(OMP, MonitorEval)
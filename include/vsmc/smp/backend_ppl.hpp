@@ -33,12 +33,27 @@
 #define VSMC_SMP_BACKEND_PPL_HPP
 
 #include <vsmc/smp/backend_base.hpp>
+#include <vsmc/smp/internal/parallel_resample.hpp>
+#include <vsmc/smp/internal/parallel_weight.hpp>
+#include <vsmc/smp/internal/parallel_work.hpp>
+#include <vsmc/thread/blocked_range.hpp>
 #include <ppl.h>
 
 namespace vsmc {
 
 VSMC_DEFINE_SMP_FORWARD(PPL)
 
+namespace internal {
+
+template <typename SizeType>
+inline SizeType backend_ppl_block_num (SizeType N)
+{
+    return backend_block_num(N,
+            static_cast<SizeType>(::concurrency::GetProcessorCount()));
+}
+
+} // namespace vsmc::internal
+
 /// \brief Particle::value_type subtype using Parallel Pattern Library
 /// \ingroup PPL
 template <typename BaseState>
@@ -55,28 +70,90 @@ class StatePPL : public BaseState
     {
         VSMC_RUNTIME_ASSERT_SMP_BACKEND_BASE_COPY_SIZE_MISMATCH(PPL);
 
-        ::concurrency::parallel_for(static_cast<size_type>(0), N,
-                copy_work_<IntType>(this, copy_from));
+        // Each block of particles is copied at once, such that a gather into
+        // the back buffer issues one store fence per block instead of one
+        // per particle
+        typedef internal::ParallelCopyParticle<StatePPL<BaseState>, IntType>
+            work_type;
+        work_type work(this, copy_from);
+        const size_type n = internal::backend_ppl_block_num(N);
+        ::concurrency::parallel_for(static_cast<size_type>(0), n,
+                copy_work_<work_type>(&work, N, n));
+        work.finish();
     }
 
     private :
 
-    template <typename IntType>
+    template <typename WorkType>
     struct copy_work_
     {
-        copy_work_ (StatePPL<BaseState> *state, const IntType *copy_from) :
-            state_(state), copy_from_(copy_from) {}
+        copy_work_ (const WorkType *work, size_type N, size_type n) :
+            work_(work), N_(N), n_(n) {}
 
-        void operator() (size_type to) const
-        {state_->copy_particle(copy_from_[to], to);}
+        void operator() (size_type b) const
+        {
+            size_type first = 0;
+            size_type last = 0;
+            internal::backend_block_range(N_, n_, b, first, last);
+            (*work_)(BlockedRange<size_type>(first, last));
+        }
 
         private :
 
-        StatePPL<BaseState> *const state_;
-        const IntType *const copy_from_;
+        const WorkType *const work_;
+        const size_type N_;
+        const size_type n_;
     }; // class copy_work_
 }; // class StatePPL
 
+/// \brief Particle::weight_set_type subtype using Parallel Pattern Library
+/// \ingroup PPL
+///
+/// \details
+/// Weight operations are parallelized over blocks of weights. Reductions are
+/// combined in block order and the results do not depend on the number of
+/// threads. To use it, define `weight_set_type` in the value type of
+/// Particle, for example,
+/// ~~~{.cpp}
+/// typedef WeightSetPPL<> weight_set_type;
+/// ~~~
+template <typename WeightSetBase = WeightSet>
+class WeightSetPPL : public internal::WeightSetSMP<
+    WeightSetBase, WeightSetPPL<WeightSetBase> >
+{
+    public :
+
+    typedef typename WeightSetBase::size_type size_type;
+
+    explicit WeightSetPPL (size_type N) : internal::WeightSetSMP<
+        WeightSetBase, WeightSetPPL<WeightSetBase> >(N) {}
+
+    template <typename WorkType>
+    void parallel_run (std::size_t n, const WorkType &work) const
+    {::concurrency::parallel_for(static_cast<std::size_t>(0), n, work);}
+}; // class WeightSetPPL
+
+/// \brief Resampling algorithms using Parallel Pattern Library
+/// \ingroup PPL
+///
+/// \details
+/// Cumulative sums of weights and replication numbers are computed in
+/// parallel over blocks of weights. The results are identical to those of
+/// `Resample` with the same state of the RNG. To use it, for example,
+/// ~~~{.cpp}
+/// sampler.resample_scheme(ResamplePPL<Systematic>());
+/// ~~~
+template <ResampleScheme Scheme>
+class ResamplePPL : public internal::ResampleSMP<
+    Scheme, ResamplePPL<Scheme> >
+{
+    public :
+
+    template <typename WorkType>
+    void parallel_run (std::size_t n, const WorkType &work) const
+    {::concurrency::parallel_for(static_cast<std::size_t>(0), n, work);}
+}; // class ResamplePPL
+
 /// \brief Sampler<T>::init_type subtype using Parallel Pattern Library
 /// \ingroup PPL
 template <typename T, typename Derived>
@@ -91,8 +168,9 @@ class InitializePPL : public InitializeBase<T, Derived>
         this->initialize_param(particle, param);
         this->pre_processor(particle);
         ::concurrency::combinable<std::size_t> accept(accept_init_);
-        ::concurrency::parallel_for(static_cast<size_type>(0), N,
-                work_(this, &particle, &accept));
+        const size_type n = internal::backend_ppl_block_num(N);
+        ::concurrency::parallel_for(static_cast<size_type>(0), n,
+                work_(this, &particle, &accept, N, n));
         this->post_processor(particle);
 
         return accept.combine(accept_accu_);
@@ -110,13 +188,18 @@ class InitializePPL : public InitializeBase<T, Derived>
 
         work_ (InitializePPL<T, Derived> *init,
                 Particle<T> *particle,
-                ::concurrency::combinable<std::size_t> *accept) :
-            init_(init), particle_(particle), accept_(accept) {}
+                ::concurrency::combinable<std::size_t> *accept,
+                size_type N, size_type n) :
+            init_(init), particle_(particle), accept_(accept),
+            N_(N), n_(n) {}
 
-        void operator() (size_type i) const
+        void operator() (size_type b) const
         {
-            accept_->local() += init_->initialize_state(
-                    SingleParticle<T>(i, particle_));
+            size_type first = 0;
+            size_type last = 0;
+            internal::backend_block_range(N_, n_, b, first, last);
+            accept_->local() += init_->initialize_range(
+                    first, last, *particle_);
         }
 
         private :
@@ -124,6 +207,8 @@ class InitializePPL : public InitializeBase<T, Derived>
         InitializePPL<T, Derived> *const init_;
         Particle<T> *const particle_;
         ::concurrency::combinable<std::size_t> *const accept_;
+        const size_type N_;
+        const size_type n_;
     }; // class work_
 
     static std::size_t accept_init_ () {return 0;}
@@ -144,8 +229,9 @@ class MovePPL : public MoveBase<T, Derived>
         const size_type N = static_cast<size_type>(particle.size());
         this->pre_processor(iter, particle);
         ::concurrency::combinable<std::size_t> accept(accept_init_);
-        ::concurrency::parallel_for(static_cast<size_type>(0), N,
-                work_(this, iter, &particle, &accept));
+        const size_type n = internal::backend_ppl_block_num(N);
+        ::concurrency::parallel_for(static_cast<size_type>(0), n,
+                work_(this, iter, &particle, &accept, N, n));
         this->post_processor(iter, particle);
 
         return accept.combine(accept_accu_);
@@ -163,13 +249,18 @@ class MovePPL : public MoveBase<T, Derived>
 
         work_ (MovePPL<T, Derived> *move, std::size_t iter,
                 Particle<T> *particle,
-                ::concurrency::combinable<std::size_t> *accept):
-            move_(move), particle_(particle), accept_(accept), iter_(iter) {}
+                ::concurrency::combinable<std::size_t> *accept,
+                size_type N, size_type n):
+            move_(move), particle_(particle), accept_(accept), iter_(iter),
+            N_(N), n_(n) {}
 
-        void operator() (size_type i) const
+        void operator() (size_type b) const
         {
-            accept_->local() += move_->move_state(iter_,
-                    SingleParticle<T>(i, particle_));
+            size_type first = 0;
+            size_type last = 0;
+            internal::backend_block_range(N_, n_, b, first, last);
+            accept_->local() += move_->move_range(iter_,
+                    first, last, *particle_);
         }
 
         private :
@@ -178,6 +269,8 @@ class MovePPL : public MoveBase<T, Derived>
         Particle<T> *const particle_;
         ::concurrency::combinable<std::size_t> *const accept_;
         const std::size_t iter_;
+        const size_type N_;
+        const size_type n_;
     }; // class work_
 
     static std::size_t accept_init_ () {return 0;}
@@ -198,8 +291,22 @@ class MonitorEvalPPL : public MonitorEvalBase<T, Derived>
         typedef typename Particle<T>::size_type size_type;
         const size_type N = static_cast<size_type>(particle.size());
         this->pre_processor(iter, particle);
-        ::concurrency::parallel_for(static_cast<size_type>(0), N,
-                work_(this, iter, dim, &particle, res));
+        const size_type n = internal::backend_ppl_block_num(N);
+        ::concurrency::parallel_for(static_cast<size_type>(0), n,
+                work_(this, iter, dim, &particle, res, N, n));
+        this->post_processor(iter, particle);
+    }
+
+    void operator() (std::size_t iter, std::size_t dim,
+            const Particle<T> &particle, const double *weight, double *res)
+    {
+        this->pre_processor(iter, particle);
+        std::vector<double, AlignedAllocator<double> > partial;
+        internal::ParallelMonitorIntegrate<T, MonitorEvalPPL<T, Derived> >
+            work(this, iter, dim, &particle, weight, partial);
+        ::concurrency::parallel_for(static_cast<std::size_t>(0),
+                work.num(), work);
+        work.finish(res);
         this->post_processor(iter, particle);
     }
 
@@ -215,14 +322,18 @@ class MonitorEvalPPL : public MonitorEvalBase<T, Derived>
 
         work_ (MonitorEvalPPL<T, Derived> *monitor,
                 std::size_t iter, std::size_t dim,
-                const Particle<T> *particle, double *res) :
+                const Particle<T> *particle, double *res,
+                size_type N, size_type n) :
             monitor_(monitor), particle_(particle), res_(res),
-            iter_(iter), dim_(dim) {}
+            iter_(iter), dim_(dim), N_(N), n_(n) {}
 
-        void operator() (size_type i) const
+        void operator() (size_type b) const
         {
-            monitor_->monitor_state(iter_, dim_,
-                    ConstSingleParticle<T>(i, particle_), res_ + i * dim_);
+            size_type first = 0;
+            size_type last = 0;
+            internal::backend_block_range(N_, n_, b, first, last);
+            monitor_->monitor_range(iter_, dim_, first, last, *particle_,
+                    res_ + first * dim_);
         }
 
         private :
@@ -232,6 +343,8 @@ class MonitorEvalPPL : public MonitorEvalBase<T, Derived>
         double *const res_;
         const std::size_t iter_;
         const std::size_t dim_;
+        const size_type N_;
+        const size_type n_;
     }; // class work_
 }; // class MonitorEvalPPL
 
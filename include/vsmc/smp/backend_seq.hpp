@@ -33,6 +33,7 @@
 #define VSMC_SMP_BACKEND_SEQ_HPP
 
 #include <vsmc/smp/backend_base.hpp>
+#include <vsmc/smp/internal/parallel_work.hpp>
 
 namespace vsmc {
 
@@ -63,9 +64,7 @@ class InitializeSEQ : public InitializeBase<T, Derived>
         const size_type N = static_cast<size_type>(particle.size());
         this->initialize_param(particle, param);
         this->pre_processor(particle);
-        std::size_t accept = 0;
-        for (size_type i = 0; i != N; ++i)
-            accept += this->initialize_state(SingleParticle<T>(i, &particle));
+        std::size_t accept = this->initialize_range(0, N, particle);
         this->post_processor(particle);
 
         return accept;
@@ -88,9 +87,7 @@ class MoveSEQ : public MoveBase<T, Derived>
         typedef typename Particle<T>::size_type size_type;
         const size_type N = static_cast<size_type>(particle.size());
         this->pre_processor(iter, particle);
-        std::size_t accept = 0;
-        for (size_type i = 0; i != N; ++i)
-            accept += this->move_state(iter, SingleParticle<T>(i, &particle));
+        std::size_t accept = this->move_range(iter, 0, N, particle);
         this->post_processor(iter, particle);
 
         return accept;
@@ -114,10 +111,20 @@ class MonitorEvalSEQ : public MonitorEvalBase<T, Derived>
         typedef typename Particle<T>::size_type size_type;
         const size_type N = static_cast<size_type>(particle.size());
         this->pre_processor(iter, particle);
-        for (size_type i = 0; i != N; ++i) {
-            this->monitor_state(iter, dim,
-                    ConstSingleParticle<T>(i, &particle), res + i * dim);
-        }
+        this->monitor_range(iter, dim, 0, N, particle, res);
+        this->post_processor(iter, particle);
+    }
+
+    void operator() (std::size_t iter, std::size_t dim,
+            const Particle<T> &particle, const double *weight, double *res)
+    {
+        this->pre_processor(iter, particle);
+        std::vector<double, AlignedAllocator<double> > partial;
+        internal::ParallelMonitorIntegrate<T, MonitorEvalSEQ<T, Derived> >
+            work(this, iter, dim, &particle, weight, partial);
+        for (std::size_t b = 0; b != work.num(); ++b)
+            work(b);
+        work.finish(res);
         this->post_processor(iter, particle);
     }
 
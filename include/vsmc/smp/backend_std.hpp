@@ -33,6 +33,8 @@
 #define VSMC_SMP_BACKEND_STD_HPP
 
 #include <vsmc/smp/backend_base.hpp>
+#include <vsmc/smp/internal/parallel_resample.hpp>
+#include <vsmc/smp/internal/parallel_weight.hpp>
 #include <vsmc/smp/internal/parallel_work.hpp>
 #include <vsmc/thread/thread.hpp>
 
@@ -56,12 +58,68 @@ class StateSTD : public BaseState
     {
         VSMC_RUNTIME_ASSERT_SMP_BACKEND_BASE_COPY_SIZE_MISMATCH(STD);
 
-        parallel_for(BlockedRange<size_type>(0, N),
-                internal::ParallelCopyParticle<
-                StateSTD<BaseState>, IntType>(this, copy_from));
+        internal::ParallelCopyParticle<StateSTD<BaseState>, IntType> work(
+                this, copy_from);
+        if (N != 0)
+            parallel_for(BlockedRange<size_type>(0, N), work);
+        work.finish();
     }
 }; // class StateSTD
 
+/// \brief Particle::weight_set_type subtype using C++11 concurrency
+/// \ingroup STD
+///
+/// \details
+/// Weight operations are parallelized over blocks of weights. Reductions are
+/// combined in block order and the results do not depend on the number of
+/// threads. To use it, define `weight_set_type` in the value type of
+/// Particle, for example,
+/// ~~~{.cpp}
+/// typedef WeightSetSTD<> weight_set_type;
+/// ~~~
+template <typename WeightSetBase = WeightSet>
+class WeightSetSTD : public internal::WeightSetSMP<
+    WeightSetBase, WeightSetSTD<WeightSetBase> >
+{
+    public :
+
+    typedef typename WeightSetBase::size_type size_type;
+
+    explicit WeightSetSTD (size_type N) : internal::WeightSetSMP<
+        WeightSetBase, WeightSetSTD<WeightSetBase> >(N) {}
+
+    template <typename WorkType>
+    void parallel_run (std::size_t n, const WorkType &work) const
+    {
+        parallel_for(BlockedRange<std::size_t>(0, n),
+                internal::ParallelWeightRange<WorkType>(work));
+    }
+}; // class WeightSetSTD
+
+/// \brief Resampling algorithms using C++11 concurrency
+/// \ingroup STD
+///
+/// \details
+/// Cumulative sums of weights and replication numbers are computed in
+/// parallel over blocks of weights. The results are identical to those of
+/// `Resample` with the same state of the RNG. To use it, for example,
+/// ~~~{.cpp}
+/// sampler.resample_scheme(ResampleSTD<Systematic>());
+/// ~~~
+template <ResampleScheme Scheme>
+class ResampleSTD : public internal::ResampleSMP<
+    Scheme, ResampleSTD<Scheme> >
+{
+    public :
+
+    template <typename WorkType>
+    void parallel_run (std::size_t n, const WorkType &work) const
+    {
+        parallel_for(BlockedRange<std::size_t>(0, n),
+                internal::ParallelWeightRange<WorkType>(work));
+    }
+}; // class ResampleSTD
+
 /// \brief Sampler<T>::init_type subtype using C++11 concurrency
 /// \ingroup STD
 template <typename T, typename Derived>
@@ -77,7 +135,8 @@ class InitializeSTD : public InitializeBase<T, Derived>
         this->pre_processor(particle);
         internal::ParallelInitializeState<T, InitializeSTD<T, Derived> > work(
                 this, &particle);
-        parallel_reduce(BlockedRange<size_type>(0, N), work);
+        if (N != 0)
+            parallel_reduce(BlockedRange<size_type>(0, N), work);
         this->post_processor(particle);
 
         return work.accept();
@@ -102,7 +161,8 @@ class MoveSTD : public MoveBase<T, Derived>
         this->pre_processor(iter, particle);
         internal::ParallelMoveState<T, MoveSTD<T, Derived> > work(
                 this, iter, &particle);
-        parallel_reduce(BlockedRange<size_type>(0, N), work);
+        if (N != 0)
+            parallel_reduce(BlockedRange<size_type>(0, N), work);
         this->post_processor(iter, particle);
 
         return work.accept();
@@ -126,9 +186,25 @@ class MonitorEvalSTD : public MonitorEvalBase<T, Derived>
         typedef typename Particle<T>::size_type size_type;
         const size_type N = static_cast<size_type>(particle.size());
         this->pre_processor(iter, particle);
-        parallel_for(BlockedRange<size_type>(0, N),
-                internal::ParallelMonitorState<T, MonitorEvalSTD<T, Derived> >(
-                    this, iter, dim, &particle, res));
+        if (N != 0) {
+            parallel_for(BlockedRange<size_type>(0, N),
+                    internal::ParallelMonitorState<T,
+                    MonitorEvalSTD<T, Derived> >(
+                        this, iter, dim, &particle, res));
+        }
+        this->post_processor(iter, particle);
+    }
+
+    void operator() (std::size_t iter, std::size_t dim,
+            const Particle<T> &particle, const double *weight, double *res)
+    {
+        this->pre_processor(iter, particle);
+        std::vector<double, AlignedAllocator<double> > partial;
+        internal::ParallelMonitorIntegrate<T, MonitorEvalSTD<T, Derived> >
+            work(this, iter, dim, &particle, weight, partial);
+        if (work.num() != 0)
+            parallel_for(BlockedRange<std::size_t>(0, work.num()), work);
+        work.finish(res);
         this->post_processor(iter, particle);
     }
 
@@ -150,9 +226,11 @@ class PathEvalSTD : public PathEvalBase<T, Derived>
         typedef typename Particle<T>::size_type size_type;
         const size_type N = static_cast<size_type>(particle.size());
         this->pre_processor(iter, particle);
-        parallel_for(BlockedRange<size_type>(0, N),
-                internal::ParallelPathState<T, PathEvalSTD<T, Derived> >(
-                    this, iter, &particle, res));
+        if (N != 0) {
+            parallel_for(BlockedRange<size_type>(0, N),
+                    internal::ParallelPathState<T, PathEvalSTD<T, Derived> >(
+                        this, iter, &particle, res));
+        }
         this->post_processor(iter, particle);
 
         return this->path_grid(iter, particle);
@@ -0,0 +1,246 @@
+//============================================================================
+// vSMC/include/vsmc/smp/backend_steal.hpp
+//----------------------------------------------------------------------------
+//                         vSMC: Scalable Monte Carlo
+//----------------------------------------------------------------------------
+// Copyright (c) 2013-2015, Yan Zhou
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//   Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+//   Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//============================================================================
+
+#ifndef VSMC_SMP_BACKEND_STEAL_HPP
+#define VSMC_SMP_BACKEND_STEAL_HPP
+
+#include <vsmc/smp/backend_base.hpp>
+#include <vsmc/smp/internal/parallel_resample.hpp>
+#include <vsmc/smp/internal/parallel_weight.hpp>
+#include <vsmc/smp/internal/parallel_work.hpp>
+#include <vsmc/thread/work_steal.hpp>
+
+namespace vsmc {
+
+VSMC_DEFINE_SMP_FORWARD(STEAL)
+
+/// \brief Particle::value_type subtype using work stealing
+/// \ingroup STEAL
+template <typename BaseState>
+class StateSTEAL : public BaseState
+{
+    public :
+
+    typedef typename traits::SizeTypeTrait<BaseState>::type size_type;
+
+    explicit StateSTEAL (size_type N) : BaseState(N) {}
+
+    template <typename IntType>
+    void copy (size_type N, const IntType *copy_from)
+    {
+        VSMC_RUNTIME_ASSERT_SMP_BACKEND_BASE_COPY_SIZE_MISMATCH(STEAL);
+
+        internal::ParallelCopyParticle<StateSTEAL<BaseState>, IntType> work(
+                this, copy_from);
+        if (N != 0)
+            parallel_for_steal(BlockedRange<size_type>(0, N), work);
+        work.finish();
+    }
+}; // class StateSTEAL
+
+/// \brief Particle::weight_set_type subtype using work stealing
+/// \ingroup STEAL
+///
+/// \details
+/// Weight operations are parallelized over blocks of weights. Reductions are
+/// combined in block order and the results do not depend on the number of
+/// threads. To use it, define `weight_set_type` in the value type of
+/// Particle, for example,
+/// ~~~{.cpp}
+/// typedef WeightSetSTEAL<> weight_set_type;
+/// ~~~
+template <typename WeightSetBase = WeightSet>
+class WeightSetSTEAL : public internal::WeightSetSMP<
+    WeightSetBase, WeightSetSTEAL<WeightSetBase> >
+{
+    public :
+
+    typedef typename WeightSetBase::size_type size_type;
+
+    explicit WeightSetSTEAL (size_type N) : internal::WeightSetSMP<
+        WeightSetBase, WeightSetSTEAL<WeightSetBase> >(N) {}
+
+    template <typename WorkType>
+    void parallel_run (std::size_t n, const WorkType &work) const
+    {
+        parallel_for_steal(BlockedRange<std::size_t>(0, n),
+                internal::ParallelWeightRange<WorkType>(work));
+    }
+}; // class WeightSetSTEAL
+
+/// \brief Resampling algorithms using work stealing
+/// \ingroup STEAL
+///
+/// \details
+/// Cumulative sums of weights and replication numbers are computed in
+/// parallel over blocks of weights. The results are identical to those of
+/// `Resample` with the same state of the RNG. To use it, for example,
+/// ~~~{.cpp}
+/// sampler.resample_scheme(ResampleSTEAL<Systematic>());
+/// ~~~
+template <ResampleScheme Scheme>
+class ResampleSTEAL : public internal::ResampleSMP<
+    Scheme, ResampleSTEAL<Scheme> >
+{
+    public :
+
+    template <typename WorkType>
+    void parallel_run (std::size_t n, const WorkType &work) const
+    {
+        parallel_for_steal(BlockedRange<std::size_t>(0, n),
+                internal::ParallelWeightRange<WorkType>(work));
+    }
+}; // class ResampleSTEAL
+
+/// \brief Sampler<T>::init_type subtype using work stealing
+/// \ingroup STEAL
+template <typename T, typename Derived>
+class InitializeSTEAL : public InitializeBase<T, Derived>
+{
+    public :
+
+    std::size_t operator() (Particle<T> &particle, void *param)
+    {
+        typedef typename Particle<T>::size_type size_type;
+        const size_type N = static_cast<size_type>(particle.size());
+        this->initialize_param(particle, param);
+        this->pre_processor(particle);
+        internal::ParallelInitializeState<T, InitializeSTEAL<T, Derived> >
+            work(this, &particle);
+        if (N != 0)
+            parallel_reduce_steal(BlockedRange<size_type>(0, N), work);
+        this->post_processor(particle);
+
+        return work.accept();
+    }
+
+    protected :
+
+    VSMC_DEFINE_SMP_IMPL_COPY(STEAL, Initialize)
+}; // class InitializeSTEAL
+
+/// \brief Sampler<T>::move_type subtype using work stealing
+/// \ingroup STEAL
+template <typename T, typename Derived>
+class MoveSTEAL : public MoveBase<T, Derived>
+{
+    public :
+
+    std::size_t operator() (std::size_t iter, Particle<T> &particle)
+    {
+        typedef typename Particle<T>::size_type size_type;
+        const size_type N = static_cast<size_type>(particle.size());
+        this->pre_processor(iter, particle);
+        internal::ParallelMoveState<T, MoveSTEAL<T, Derived> > work(
+                this, iter, &particle);
+        if (N != 0)
+            parallel_reduce_steal(BlockedRange<size_type>(0, N), work);
+        this->post_processor(iter, particle);
+
+        return work.accept();
+    }
+
+    protected :
+
+    VSMC_DEFINE_SMP_IMPL_COPY(STEAL, Move)
+}; // class MoveSTEAL
+
+/// \brief Monitor<T>::eval_type subtype using work stealing
+/// \ingroup STEAL
+template <typename T, typename Derived>
+class MonitorEvalSTEAL : public MonitorEvalBase<T, Derived>
+{
+    public :
+
+    void operator() (std::size_t iter, std::size_t dim,
+            const Particle<T> &particle, double *res)
+    {
+        typedef typename Particle<T>::size_type size_type;
+        const size_type N = static_cast<size_type>(particle.size());
+        this->pre_processor(iter, particle);
+        if (N != 0) {
+            parallel_for_steal(BlockedRange<size_type>(0, N),
+                    internal::ParallelMonitorState<T,
+                    MonitorEvalSTEAL<T, Derived> >(
+                        this, iter, dim, &particle, res));
+        }
+        this->post_processor(iter, particle);
+    }
+
+    void operator() (std::size_t iter, std::size_t dim,
+            const Particle<T> &particle, const double *weight, double *res)
+    {
+        this->pre_processor(iter, particle);
+        std::vector<double, AlignedAllocator<double> > partial;
+        internal::ParallelMonitorIntegrate<T, MonitorEvalSTEAL<T, Derived> >
+            work(this, iter, dim, &particle, weight, partial);
+        if (work.num() != 0)
+            parallel_for_steal(BlockedRange<std::size_t>(0, work.num()), work);
+        work.finish(res);
+        this->post_processor(iter, particle);
+    }
+
+    protected :
+
+    VSMC_DEFINE_SMP_IMPL_COPY(STEAL, MonitorEval)
+}; // class MonitorEvalSTEAL
+
+/// \brief Path<T>::eval_type subtype using work stealing
+/// \ingroup STEAL
+template <typename T, typename Derived>
+class PathEvalSTEAL : public PathEvalBase<T, Derived>
+{
+    public :
+
+    double operator() (std::size_t iter, const Particle<T> &particle,
+            double *res)
+    {
+        typedef typename Particle<T>::size_type size_type;
+        const size_type N = static_cast<size_type>(particle.size());
+        this->pre_processor(iter, particle);
+        if (N != 0) {
+            parallel_for_steal(BlockedRange<size_type>(0, N),
+                    internal::ParallelPathState<T, PathEvalSTEAL<T, Derived> >(
+                        this, iter, &particle, res));
+        }
+        this->post_processor(iter, particle);
+
+        return this->path_grid(iter, particle);
+    }
+
+    protected :
+
+    VSMC_DEFINE_SMP_IMPL_COPY(STEAL, PathEval)
+}; // PathEvalSTEAL
+
+} // namespace vsmc
+
+#endif // VSMC_SMP_BACKEND_STEAL_HPP
@@ -33,6 +33,8 @@
 #define VSMC_SMP_BACKEND_TBB_HPP
 
 #include <vsmc/smp/backend_base.hpp>
+#include <vsmc/smp/internal/parallel_resample.hpp>
+#include <vsmc/smp/internal/parallel_weight.hpp>
 #include <vsmc/smp/internal/parallel_work.hpp>
 #include <tbb/blocked_range.h>
 #include <tbb/parallel_for.h>
@@ -98,8 +100,10 @@ class StateTBB : public BaseState
     void parallel_copy_run (const IntType *copy_from,
             const ::tbb::blocked_range<size_type> &range)
     {
-        ::tbb::parallel_for(range, internal::ParallelCopyParticle<
-                StateTBB<BaseState>, IntType>(this, copy_from));
+        internal::ParallelCopyParticle<StateTBB<BaseState>, IntType> work(
+                this, copy_from);
+        ::tbb::parallel_for(range, work);
+        work.finish();
     }
 
     template <typename IntType>
@@ -107,8 +111,10 @@ class StateTBB : public BaseState
             const ::tbb::blocked_range<size_type> &range,
             const ::tbb::auto_partitioner &partitioner)
     {
-        ::tbb::parallel_for(range, internal::ParallelCopyParticle<
-                StateTBB<BaseState>, IntType>(this, copy_from), partitioner);
+        internal::ParallelCopyParticle<StateTBB<BaseState>, IntType> work(
+                this, copy_from);
+        ::tbb::parallel_for(range, work, partitioner);
+        work.finish();
     }
 
     template <typename IntType>
@@ -116,8 +122,10 @@ class StateTBB : public BaseState
             const ::tbb::blocked_range<size_type> &range,
             const ::tbb::simple_partitioner &partitioner)
     {
-        ::tbb::parallel_for(range, internal::ParallelCopyParticle<
-                StateTBB<BaseState>, IntType>(this, copy_from), partitioner);
+        internal::ParallelCopyParticle<StateTBB<BaseState>, IntType> work(
+                this, copy_from);
+        ::tbb::parallel_for(range, work, partitioner);
+        work.finish();
     }
 
     template <typename IntType>
@@ -125,8 +133,10 @@ class StateTBB : public BaseState
             const ::tbb::blocked_range<size_type> &range,
             ::tbb::affinity_partitioner &partitioner)
     {
-        ::tbb::parallel_for(range, internal::ParallelCopyParticle<
-                StateTBB<BaseState>, IntType>(this, copy_from), partitioner);
+        internal::ParallelCopyParticle<StateTBB<BaseState>, IntType> work(
+                this, copy_from);
+        ::tbb::parallel_for(range, work, partitioner);
+        work.finish();
     }
 
 #if __TBB_TASK_GROUP_CONTEXT
@@ -136,9 +146,10 @@ class StateTBB : public BaseState
             const ::tbb::auto_partitioner &partitioner,
             ::tbb::task_group_context &context)
     {
-        ::tbb::parallel_for(range, internal::ParallelCopyParticle<
-                StateTBB<BaseState>, IntType>(this, copy_from), partitioner,
-                context);
+        internal::ParallelCopyParticle<StateTBB<BaseState>, IntType> work(
+                this, copy_from);
+        ::tbb::parallel_for(range, work, partitioner, context);
+        work.finish();
     }
 
     template <typename IntType>
@@ -147,9 +158,10 @@ class StateTBB : public BaseState
             const ::tbb::simple_partitioner &partitioner,
             ::tbb::task_group_context &context)
     {
-        ::tbb::parallel_for(range, internal::ParallelCopyParticle<
-                StateTBB<BaseState>, IntType>(this, copy_from), partitioner,
-                context);
+        internal::ParallelCopyParticle<StateTBB<BaseState>, IntType> work(
+                this, copy_from);
+        ::tbb::parallel_for(range, work, partitioner, context);
+        work.finish();
     }
 
     template <typename IntType>
@@ -158,13 +170,69 @@ class StateTBB : public BaseState
             ::tbb::affinity_partitioner &partitioner,
             ::tbb::task_group_context &context)
     {
-        ::tbb::parallel_for(range, internal::ParallelCopyParticle<
-                StateTBB<BaseState>, IntType>(this, copy_from), partitioner,
-                context);
+        internal::ParallelCopyParticle<StateTBB<BaseState>, IntType> work(
+                this, copy_from);
+        ::tbb::parallel_for(range, work, partitioner, context);
+        work.finish();
     }
 #endif // __TBB_TASK_GROUP_CONTEXT
 }; // class StateTBB
 
+/// \brief Particle::weight_set_type subtype using Intel Threading Building
+/// Blocks
+/// \ingroup TBB
+///
+/// \details
+/// Weight operations are parallelized over blocks of weights. Reductions are
+/// combined in block order and the results do not depend on the number of
+/// threads. To use it, define `weight_set_type` in the value type of
+/// Particle, for example,
+/// ~~~{.cpp}
+/// typedef WeightSetTBB<> weight_set_type;
+/// ~~~
+template <typename WeightSetBase = WeightSet>
+class WeightSetTBB : public internal::WeightSetSMP<
+    WeightSetBase, WeightSetTBB<WeightSetBase> >
+{
+    public :
+
+    typedef typename WeightSetBase::size_type size_type;
+
+    explicit WeightSetTBB (size_type N) : internal::WeightSetSMP<
+        WeightSetBase, WeightSetTBB<WeightSetBase> >(N) {}
+
+    template <typename WorkType>
+    void parallel_run (std::size_t n, const WorkType &work) const
+    {
+        ::tbb::parallel_for(::tbb::blocked_range<std::size_t>(0, n),
+                internal::ParallelWeightRange<WorkType>(work));
+    }
+}; // class WeightSetTBB
+
+/// \brief Resampling algorithms using Intel Threading Building Blocks
+/// \ingroup TBB
+///
+/// \details
+/// Cumulative sums of weights and replication numbers are computed in
+/// parallel over blocks of weights. The results are identical to those of
+/// `Resample` with the same state of the RNG. To use it, for example,
+/// ~~~{.cpp}
+/// sampler.resample_scheme(ResampleTBB<Systematic>());
+/// ~~~
+template <ResampleScheme Scheme>
+class ResampleTBB : public internal::ResampleSMP<
+    Scheme, ResampleTBB<Scheme> >
+{
+    public :
+
+    template <typename WorkType>
+    void parallel_run (std::size_t n, const WorkType &work) const
+    {
+        ::tbb::parallel_for(::tbb::blocked_range<std::size_t>(0, n),
+                internal::ParallelWeightRange<WorkType>(work));
+    }
+}; // class ResampleTBB
+
 /// \brief Sampler<T>::init_type subtype using Intel Threading Building Blocks
 /// \ingroup TBB
 template <typename T, typename Derived>
@@ -332,6 +400,19 @@ class MonitorEvalTBB : public MonitorEvalBase<T, Derived>
                     0, particle.size()));
     }
 
+    void operator() (std::size_t iter, std::size_t dim,
+            const Particle<T> &particle, const double *weight, double *res)
+    {
+        this->pre_processor(iter, particle);
+        std::vector<double, AlignedAllocator<double> > partial;
+        internal::ParallelMonitorIntegrate<T, MonitorEvalTBB<T, Derived> >
+            work(this, iter, dim, &particle, weight, partial);
+        ::tbb::parallel_for(
+                ::tbb::blocked_range<std::size_t>(0, work.num()), work);
+        work.finish(res);
+        this->post_processor(iter, particle);
+    }
+
     protected :
 
     VSMC_DEFINE_SMP_IMPL_COPY(TBB, MonitorEval)
@@ -0,0 +1,492 @@
+//============================================================================
+// vSMC/include/vsmc/smp/internal/parallel_resample.hpp
+//----------------------------------------------------------------------------
+//                         vSMC: Scalable Monte Carlo
+//----------------------------------------------------------------------------
+// Copyright (c) 2013-2015, Yan Zhou
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//   Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+//   Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//============================================================================
+
+
+#ifndef VSMC_SMP_INTERNAL_PARALLEL_RESAMPLE_HPP
+#define VSMC_SMP_INTERNAL_PARALLEL_RESAMPLE_HPP
+
+#include <vsmc/internal/common.hpp>
+#include <vsmc/resample/resample.hpp>
+
+namespace vsmc {
+
+namespace internal {
+
+// The U01 sequence and if the scheme resamples the residuals, for schemes
+// based on inversion of cumulative sums of weights
+template <ResampleScheme> struct ParallelResampleTrait;
+
+template <> struct ParallelResampleTrait<Multinomial>
+{
+    typedef cxx11::false_type residual;
+    template <typename RngType> struct u01seq
+    {typedef U01SequenceSorted<RngType> type;};
+}; // struct ParallelResampleTrait
+
+template <> struct ParallelResampleTrait<Residual>
+{
+    typedef cxx11::true_type residual;
+    template <typename RngType> struct u01seq
+    {typedef U01SequenceSorted<RngType> type;};
+}; // struct ParallelResampleTrait
+
+template <> struct ParallelResampleTrait<Stratified>
+{
+    typedef cxx11::false_type residual;
+    template <typename RngType> struct u01seq
+    {typedef U01SequenceStratified<RngType> type;};
+}; // struct ParallelResampleTrait
+
+template <> struct ParallelResampleTrait<Systematic>
+{
+    typedef cxx11::false_type residual;
+    template <typename RngType> struct u01seq
+    {typedef U01SequenceSystematic<RngType> type;};
+}; // struct ParallelResampleTrait
+
+template <> struct ParallelResampleTrait<ResidualStratified>
+{
+    typedef cxx11::true_type residual;
+    template <typename RngType> struct u01seq
+    {typedef U01SequenceStratified<RngType> type;};
+}; // struct ParallelResampleTrait
+
+template <> struct ParallelResampleTrait<ResidualSystematic>
+{
+    typedef cxx11::true_type residual;
+    template <typename RngType> struct u01seq
+    {typedef U01SequenceSystematic<RngType> type;};
+}; // struct ParallelResampleTrait
+
+// r = modf(N * w, i), rsum[b] = sum(r), isum[b] = sum(i) within block b
+class ParallelResampleResidual
+{
+    public :
+
+    ParallelResampleResidual (std::size_t M, std::size_t N, const double *w,
+            double *r, double *i, double *rsum, std::size_t *isum) :
+        M_(M), N_(N), w_(w), r_(r), i_(i), rsum_(rsum), isum_(isum) {}
+
+    void operator() (std::size_t b) const
+    {
+        using std::modf;
+
+        const std::size_t n = resample_block_size(M_, b);
+        const std::size_t f = b * VSMC_RESAMPLE_BLOCK_SIZE;
+        double *const r = r_ + f;
+        double *const i = i_ + f;
+        std::size_t s = 0;
+        for (std::size_t j = 0; j != n; ++j) {
+            r[j] = modf(N_ * w_[f + j], i + j);
+            s += static_cast<std::size_t>(i[j]);
+        }
+        rsum_[b] = resample_block_sum(n, r);
+        isum_[b] = s;
+    }
+
+    private :
+
+    const std::size_t M_;
+    const std::size_t N_;
+    const double *const w_;
+    double *const r_;
+    double *const i_;
+    double *const rsum_;
+    std::size_t *const isum_;
+}; // class ParallelResampleResidual
+
+// w *= coeff within block b
+class ParallelResampleScale
+{
+    public :
+
+    ParallelResampleScale (std::size_t M, double coeff, double *w) :
+        M_(M), coeff_(coeff), w_(w) {}
+
+    void operator() (std::size_t b) const
+    {
+        math::scal(resample_block_size(M_, b), coeff_,
+                w_ + b * VSMC_RESAMPLE_BLOCK_SIZE);
+    }
+
+    private :
+
+    const std::size_t M_;
+    const double coeff_;
+    double *const w_;
+}; // class ParallelResampleScale
+
+// sum[b] = sum(w) within block b
+class ParallelResampleSum
+{
+    public :
+
+    ParallelResampleSum (std::size_t M, const double *w, double *sum) :
+        M_(M), w_(w), sum_(sum) {}
+
+    void operator() (std::size_t b) const
+    {
+        sum_[b] = resample_block_sum(resample_block_size(M_, b),
+                w_ + b * VSMC_RESAMPLE_BLOCK_SIZE);
+    }
+
+    private :
+
+    const std::size_t M_;
+    const double *const w_;
+    double *const sum_;
+}; // class ParallelResampleSum
+
+// max[b] = max(w) within block b
+class ParallelResampleMax
+{
+    public :
+
+    ParallelResampleMax (std::size_t M, const double *w, double *max) :
+        M_(M), w_(w), max_(max) {}
+
+    void operator() (std::size_t b) const
+    {
+        max_[b] = resample_max(resample_block_size(M_, b),
+                w_ + b * VSMC_RESAMPLE_BLOCK_SIZE);
+    }
+
+    private :
+
+    const std::size_t M_;
+    const double *const w_;
+    double *const max_;
+}; // class ParallelResampleMax
+
+// Ancestors within block b of new particles by Metropolis resampling
+class ParallelResampleMetropolis
+{
+    public :
+
+    ParallelResampleMetropolis (std::size_t M, std::size_t N,
+            uint64_t seed, std::size_t steps, const double *w,
+            std::size_t *ancestor) :
+        M_(M), N_(N), seed_(seed), steps_(steps), w_(w), ancestor_(ancestor)
+    {}
+
+    void operator() (std::size_t b) const
+    {resample_metropolis(M_, N_, b, seed_, steps_, w_, ancestor_);}
+
+    private :
+
+    const std::size_t M_;
+    const std::size_t N_;
+    const uint64_t seed_;
+    const std::size_t steps_;
+    const double *const w_;
+    std::size_t *const ancestor_;
+}; // class ParallelResampleMetropolis
+
+// Ancestors within block b of new particles by rejection resampling
+class ParallelResampleRejection
+{
+    public :
+
+    ParallelResampleRejection (std::size_t M, std::size_t N,
+            uint64_t seed, double wmax, const double *w,
+            std::size_t *ancestor) :
+        M_(M), N_(N), seed_(seed), wmax_(wmax), w_(w), ancestor_(ancestor)
+    {}
+
+    void operator() (std::size_t b) const
+    {resample_rejection(M_, N_, b, seed_, wmax_, w_, ancestor_);}
+
+    private :
+
+    const std::size_t M_;
+    const std::size_t N_;
+    const uint64_t seed_;
+    const double wmax_;
+    const double *const w_;
+    std::size_t *const ancestor_;
+}; // class ParallelResampleRejection
+
+// Replication numbers within block b given the sum of weights before it,
+// offset[b], and the first n of the N U01 random variates, made sorted by
+// taking the running maximum. If i is not null, it is added to the results
+template <typename IntType>
+class ParallelResampleInversion
+{
+    public :
+
+    ParallelResampleInversion (std::size_t M, std::size_t n,
+            const double *w, const double *offset, const double *u,
+            const double *i, IntType *replication) :
+        M_(M), n_(n), w_(w), offset_(offset), u_(u), i_(i),
+        replication_(replication) {}
+
+    void operator() (std::size_t b) const
+    {
+        const std::size_t m = resample_block_size(M_, b);
+        const std::size_t f = b * VSMC_RESAMPLE_BLOCK_SIZE;
+        double offset = offset_[b];
+        const std::size_t k = static_cast<std::size_t>(
+                std::upper_bound(u_, u_ + n_, offset) - u_);
+        inversion_block(m, n_, w_ + f, offset, u_, k, replication_ + f);
+        if (i_ != VSMC_NULLPTR) {
+            for (std::size_t j = f; j != f + m; ++j)
+                replication_[j] += static_cast<IntType>(i_[j]);
+        }
+    }
+
+    private :
+
+    const std::size_t M_;
+    const std::size_t n_;
+    const double *const w_;
+    const double *const offset_;
+    const double *const u_;
+    const double *const i_;
+    IntType *const replication_;
+}; // class ParallelResampleInversion
+
+/// \brief Resampling algorithms parallelized over blocks of weights
+/// \ingroup SMP
+///
+/// \details
+/// The results are identical to those of `Resample<Scheme>` with the same
+/// state of the RNG, and the RNG is left in the same state. For schemes based
+/// on cumulative sums of weights, the U01 random variates are generated
+/// sequentially, while cumulative sums of weights and replication numbers
+/// are computed in parallel over blocks of `VSMC_RESAMPLE_BLOCK_SIZE`
+/// weights. For `Metropolis` and `Rejection`, blocks of new particles are
+/// drawn in parallel. `Derived` shall provide a member function
+/// ~~~{.cpp}
+/// template <typename WorkType>
+/// void parallel_run (std::size_t n, const WorkType &work) const;
+/// ~~~
+/// which calls `work(b)` for each `b` in `[0, n)`, in any order and possibly
+/// in parallel.
+template <ResampleScheme Scheme, typename Derived>
+class ResampleSMP
+{
+    public :
+
+    template <typename IntType, typename RngType>
+    void operator() (std::size_t M, std::size_t N, RngType &rng,
+            const double *weight, IntType *replication)
+    {
+        resample(M, N, rng, weight, replication,
+                cxx11::integral_constant<ResampleScheme, Scheme>());
+    }
+
+    private :
+
+    std::vector<double, AlignedAllocator<double> > residual_;
+    std::vector<double, AlignedAllocator<double> > integral_;
+    std::vector<double, AlignedAllocator<double> > u01_;
+    std::vector<double> sum_;
+    std::vector<double> max_;
+    std::vector<std::size_t> isum_;
+    std::vector<std::size_t> ancestor_;
+
+    template <typename IntType, typename RngType, ResampleScheme S>
+    void resample (std::size_t M, std::size_t N, RngType &rng,
+            const double *weight, IntType *replication,
+            cxx11::integral_constant<ResampleScheme, S>)
+    {
+        resample(M, N, rng, weight, replication,
+                typename ParallelResampleTrait<S>::residual());
+    }
+
+    template <typename IntType, typename RngType>
+    void resample (std::size_t M, std::size_t N, RngType &rng,
+            const double *weight, IntType *replication, ResampleMetropolis)
+    {
+        if (M == 0)
+            return;
+
+        const std::size_t B = resample_block_num(M);
+        sum_.resize(B);
+        max_.resize(B);
+        run(B, ParallelResampleSum(M, weight, &sum_[0]));
+        run(B, ParallelResampleMax(M, weight, &max_[0]));
+        double wsum = 0;
+        for (std::size_t b = 0; b != B; ++b)
+            wsum += sum_[b];
+        const std::size_t steps = resample_metropolis_steps(M, wsum,
+                resample_max(B, &max_[0]));
+        const uint64_t seed = static_cast<uint64_t>(rng());
+        ancestor_.resize(N);
+        std::size_t *const aptr = N == 0 ? VSMC_NULLPTR : &ancestor_[0];
+        run(resample_block_num(N), ParallelResampleMetropolis(
+                    M, N, seed, steps, weight, aptr));
+        resample_count(M, N, aptr, replication);
+    }
+
+    template <typename IntType, typename RngType>
+    void resample (std::size_t M, std::size_t N, RngType &rng,
+            const double *weight, IntType *replication, ResampleRejection)
+    {
+        if (M == 0)
+            return;
+
+        const std::size_t B = resample_block_num(M);
+        max_.resize(B);
+        run(B, ParallelResampleMax(M, weight, &max_[0]));
+        const double wmax = resample_max(B, &max_[0]);
+        const uint64_t seed = static_cast<uint64_t>(rng());
+        ancestor_.resize(N);
+        std::size_t *const aptr = N == 0 ? VSMC_NULLPTR : &ancestor_[0];
+        run(resample_block_num(N), ParallelResampleRejection(
+                    M, N, seed, wmax, weight, aptr));
+        resample_count(M, N, aptr, replication);
+    }
+
+    template <typename IntType, typename RngType>
+    void resample (std::size_t M, std::size_t N, RngType &rng,
+            const double *weight, IntType *replication, cxx11::false_type)
+    {inversion(M, N, rng, weight, VSMC_NULLPTR, replication);}
+
+    template <typename IntType, typename RngType>
+    void resample (std::size_t M, std::size_t N, RngType &rng,
+            const double *weight, IntType *replication, cxx11::true_type)
+    {
+        if (M == 0)
+            return;
+
+        residual_.resize(M);
+        integral_.resize(M);
+        double *const rptr = &residual_[0];
+        double *const iptr = &integral_[0];
+        const std::size_t B = resample_block_num(M);
+        sum_.resize(B);
+        isum_.resize(B);
+        run(B, ParallelResampleResidual(M, N, weight, rptr, iptr,
+                    &sum_[0], &isum_[0]));
+        double s = 0;
+        std::size_t R = 0;
+        for (std::size_t b = 0; b != B; ++b) {
+            s += sum_[b];
+            R += isum_[b];
+        }
+        run(B, ParallelResampleScale(M, 1 / s, rptr));
+
+        std::size_t NN = N - R;
+        inversion(M, NN, rng, rptr, iptr, replication);
+    }
+
+    template <typename IntType, typename RngType>
+    void inversion (std::size_t M, std::size_t N, RngType &rng,
+            const double *weight, const double *integral,
+            IntType *replication)
+    {
+        typedef typename ParallelResampleTrait<Scheme>::template
+            u01seq<RngType>::type u01seq_type;
+
+        if (M == 0)
+            return;
+
+        if (M == 1 || N == 0) {
+            u01seq_type u01seq(N, rng);
+            internal::inversion(M, N, weight, u01seq, replication);
+            if (integral != VSMC_NULLPTR) {
+                for (std::size_t i = 0; i != M; ++i)
+                    replication[i] += static_cast<IntType>(integral[i]);
+            }
+            return;
+        }
+
+        const std::size_t B = resample_block_num(M - 1);
+        sum_.resize(B);
+        run(B, ParallelResampleSum(M - 1, weight, &sum_[0]));
+        double accw = 0;
+        for (std::size_t b = 0; b != B; ++b) {
+            const double w = sum_[b];
+            sum_[b] = accw;
+            accw += w;
+        }
+
+        u01_.resize(N);
+        double *const u = &u01_[0];
+        u01seq_type u01seq(N, rng);
+        const std::size_t n = generate(N, u01seq, accw, u);
+        run(B, ParallelResampleInversion<IntType>(
+                    M - 1, n, weight, &sum_[0], u, integral, replication));
+        const std::size_t k = static_cast<std::size_t>(
+                std::upper_bound(u, u + n, accw) - u);
+        replication[M - 1] = static_cast<IntType>(N - k);
+        if (integral != VSMC_NULLPTR)
+            replication[M - 1] += static_cast<IntType>(integral[M - 1]);
+    }
+
+    // Generate the same variates as the sequential algorithm, which stops at
+    // the first one greater than the sum of all but the last weight, and
+    // return the number of variates generated
+    template <typename U01SeqType>
+    static std::size_t generate (std::size_t N, U01SeqType &u01seq,
+            double accw, double *u)
+    {
+        std::size_t n = 0;
+        double umax = 0;
+        while (n != N) {
+            const double v = u01seq[n];
+            if (umax < v)
+                umax = v;
+            u[n++] = umax;
+            if (umax > accw)
+                break;
+        }
+
+        return n;
+    }
+
+    // The sequential algorithm generates the whole sequence at once
+    template <typename RngType>
+    static std::size_t generate (std::size_t N,
+            U01SequenceSorted<RngType> &u01seq, double, double *u)
+    {
+        u01seq.generate(u);
+        for (std::size_t n = 1; n < N; ++n)
+            if (u[n] < u[n - 1])
+                u[n] = u[n - 1];
+
+        return N;
+    }
+
+    template <typename WorkType>
+    void run (std::size_t n, const WorkType &work) const
+    {
+        if (n != 0)
+            static_cast<const Derived *>(this)->parallel_run(n, work);
+    }
+}; // class ResampleSMP
+
+} // namespace vsmc::internal
+
+} // namespace vsmc
+
+#endif // VSMC_SMP_INTERNAL_PARALLEL_RESAMPLE_HPP
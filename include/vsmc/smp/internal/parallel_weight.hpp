@@ -0,0 +1,660 @@
+//============================================================================
+// vSMC/include/vsmc/smp/internal/parallel_weight.hpp
+//----------------------------------------------------------------------------
+//                         vSMC: Scalable Monte Carlo
+//----------------------------------------------------------------------------
+// Copyright (c) 2013-2015, Yan Zhou
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//   Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+//   Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//============================================================================
+
+#ifndef VSMC_SMP_INTERNAL_PARALLEL_WEIGHT_HPP
+#define VSMC_SMP_INTERNAL_PARALLEL_WEIGHT_HPP
+
+#include <vsmc/internal/common.hpp>
+#include <vsmc/core/weight_set.hpp>
+
+namespace vsmc {
+
+namespace internal {
+
+// Blocks of VSMC_WEIGHT_SET_BLOCK_SIZE elements are the unit of parallel
+// work. Each block writes its partial result to its own slot and the slots
+// are reduced sequentially in the order of blocks. Thus the results do not
+// depend on the number of threads or how blocks are scheduled.
+
+class ParallelWeightBlock
+{
+    public :
+
+    explicit ParallelWeightBlock (std::size_t N) : N_(N) {}
+
+    std::size_t num () const
+    {
+        return (N_ + VSMC_WEIGHT_SET_BLOCK_SIZE - 1) /
+            VSMC_WEIGHT_SET_BLOCK_SIZE;
+    }
+
+    std::size_t first (std::size_t b) const
+    {return b * VSMC_WEIGHT_SET_BLOCK_SIZE;}
+
+    std::size_t size (std::size_t b) const
+    {
+        const std::size_t f = first(b);
+
+        return N_ - f < VSMC_WEIGHT_SET_BLOCK_SIZE ?
+            N_ - f : VSMC_WEIGHT_SET_BLOCK_SIZE;
+    }
+
+    private :
+
+    std::size_t N_;
+}; // class ParallelWeightBlock
+
+// Call work(b) for each block in a range of blocks, for backends that
+// process ranges
+template <typename WorkType>
+class ParallelWeightRange
+{
+    public :
+
+    explicit ParallelWeightRange (const WorkType &work) : work_(work) {}
+
+    template <typename RangeType>
+    void operator() (const RangeType &range) const
+    {
+        for (std::size_t b = static_cast<std::size_t>(range.begin());
+                b != static_cast<std::size_t>(range.end()); ++b)
+            work_(b);
+    }
+
+    private :
+
+    WorkType work_;
+}; // class ParallelWeightRange
+
+// res[b] = max(x) within block b
+class ParallelWeightMax
+{
+    public :
+
+    ParallelWeightMax (ParallelWeightBlock block, const double *x,
+            const double *y, double *res) :
+        block_(block), x_(x), y_(y), res_(res) {}
+
+    void operator() (std::size_t b) const
+    {
+        const std::size_t n = block_.size(b);
+        const double *const x = x_ + block_.first(b);
+        if (y_ == VSMC_NULLPTR) {
+            double dmax = x[0];
+            for (std::size_t i = 0; i != n; ++i)
+                if (dmax < x[i])
+                    dmax = x[i];
+            res_[b] = dmax;
+        } else {
+            const double *const y = y_ + block_.first(b);
+            double dmax = x[0] + y[0];
+            for (std::size_t i = 0; i != n; ++i)
+                if (dmax < x[i] + y[i])
+                    dmax = x[i] + y[i];
+            res_[b] = dmax;
+        }
+    }
+
+    private :
+
+    const ParallelWeightBlock block_;
+    const double *const x_;
+    const double *const y_;
+    double *const res_;
+}; // class ParallelWeightMax
+
+// lw -= shift, w = exp(lw), sum[b] = sum(w), sum2[b] = sum(w^2)
+class ParallelWeightExp
+{
+    public :
+
+    ParallelWeightExp (ParallelWeightBlock block, double shift,
+            double *lw, double *w, double *sum, double *sum2) :
+        block_(block), shift_(shift), lw_(lw), w_(w), sum_(sum), sum2_(sum2)
+    {}
+
+    void operator() (std::size_t b) const
+    {
+        const std::size_t n = block_.size(b);
+        double *const lw = lw_ + block_.first(b);
+        double *const w = w_ + block_.first(b);
+        for (std::size_t i = 0; i != n; ++i)
+            lw[i] -= shift_;
+        math::vExp(n, lw, w);
+        if (sum_ != VSMC_NULLPTR) {
+            double s = 0;
+            double s2 = 0;
+            for (std::size_t i = 0; i != n; ++i) {
+                s += w[i];
+                s2 += w[i] * w[i];
+            }
+            sum_[b] = s;
+            sum2_[b] = s2;
+        }
+    }
+
+    private :
+
+    const ParallelWeightBlock block_;
+    const double shift_;
+    double *const lw_;
+    double *const w_;
+    double *const sum_;
+    double *const sum2_;
+}; // class ParallelWeightExp
+
+// lw = log(w)
+class ParallelWeightLog
+{
+    public :
+
+    ParallelWeightLog (ParallelWeightBlock block, const double *w,
+            double *lw) : block_(block), w_(w), lw_(lw) {}
+
+    void operator() (std::size_t b) const
+    {
+        const std::size_t f = block_.first(b);
+        math::vLn(block_.size(b), w_ + f, lw_ + f);
+    }
+
+    private :
+
+    const ParallelWeightBlock block_;
+    const double *const w_;
+    double *const lw_;
+}; // class ParallelWeightLog
+
+// x += shift
+class ParallelWeightShift
+{
+    public :
+
+    ParallelWeightShift (ParallelWeightBlock block, double shift, double *x) :
+        block_(block), shift_(shift), x_(x) {}
+
+    void operator() (std::size_t b) const
+    {
+        const std::size_t n = block_.size(b);
+        double *const x = x_ + block_.first(b);
+        for (std::size_t i = 0; i != n; ++i)
+            x[i] += shift_;
+    }
+
+    private :
+
+    const ParallelWeightBlock block_;
+    const double shift_;
+    double *const x_;
+}; // class ParallelWeightShift
+
+// x *= coeff
+class ParallelWeightScale
+{
+    public :
+
+    ParallelWeightScale (ParallelWeightBlock block, double coeff, double *x) :
+        block_(block), coeff_(coeff), x_(x) {}
+
+    void operator() (std::size_t b) const
+    {math::scal(block_.size(b), coeff_, x_ + block_.first(b));}
+
+    private :
+
+    const ParallelWeightBlock block_;
+    const double coeff_;
+    double *const x_;
+}; // class ParallelWeightScale
+
+// With v = w * y, or v = exp(lw + y - shift) if use_log, sum[b] = sum(v),
+// sum2[b] = sum(v^2), or sum2[b] = sum(w * y^2) if cess. If y is null, it is
+// taken as one. The exponentials of a block are computed with one call of
+// math::vExp into a buffer on the stack.
+class ParallelWeightSum
+{
+    public :
+
+    ParallelWeightSum (ParallelWeightBlock block, const double *w,
+            const double *y, bool use_log, bool cess, double shift,
+            double *sum, double *sum2) :
+        block_(block), w_(w), y_(y), use_log_(use_log), cess_(cess),
+        shift_(shift), sum_(sum), sum2_(sum2) {}
+
+    void operator() (std::size_t b) const
+    {
+        const std::size_t n = block_.size(b);
+        const double *const w = w_ + block_.first(b);
+        double s = 0;
+        double s2 = 0;
+        if (y_ == VSMC_NULLPTR) {
+            for (std::size_t i = 0; i != n; ++i) {
+                s += w[i];
+                s2 += w[i] * w[i];
+            }
+        } else if (use_log_) {
+            const double *const y = y_ + block_.first(b);
+            double u[VSMC_WEIGHT_SET_BLOCK_SIZE];
+            if (cess_) {
+                math::vExp(n, y, u);
+                for (std::size_t i = 0; i != n; ++i) {
+                    const double v = w[i] * u[i];
+                    s += v;
+                    s2 += v * u[i];
+                }
+            } else {
+                for (std::size_t i = 0; i != n; ++i)
+                    u[i] = w[i] + y[i] - shift_;
+                math::vExp(n, u, u);
+                for (std::size_t i = 0; i != n; ++i) {
+                    s += u[i];
+                    s2 += u[i] * u[i];
+                }
+            }
+        } else {
+            const double *const y = y_ + block_.first(b);
+            for (std::size_t i = 0; i != n; ++i) {
+                const double v = w[i] * y[i];
+                s += v;
+                s2 += cess_ ? v * y[i] : v * v;
+            }
+        }
+        sum_[b] = s;
+        sum2_[b] = s2;
+    }
+
+    private :
+
+    const ParallelWeightBlock block_;
+    const double *const w_;
+    const double *const y_;
+    const bool use_log_;
+    const bool cess_;
+    const double shift_;
+    double *const sum_;
+    double *const sum2_;
+}; // class ParallelWeightSum
+
+// dst = src
+class ParallelWeightCopy
+{
+    public :
+
+    ParallelWeightCopy (ParallelWeightBlock block, const double *src,
+            double *dst) : block_(block), src_(src), dst_(dst) {}
+
+    void operator() (std::size_t b) const
+    {
+        const std::size_t f = block_.first(b);
+        std::memcpy(dst_ + f, src_ + f, sizeof(double) * block_.size(b));
+    }
+
+    private :
+
+    const ParallelWeightBlock block_;
+    const double *const src_;
+    double *const dst_;
+}; // class ParallelWeightCopy
+
+// shift[2 * b] and shift[2 * b + 1] = WeightSet::ess_batch_max within block b
+class ParallelWeightBatchMax
+{
+    public :
+
+    ParallelWeightBatchMax (ParallelWeightBlock block, const double *lw,
+            const double *first, double alpha, double step, bool use_cess,
+            double *shift) :
+        block_(block), lw_(lw), first_(first), alpha_(alpha), step_(step),
+        use_cess_(use_cess), shift_(shift) {}
+
+    void operator() (std::size_t b) const
+    {
+        const std::size_t f = block_.first(b);
+        WeightSet::ess_batch_max(block_.size(b), lw_ + f, first_ + f,
+                alpha_, step_, shift_ + 2 * b, use_cess_);
+    }
+
+    private :
+
+    const ParallelWeightBlock block_;
+    const double *const lw_;
+    const double *const first_;
+    const double alpha_;
+    const double step_;
+    const bool use_cess_;
+    double *const shift_;
+}; // class ParallelWeightBatchMax
+
+// sum[b * K + k] and sum2[b * K + k] = WeightSet::ess_batch_sum within block
+// b, where K = VSMC_WEIGHT_SET_BISECT_NUM
+class ParallelWeightBatchSum
+{
+    public :
+
+    ParallelWeightBatchSum (ParallelWeightBlock block, const double *w,
+            const double *lw, const double *first, std::size_t n,
+            double alpha, double step, const double *shift, bool use_cess,
+            double *sum, double *sum2) :
+        block_(block), w_(w), lw_(lw), first_(first), n_(n), alpha_(alpha),
+        step_(step), shift_(shift), use_cess_(use_cess), sum_(sum),
+        sum2_(sum2) {}
+
+    void operator() (std::size_t b) const
+    {
+        const std::size_t K = VSMC_WEIGHT_SET_BISECT_NUM;
+        const std::size_t f = block_.first(b);
+        WeightSet::ess_batch_sum(block_.size(b), w_ + f, lw_ + f, first_ + f,
+                n_, alpha_, step_, shift_, sum_ + b * K, sum2_ + b * K,
+                use_cess_);
+    }
+
+    private :
+
+    const ParallelWeightBlock block_;
+    const double *const w_;
+    const double *const lw_;
+    const double *const first_;
+    const std::size_t n_;
+    const double alpha_;
+    const double step_;
+    const double *const shift_;
+    const bool use_cess_;
+    double *const sum_;
+    double *const sum2_;
+}; // class ParallelWeightBatchSum
+
+/// \brief Weight set with operations parallelized over blocks of weights
+/// \ingroup SMP
+///
+/// \details
+/// `Derived` shall provide a member function
+/// ~~~{.cpp}
+/// template <typename WorkType>
+/// void parallel_run (std::size_t n, const WorkType &work) const;
+/// ~~~
+/// which calls `work(b)` for each `b` in `[0, n)`, in any order and possibly
+/// in parallel.
+template <typename WeightSetBase, typename Derived>
+class WeightSetSMP : public WeightSetBase
+{
+    public :
+
+    typedef typename WeightSetBase::size_type size_type;
+
+    explicit WeightSetSMP (size_type N) : WeightSetBase(N) {}
+
+    void read_resample_weight (double *first) const
+    {
+        const ParallelWeightBlock block(this->size());
+        run(block, ParallelWeightCopy(block, this->weight_data(), first));
+    }
+
+    protected :
+
+    // The fused path is taken only if no derived class of Derived may have
+    // overridden normalize_log_weight, log_weight2weight or normalize_weight
+    void post_set_log_weight ()
+    {
+        if (typeid(*this) != typeid(Derived)) {
+            this->normalize_log_weight();
+            this->log_weight2weight();
+            this->normalize_weight();
+            return;
+        }
+        if (this->size() == 0) {
+            this->set_ess(0);
+            return;
+        }
+
+        double *const lwptr = this->mutable_log_weight_data();
+        double *const wptr = this->mutable_weight_data();
+        double sum[2];
+        weight_exp(weight_max(lwptr, VSMC_NULLPTR), lwptr, wptr, sum);
+        weight_scale(1 / sum[0], wptr);
+        this->set_ess(sum[0] * sum[0] / sum[1]);
+    }
+
+    void log_weight2weight ()
+    {
+        const ParallelWeightBlock block(this->size());
+        run(block, ParallelWeightExp(block, 0,
+                    this->mutable_log_weight_data(),
+                    this->mutable_weight_data(), VSMC_NULLPTR, VSMC_NULLPTR));
+    }
+
+    void weight2log_weight ()
+    {
+        const ParallelWeightBlock block(this->size());
+        run(block, ParallelWeightLog(block, this->weight_data(),
+                    this->mutable_log_weight_data()));
+    }
+
+    void normalize_log_weight ()
+    {
+        double *const lwptr = this->mutable_log_weight_data();
+        weight_shift(-weight_max(lwptr, VSMC_NULLPTR), lwptr);
+    }
+
+    void normalize_weight ()
+    {
+        double *const wptr = this->mutable_weight_data();
+        double sum[2];
+        weight_sum(wptr, VSMC_NULLPTR, false, false, 0, sum);
+        weight_scale(1 / sum[0], wptr);
+        this->set_ess(sum[0] * sum[0] / sum[1]);
+    }
+
+    double compute_ess (const double *first, bool use_log) const
+    {
+        double dmax = 0;
+        const double *wptr = this->weight_data();
+        if (use_log) {
+            wptr = this->log_weight_data();
+            dmax = weight_max(wptr, first);
+        }
+        double sum[2];
+        weight_sum(wptr, first, use_log, false, dmax, sum);
+
+        return sum[0] * sum[0] / sum[1];
+    }
+
+    double compute_cess (const double *first, bool use_log) const
+    {
+        double sum[2];
+        weight_sum(this->weight_data(), first, use_log, true, 0, sum);
+
+        return sum[0] * sum[0] / sum[1];
+    }
+
+    void compute_ess_batch (const double *first, std::size_t n,
+            double alpha, double step, double *res, bool use_cess) const
+    {
+        const std::size_t K = VSMC_WEIGHT_SET_BISECT_NUM;
+        double shift[2];
+        double sum[K];
+        double sum2[K];
+        for (std::size_t k0 = 0; k0 < n; k0 += K) {
+            const std::size_t m = n - k0 < K ? n - k0 : K;
+            const double a = alpha + step * static_cast<double>(k0);
+            weight_batch_max(first, a, step, shift, use_cess);
+            weight_batch_sum(first, m, a, step, shift, sum, sum2, use_cess);
+            for (std::size_t k = 0; k != m; ++k) {
+                if (!(sum[k] > WeightSetBase::ess_batch_min())) {
+                    const double ak = a + step * static_cast<double>(k);
+                    weight_batch_max(first, ak, 0, shift, use_cess);
+                    weight_batch_sum(first, 1, ak, 0, shift,
+                            sum + k, sum2 + k, use_cess);
+                }
+                res[k0 + k] = sum[k] * sum[k] / sum2[k];
+            }
+        }
+    }
+
+    double weight_max (const double *x, const double *y) const
+    {
+        const ParallelWeightBlock block(this->size());
+        if (block.num() == 0)
+            return -std::numeric_limits<double>::max VSMC_MNE ();
+
+        std::vector<double> &res = partial(block, sum_);
+        run(block, ParallelWeightMax(block, x, y, &res[0]));
+
+        return reduce_max(res);
+    }
+
+    void weight_exp (double shift, double *lw, double *w, double *sum) const
+    {
+        const ParallelWeightBlock block(this->size());
+        std::vector<double> &sum1 = partial(block, sum_);
+        std::vector<double> &sum2 = partial(block, sum2_);
+        if (block.num() != 0) {
+            run(block, ParallelWeightExp(block, shift, lw, w,
+                        &sum1[0], &sum2[0]));
+        }
+        sum[0] = reduce_sum(sum1);
+        sum[1] = reduce_sum(sum2);
+    }
+
+    void weight_shift (double shift, double *x) const
+    {
+        const ParallelWeightBlock block(this->size());
+        run(block, ParallelWeightShift(block, shift, x));
+    }
+
+    void weight_scale (double coeff, double *x) const
+    {
+        const ParallelWeightBlock block(this->size());
+        run(block, ParallelWeightScale(block, coeff, x));
+    }
+
+    void weight_sum (const double *w, const double *y, bool use_log,
+            bool cess, double shift, double *sum) const
+    {
+        const ParallelWeightBlock block(this->size());
+        std::vector<double> &sum1 = partial(block, sum_);
+        std::vector<double> &sum2 = partial(block, sum2_);
+        if (block.num() != 0) {
+            run(block, ParallelWeightSum(block, w, y, use_log, cess, shift,
+                        &sum1[0], &sum2[0]));
+        }
+        sum[0] = reduce_sum(sum1);
+        sum[1] = reduce_sum(sum2);
+    }
+
+    void weight_batch_max (const double *first, double alpha, double step,
+            double *shift, bool use_cess) const
+    {
+        const ParallelWeightBlock block(this->size());
+        shift[0] = -std::numeric_limits<double>::max VSMC_MNE ();
+        shift[1] = -std::numeric_limits<double>::max VSMC_MNE ();
+        if (block.num() == 0)
+            return;
+
+        sum_.resize(block.num() * 2);
+        run(block, ParallelWeightBatchMax(block, this->log_weight_data(),
+                    first, alpha, step, use_cess, &sum_[0]));
+        for (std::size_t b = 0; b != block.num(); ++b) {
+            if (shift[0] < sum_[2 * b])
+                shift[0] = sum_[2 * b];
+            if (shift[1] < sum_[2 * b + 1])
+                shift[1] = sum_[2 * b + 1];
+        }
+    }
+
+    void weight_batch_sum (const double *first, std::size_t n, double alpha,
+            double step, const double *shift, double *sum, double *sum2,
+            bool use_cess) const
+    {
+        const std::size_t K = VSMC_WEIGHT_SET_BISECT_NUM;
+        const ParallelWeightBlock block(this->size());
+        std::fill_n(sum, n, 0.0);
+        std::fill_n(sum2, n, 0.0);
+        if (block.num() == 0)
+            return;
+
+        sum_.resize(block.num() * K);
+        sum2_.resize(block.num() * K);
+        run(block, ParallelWeightBatchSum(block, this->weight_data(),
+                    this->log_weight_data(), first, n, alpha, step, shift,
+                    use_cess, &sum_[0], &sum2_[0]));
+        for (std::size_t b = 0; b != block.num(); ++b) {
+            for (std::size_t k = 0; k != n; ++k) {
+                sum[k] += sum_[b * K + k];
+                sum2[k] += sum2_[b * K + k];
+            }
+        }
+    }
+
+    private :
+
+    mutable std::vector<double> sum_;
+    mutable std::vector<double> sum2_;
+
+    static std::vector<double> &partial (const ParallelWeightBlock &block,
+            std::vector<double> &res)
+    {
+        res.resize(block.num());
+
+        return res;
+    }
+
+    template <typename WorkType>
+    void run (const ParallelWeightBlock &block, const WorkType &work) const
+    {
+        if (block.num() != 0) {
+            static_cast<const Derived *>(this)->parallel_run(
+                    block.num(), work);
+        }
+    }
+
+    static double reduce_max (const std::vector<double> &res)
+    {
+        double dmax = res[0];
+        for (std::size_t i = 0; i != res.size(); ++i)
+            if (dmax < res[i])
+                dmax = res[i];
+
+        return dmax;
+    }
+
+    static double reduce_sum (const std::vector<double> &res)
+    {
+        double s = 0;
+        for (std::size_t i = 0; i != res.size(); ++i)
+            s += res[i];
+
+        return s;
+    }
+}; // class WeightSetSMP
+
+} // namespace vsmc::internal
+
+} // namespace vsmc
+
+#endif // VSMC_SMP_INTERNAL_PARALLEL_WEIGHT_HPP
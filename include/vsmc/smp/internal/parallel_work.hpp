@@ -33,8 +33,23 @@
 #define VSMC_SMP_INTERNAL_PARALLEL_WORK_HPP
 
 #include <vsmc/internal/common.hpp>
+#include <vsmc/smp/backend_base.hpp>
 #include <vsmc/core/particle.hpp>
 #include <vsmc/core/single_particle.hpp>
+#include <vsmc/utility/aligned_memory.hpp>
+
+/// \brief Number of particles in each block of integrated Monitor evaluation
+/// \ingroup Config
+#ifndef VSMC_MONITOR_INTEGRATE_BLOCK_SIZE
+#define VSMC_MONITOR_INTEGRATE_BLOCK_SIZE 1024
+#endif
+
+/// \brief Number of particles evaluated at a time within each block of
+/// integrated Monitor evaluation
+/// \ingroup Config
+#ifndef VSMC_MONITOR_INTEGRATE_CHUNK_SIZE
+#define VSMC_MONITOR_INTEGRATE_CHUNK_SIZE 32
+#endif
 
 namespace vsmc {
 
@@ -53,7 +68,8 @@ class ParallelCopyParticle
     public :
 
     ParallelCopyParticle (T *state, const IntType *copy_from) :
-        state_(state), copy_from_(copy_from) {}
+        state_(state), copy_from_(copy_from),
+        gather_(ParallelCopyBuffer<T>::gather(state)) {}
 
     template <typename SizeType>
     typename cxx11::enable_if<cxx11::is_integral<SizeType>::value>::type
@@ -61,6 +77,11 @@ class ParallelCopyParticle
     {
         typedef typename traits::SizeTypeTrait<T>::type size_type;
 
+        if (gather_) {
+            ParallelCopyBuffer<T>::copy(state_, id, id + 1, copy_from_);
+            return;
+        }
+
         state_->copy_particle(
                 static_cast<size_type>(copy_from_[id]),
                 static_cast<size_type>(id));
@@ -77,14 +98,23 @@ class ParallelCopyParticle
             static_cast<const_iterator>(range.begin());
         const const_iterator end =
             static_cast<const_iterator>(range.end());
+        if (gather_) {
+            ParallelCopyBuffer<T>::copy(state_, begin, end, copy_from_);
+            return;
+        }
+
         for (const_iterator id = begin; id != end; ++id)
             operator()(id);
     }
 
+    // Called after all particles are copied
+    void finish () const {ParallelCopyBuffer<T>::swap(state_);}
+
     private :
 
     T *const state_;
     const IntType *const copy_from_;
+    const bool gather_;
 }; // class ParallelCopyParticle
 
 template <typename T, typename InitType>
@@ -114,15 +144,11 @@ class ParallelInitializeState
     typename cxx11::enable_if<!cxx11::is_integral<RangeType>::value>::type
     operator() (const RangeType &range)
     {
-        typedef typename traits::RangeTypeConstIteratorTrait<RangeType>::type
-            const_iterator;
+        typedef typename traits::SizeTypeTrait<T>::type size_type;
 
-        const const_iterator begin =
-            static_cast<const_iterator>(range.begin());
-        const const_iterator end =
-            static_cast<const_iterator>(range.end());
-        for (const_iterator id = begin; id != end; ++id)
-            operator()(id);
+        accept_ += init_->initialize_range(
+                static_cast<size_type>(range.begin()),
+                static_cast<size_type>(range.end()), *particle_);
     }
 
     void join (const ParallelInitializeState<T, InitType> &other)
@@ -168,15 +194,9 @@ class ParallelMoveState
     typename cxx11::enable_if<!cxx11::is_integral<RangeType>::value>::type
     operator() (const RangeType &range)
     {
-        typedef typename traits::RangeTypeConstIteratorTrait<RangeType>::type
-            const_iterator;
-
-        const const_iterator begin =
-            static_cast<const_iterator>(range.begin());
-        const const_iterator end =
-            static_cast<const_iterator>(range.end());
-        for (const_iterator id = begin; id != end; ++id)
-            operator()(id);
+        accept_ += move_->move_range(iter_,
+                static_cast<size_type>(range.begin()),
+                static_cast<size_type>(range.end()), *particle_);
     }
 
     void join (const ParallelMoveState<T, MoveType> &other)
@@ -214,6 +234,87 @@ class ParallelMonitorState
                 res_ + id * dim_);
     }
 
+    template <typename RangeType>
+    typename cxx11::enable_if<!cxx11::is_integral<RangeType>::value>::type
+    operator() (const RangeType &range) const
+    {
+        typedef typename traits::SizeTypeTrait<T>::type size_type;
+
+        const size_type first = static_cast<size_type>(range.begin());
+        const size_type last = static_cast<size_type>(range.end());
+        monitor_->monitor_range(iter_, dim_, first, last, *particle_,
+                res_ + static_cast<std::size_t>(first) * dim_);
+    }
+
+    private :
+
+    MonitorEvalType *const monitor_;
+    const std::size_t iter_;
+    const std::size_t dim_;
+    const Particle<T> *const particle_;
+    double *const res_;
+}; // class ParallelMonitorState
+
+// Evaluate particles within block b and integrate the results against the
+// weights into partial[b * dim], ..., partial[b * dim + dim - 1]. Particles
+// are evaluated in small chunks, thus only the partial sums of each block,
+// instead of the N by dim matrix of results, are stored. The partial sums
+// are combined in block order by finish() and the results do not depend on
+// the number of threads
+template <typename T, typename MonitorEvalType>
+class ParallelMonitorIntegrate
+{
+    public :
+
+    typedef std::vector<double, AlignedAllocator<double> > partial_type;
+
+    ParallelMonitorIntegrate (MonitorEvalType *monitor,
+            std::size_t iter, std::size_t dim,
+            const Particle<T> *particle, const double *weight,
+            partial_type &partial) :
+        monitor_(monitor), iter_(iter), dim_(dim), particle_(particle),
+        weight_(weight),
+        N_(static_cast<std::size_t>(particle->size())),
+        num_((N_ + VSMC_MONITOR_INTEGRATE_BLOCK_SIZE - 1) /
+                VSMC_MONITOR_INTEGRATE_BLOCK_SIZE)
+    {
+        partial.resize(num_ * dim_);
+        partial_ = partial.size() == 0 ? VSMC_NULLPTR : &partial[0];
+    }
+
+    // Number of blocks
+    std::size_t num () const {return num_;}
+
+    template <typename SizeType>
+    typename cxx11::enable_if<cxx11::is_integral<SizeType>::value>::type
+    operator() (SizeType b) const
+    {
+        typedef typename traits::SizeTypeTrait<T>::type size_type;
+
+        const std::size_t chunk = VSMC_MONITOR_INTEGRATE_CHUNK_SIZE;
+        const std::size_t first =
+            static_cast<std::size_t>(b) * VSMC_MONITOR_INTEGRATE_BLOCK_SIZE;
+        const std::size_t last =
+            N_ - first < VSMC_MONITOR_INTEGRATE_BLOCK_SIZE ?
+            N_ : first + VSMC_MONITOR_INTEGRATE_BLOCK_SIZE;
+        double *const part = partial_ + static_cast<std::size_t>(b) * dim_;
+        std::fill(part, part + dim_, 0.0);
+        std::vector<double, AlignedAllocator<double> > buffer(
+                (last - first < chunk ? last - first : chunk) * dim_);
+        for (std::size_t f = first; f < last; f += chunk) {
+            const std::size_t l = last - f < chunk ? last : f + chunk;
+            monitor_->monitor_range(iter_, dim_,
+                    static_cast<size_type>(f), static_cast<size_type>(l),
+                    *particle_, &buffer[0]);
+            const double *r = &buffer[0];
+            for (std::size_t i = f; i != l; ++i, r += dim_) {
+                const double w = weight_[i];
+                for (std::size_t d = 0; d != dim_; ++d)
+                    part[d] += w * r[d];
+            }
+        }
+    }
+
     template <typename RangeType>
     typename cxx11::enable_if<!cxx11::is_integral<RangeType>::value>::type
     operator() (const RangeType &range) const
@@ -225,8 +326,18 @@ class ParallelMonitorState
             static_cast<const_iterator>(range.begin());
         const const_iterator end =
             static_cast<const_iterator>(range.end());
-        for (const_iterator id = begin; id != end; ++id)
-            operator()(id);
+        for (const_iterator b = begin; b != end; ++b)
+            operator()(b);
+    }
+
+    // Called after all blocks are evaluated
+    void finish (double *res) const
+    {
+        std::fill(res, res + dim_, 0.0);
+        const double *part = partial_;
+        for (std::size_t b = 0; b != num_; ++b, part += dim_)
+            for (std::size_t d = 0; d != dim_; ++d)
+                res[d] += part[d];
     }
 
     private :
@@ -235,8 +346,11 @@ class ParallelMonitorState
     const std::size_t iter_;
     const std::size_t dim_;
     const Particle<T> *const particle_;
-    double *const res_;
-}; // class ParallelMonitorState
+    const double *const weight_;
+    const std::size_t N_;
+    const std::size_t num_;
+    double *partial_;
+}; // class ParallelMonitorIntegrate
 
 template <typename T, typename PathEvalType>
 class ParallelPathState
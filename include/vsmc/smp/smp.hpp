@@ -56,6 +56,7 @@
 
 #if VSMC_HAS_CXX11LIB_THREAD
 #include <vsmc/smp/backend_std.hpp>
+#include <vsmc/smp/backend_steal.hpp>
 #endif
 
 #if VSMC_HAS_TBB
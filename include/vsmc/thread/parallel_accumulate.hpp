@@ -34,12 +34,37 @@
 
 #include <vsmc/internal/common.hpp>
 #include <vsmc/thread/blocked_range.hpp>
-#include <vsmc/thread/thread_guard.hpp>
 #include <vsmc/thread/thread_num.hpp>
-#include <thread>
+#include <vsmc/thread/thread_pool.hpp>
 
 namespace vsmc {
 
+namespace internal {
+
+template <typename Range, typename T, typename WorkType>
+class ParallelAccumulateTask
+{
+    public :
+
+    ParallelAccumulateTask (const std::vector<Range> &range_vec,
+            std::vector<T> &result, const WorkType &work) :
+        range_vec_(range_vec), result_(result), work_(work) {}
+
+    void operator() (std::size_t i) const
+    {
+        WorkType work(work_);
+        work(range_vec_[i], result_[i]);
+    }
+
+    private :
+
+    const std::vector<Range> &range_vec_;
+    std::vector<T> &result_;
+    const WorkType &work_;
+}; // class ParallelAccumulateTask
+
+} // namespace vsmc::internal
+
 /// \brief Parallel accumulate using C++11 concurrency
 /// \ingroup Thread
 ///
@@ -52,19 +77,14 @@ namespace vsmc {
 template <typename Range, typename T, typename WorkType>
 inline T parallel_accumulate (const Range &range, WorkType &&work, T init)
 {
+    typedef typename cxx11::decay<WorkType>::type work_type;
+
     std::vector<Range> range_vec(ThreadNum::instance().partition(range));
     std::vector<T> result(range_vec.size());
-    // start parallelization
-    {
-        std::vector<ThreadGuard<std::thread>> tg;
-        tg.reserve(range_vec.size());
-        for (std::size_t i = 0; i != range_vec.size(); ++i) {
-            tg.push_back(ThreadGuard<std::thread>(std::thread(
-                            std::forward<WorkType>(work),
-                            range_vec[i], std::ref(result[i]))));
-        }
-    }
-    // stop parallelization
+    const work_type &w = work;
+    internal::ParallelAccumulateTask<Range, T, work_type> task(
+            range_vec, result, w);
+    ThreadPool::instance().run(range_vec.size(), task);
     T acc(init);
     for (std::size_t i = 0; i != result.size(); ++i)
         acc += result[i];
@@ -85,19 +105,14 @@ template <typename Range, typename T, typename Bin, typename WorkType>
 inline T parallel_accumulate (const Range &range, WorkType &&work,
         T init, Bin bin_op)
 {
+    typedef typename cxx11::decay<WorkType>::type work_type;
+
     std::vector<Range> range_vec(ThreadNum::instance().partition(range));
     std::vector<T> result(range_vec.size());
-    // start parallelization
-    {
-        std::vector<ThreadGuard<std::thread>> tg;
-        tg.reserve(range_vec.size());
-        for (std::size_t i = 0; i != range_vec.size(); ++i) {
-            tg.push_back(ThreadGuard<std::thread>(std::thread(
-                            std::forward<WorkType>(work),
-                            range_vec[i], std::ref(result[i]))));
-        }
-    }
-    // stop parallelization
+    const work_type &w = work;
+    internal::ParallelAccumulateTask<Range, T, work_type> task(
+            range_vec, result, w);
+    ThreadPool::instance().run(range_vec.size(), task);
     T acc(init);
     for (std::size_t i = 0; i != result.size(); ++i)
         acc = bin_op(acc, result[i]);
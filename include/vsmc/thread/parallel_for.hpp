@@ -34,12 +34,35 @@
 
 #include <vsmc/internal/common.hpp>
 #include <vsmc/thread/blocked_range.hpp>
-#include <vsmc/thread/thread_guard.hpp>
 #include <vsmc/thread/thread_num.hpp>
-#include <thread>
+#include <vsmc/thread/thread_pool.hpp>
 
 namespace vsmc {
 
+namespace internal {
+
+template <typename Range, typename WorkType>
+class ParallelForTask
+{
+    public :
+
+    ParallelForTask (const std::vector<Range> &range_vec,
+            const WorkType &work) : range_vec_(range_vec), work_(work) {}
+
+    void operator() (std::size_t i) const
+    {
+        WorkType work(work_);
+        work(range_vec_[i]);
+    }
+
+    private :
+
+    const std::vector<Range> &range_vec_;
+    const WorkType &work_;
+}; // class ParallelForTask
+
+} // namespace vsmc::internal
+
 /// \brief Parallel for using std::thread
 /// \ingroup Thread
 ///
@@ -49,18 +72,17 @@ namespace vsmc {
 /// WorkType work;
 /// work(range);
 /// ~~~
+/// Each partition of the range is processed by a copy of `work`, using the
+/// persistent threads of ThreadPool
 template <typename Range, typename WorkType>
 inline void parallel_for (const Range &range, WorkType &&work)
 {
+    typedef typename cxx11::decay<WorkType>::type work_type;
+
     std::vector<Range> range_vec(ThreadNum::instance().partition(range));
-    std::vector<ThreadGuard<std::thread>> tg;
-    tg.reserve(range_vec.size());
-    {
-        for (std::size_t i = 0; i != range_vec.size(); ++i) {
-            tg.push_back(ThreadGuard<std::thread>(std::thread(
-                            std::forward<WorkType>(work), range_vec[i])));
-        }
-    }
+    const work_type &w = work;
+    internal::ParallelForTask<Range, work_type> task(range_vec, w);
+    ThreadPool::instance().run(range_vec.size(), task);
 }
 
 } // namespace vsmc
@@ -34,12 +34,32 @@
 
 #include <vsmc/internal/common.hpp>
 #include <vsmc/thread/blocked_range.hpp>
-#include <vsmc/thread/thread_guard.hpp>
 #include <vsmc/thread/thread_num.hpp>
-#include <thread>
+#include <vsmc/thread/thread_pool.hpp>
 
 namespace vsmc {
 
+namespace internal {
+
+template <typename Range, typename WorkType>
+class ParallelReduceTask
+{
+    public :
+
+    ParallelReduceTask (const std::vector<Range> &range_vec,
+            std::vector<WorkType> &work_vec) :
+        range_vec_(range_vec), work_vec_(work_vec) {}
+
+    void operator() (std::size_t i) const {work_vec_[i](range_vec_[i]);}
+
+    private :
+
+    const std::vector<Range> &range_vec_;
+    std::vector<WorkType> &work_vec_;
+}; // class ParallelReduceTask
+
+} // namespace vsmc::internal
+
 /// \brief Parallel reduce using C++11 concurrency
 /// \ingroup Thread
 ///
@@ -55,14 +75,8 @@ inline void parallel_reduce (const Range &range, WorkType &work)
 {
     std::vector<Range> range_vec(ThreadNum::instance().partition(range));
     std::vector<WorkType> work_vec(range_vec.size(), work);
-    {
-        std::vector<ThreadGuard<std::thread>> tg;
-        tg.reserve(range_vec.size());
-        for (std::size_t i = 0; i != range_vec.size(); ++i) {
-            tg.push_back(ThreadGuard<std::thread>(std::thread(
-                            std::ref(work_vec[i]), range_vec[i])));
-        }
-    }
+    internal::ParallelReduceTask<Range, WorkType> task(range_vec, work_vec);
+    ThreadPool::instance().run(range_vec.size(), task);
     for (std::size_t i = 0; i != work_vec.size(); ++i) work.join(work_vec[i]);
 }
 
@@ -41,5 +41,7 @@
 #include <vsmc/thread/parallel_repeat.hpp>
 #include <vsmc/thread/thread_guard.hpp>
 #include <vsmc/thread/thread_num.hpp>
+#include <vsmc/thread/thread_pool.hpp>
+#include <vsmc/thread/work_steal.hpp>
 
 #endif // VSMC_THREAD_THREAD_HPP
@@ -0,0 +1,383 @@
+//============================================================================
+// vSMC/include/vsmc/thread/thread_pool.hpp
+//----------------------------------------------------------------------------
+//                         vSMC: Scalable Monte Carlo
+//----------------------------------------------------------------------------
+// Copyright (c) 2013-2015, Yan Zhou
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//   Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+//   Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//============================================================================
+
+#ifndef VSMC_THREAD_THREAD_POOL_HPP
+#define VSMC_THREAD_THREAD_POOL_HPP
+
+#include <vsmc/internal/common.hpp>
+#include <vsmc/thread/thread_num.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+/// \brief Default number of polls of a worker before it parks itself
+/// \ingroup Config
+#ifndef VSMC_THREAD_POOL_SPIN
+#define VSMC_THREAD_POOL_SPIN 16384
+#endif
+
+namespace vsmc {
+
+/// \brief Persistent pool of worker threads with fork/join dispatch
+/// \ingroup Thread
+///
+/// \details
+/// The pool has `ThreadNum::instance().thread_num() - 1` workers. The calling
+/// thread of `run` participates in the work and thus the total number of
+/// threads working is the same as `ThreadNum`. If the number in `ThreadNum`
+/// is changed, the workers are recreated upon the next call to `run`.
+///
+/// Between dispatches, an idle worker polls for new work for a number of
+/// times (see `spin`) before it parks itself on a condition variable. Thus
+/// back to back dispatches, such as those in each iteration of a sampler, do
+/// not pay the cost of waking up threads while idle periods do not burn CPU
+/// time. The calling thread of `run` waits for the workers to finish in the
+/// same way.
+///
+/// If `run` is called while the pool is busy, for example, by a nested
+/// `parallel_for` within a task or from another user thread, the work is
+/// executed by the calling thread sequentially. Nested calls are detected by
+/// a thread local flag set while a thread executes tasks of the pool, and
+/// thus never block or lock the pool again.
+///
+/// The environment variable `VSMC_THREAD_PIN`, if set to a non-zero value,
+/// enables pinning the workers to cores upon the creation of the pool (Linux
+/// only). It can also be changed later by `pin`.
+class ThreadPool
+{
+    public :
+
+    static ThreadPool &instance ()
+    {
+        static ThreadPool pool;
+
+        return pool;
+    }
+
+    /// \brief Total number of threads working in `run`, including the caller
+    std::size_t size () const {return workers_.size() + 1;}
+
+    /// \brief Number of polls before an idle worker parks itself
+    std::size_t spin () const {return spin_.load();}
+
+    /// \brief Set the number of polls before an idle worker parks itself,
+    /// return the old number
+    std::size_t spin (std::size_t num) {return spin_.exchange(num);}
+
+    /// \brief If workers are pinned to cores
+    bool pin () const {return pin_;}
+
+    /// \brief Pin or unpin workers, return the old setting
+    ///
+    /// \details
+    /// When pinned, the `i`th worker is bound to core `i + 1` (modulo the
+    /// number of hardware threads), leaving the first core to the thread
+    /// calling `run`, which is not pinned by the pool. On platforms other
+    /// than Linux, this has no effect. Called within a task of the pool, it
+    /// has no effect either, since the workers cannot be restarted while they
+    /// are running.
+    bool pin (bool flag)
+    {
+        if (inside())
+            return pin_;
+
+        std::lock_guard<std::mutex> lock(run_mutex_);
+        bool old = pin_;
+        if (old != flag) {
+            pin_ = flag;
+            stop_workers();
+            start_workers(ThreadNum::instance().thread_num());
+        }
+
+        return old;
+    }
+
+    /// \brief Call `work(i)` for `i` in `[0, n)` in parallel and return when
+    /// all calls finish
+    ///
+    /// \details
+    /// Tasks are taken by the threads dynamically. All workers join before
+    /// `run` returns, even those that find no task left. The first exception
+    /// thrown by any task, if any, is rethrown by `run` after all tasks
+    /// finish.
+    template <typename WorkType>
+    void run (std::size_t n, WorkType &work)
+    {
+        if (n == 0)
+            return;
+
+        if (inside() || n == 1) {
+            for (std::size_t i = 0; i != n; ++i)
+                work(i);
+            return;
+        }
+
+        std::unique_lock<std::mutex> lock(run_mutex_, std::try_to_lock);
+        if (!lock.owns_lock()) {
+            for (std::size_t i = 0; i != n; ++i)
+                work(i);
+            return;
+        }
+        InsideGuard guard;
+
+        if (ThreadNum::instance().thread_num() != size()) {
+            stop_workers();
+            start_workers(ThreadNum::instance().thread_num());
+        }
+
+        if (workers_.size() == 0) {
+            for (std::size_t i = 0; i != n; ++i)
+                work(i);
+            return;
+        }
+
+        task_ = &ThreadPool::task<WorkType>;
+        work_ = static_cast<void *>(&work);
+        task_num_ = n;
+        task_next_.store(0);
+        finished_.store(0);
+        error_ = std::exception_ptr();
+        dispatch();
+        execute();
+        join();
+        task_ = VSMC_NULLPTR;
+        work_ = VSMC_NULLPTR;
+
+        if (error_)
+            std::rethrow_exception(error_);
+    }
+
+    private :
+
+    std::vector<std::thread> workers_;
+    std::atomic<std::size_t> spin_;
+    bool pin_;
+
+    std::mutex run_mutex_;
+    std::mutex park_mutex_;
+    std::condition_variable park_cv_;
+    std::condition_variable join_cv_;
+    std::atomic<std::size_t> parked_;
+    std::atomic<bool> joining_;
+    std::atomic<std::size_t> generation_;
+    std::atomic<bool> stop_;
+
+    void (*task_) (void *, std::size_t);
+    void *work_;
+    std::size_t task_num_;
+    std::atomic<std::size_t> task_next_;
+    std::atomic<std::size_t> finished_;
+    std::mutex error_mutex_;
+    std::exception_ptr error_;
+
+    ThreadPool () :
+        spin_(VSMC_THREAD_POOL_SPIN), pin_(false),
+        parked_(0), joining_(false), generation_(0), stop_(false),
+        task_(VSMC_NULLPTR), work_(VSMC_NULLPTR), task_num_(0),
+        task_next_(0), finished_(0)
+    {
+#ifdef VSMC_MSVC
+#pragma warning(push)
+#pragma warning(disable:4996)
+#endif
+        const char *pin_str = std::getenv("VSMC_THREAD_PIN");
+#ifdef VSMC_MSVC
+#pragma warning(pop)
+#endif
+        if (pin_str)
+            pin_ = std::atoi(pin_str) != 0;
+    }
+
+    ~ThreadPool () {stop_workers();}
+
+    ThreadPool (const ThreadPool &) = delete;
+    ThreadPool &operator= (const ThreadPool &) = delete;
+
+    // Set while the current thread owns the pool or executes its tasks
+    static bool &inside ()
+    {
+        static thread_local bool flag = false;
+
+        return flag;
+    }
+
+    class InsideGuard
+    {
+        public :
+
+        InsideGuard () {inside() = true;}
+        ~InsideGuard () {inside() = false;}
+    }; // class InsideGuard
+
+    template <typename WorkType>
+    static void task (void *work, std::size_t i)
+    {(*static_cast<WorkType *>(work))(i);}
+
+    void start_workers (std::size_t num)
+    {
+        stop_.store(false);
+        std::size_t gen = generation_.load();
+        for (std::size_t i = 1; i < num; ++i) {
+            workers_.push_back(std::thread(&ThreadPool::worker, this, gen));
+            if (pin_)
+                pin_thread(workers_.back(), i);
+        }
+    }
+
+    void stop_workers ()
+    {
+        if (workers_.size() == 0)
+            return;
+
+        stop_.store(true);
+        dispatch();
+        for (std::size_t i = 0; i != workers_.size(); ++i)
+            workers_[i].join();
+        workers_.clear();
+    }
+
+    // Start a new generation and wake up any parked workers. A worker only
+    // parks after incrementing parked_ and rechecking generation_ while
+    // holding park_mutex_, thus either it sees the new generation or we see
+    // it parked and notify it after it has started waiting.
+    void dispatch ()
+    {
+        generation_.fetch_add(1);
+        if (parked_.load() != 0) {
+            std::lock_guard<std::mutex> lock(park_mutex_);
+            park_cv_.notify_all();
+        }
+    }
+
+    void execute ()
+    {
+        const std::size_t n = task_num_;
+        std::size_t i = task_next_.fetch_add(1);
+        while (i < n) {
+            try {
+                task_(work_, i);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(error_mutex_);
+                if (!error_)
+                    error_ = std::current_exception();
+            }
+            i = task_next_.fetch_add(1);
+        }
+    }
+
+    void worker (std::size_t gen)
+    {
+        InsideGuard guard;
+        while (true) {
+            gen = wait(gen);
+            if (stop_.load())
+                return;
+            execute();
+            finished_.fetch_add(1);
+            if (joining_.load()) {
+                std::lock_guard<std::mutex> lock(park_mutex_);
+                join_cv_.notify_all();
+            }
+        }
+    }
+
+    // Wait for all workers to finish the current dispatch. Like a parked
+    // worker, the caller polls for a number of times before it waits on a
+    // condition variable. It sets joining_ before checking finished_ while
+    // holding park_mutex_, and a worker increments finished_ before checking
+    // joining_, thus either we see the last worker finished or it notifies
+    // us after we have started waiting.
+    void join ()
+    {
+        const std::size_t n = workers_.size();
+        const std::size_t num = spin_.load();
+        for (std::size_t s = 0; s != num; ++s)
+            if (finished_.load(std::memory_order_acquire) == n)
+                return;
+
+        std::unique_lock<std::mutex> lock(park_mutex_);
+        joining_.store(true);
+        while (finished_.load() != n)
+            join_cv_.wait(lock);
+        joining_.store(false);
+    }
+
+    std::size_t wait (std::size_t gen)
+    {
+        const std::size_t num = spin_.load();
+        for (std::size_t s = 0; s != num; ++s) {
+            std::size_t g = generation_.load(std::memory_order_acquire);
+            if (g != gen)
+                return g;
+        }
+
+        std::unique_lock<std::mutex> lock(park_mutex_);
+        parked_.fetch_add(1);
+        std::size_t g = generation_.load();
+        while (g == gen) {
+            park_cv_.wait(lock);
+            g = generation_.load();
+        }
+        parked_.fetch_sub(1);
+
+        return g;
+    }
+
+    static void pin_thread (std::thread &thr, std::size_t i)
+    {
+#if defined(__linux__)
+        std::size_t ncpu = static_cast<std::size_t>(
+                std::thread::hardware_concurrency());
+        if (ncpu == 0)
+            return;
+
+        cpu_set_t cpuset;
+        CPU_ZERO(&cpuset);
+        CPU_SET(static_cast<int>(i % ncpu), &cpuset);
+        ::pthread_setaffinity_np(thr.native_handle(),
+                sizeof(cpu_set_t), &cpuset);
+#else
+        (void) thr;
+        (void) i;
+#endif
+    }
+}; // class ThreadPool
+
+} // namespace vsmc
+
+#endif // VSMC_THREAD_THREAD_POOL_HPP
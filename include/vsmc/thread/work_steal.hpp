@@ -0,0 +1,278 @@
+//============================================================================
+// vSMC/include/vsmc/thread/work_steal.hpp
+//----------------------------------------------------------------------------
+//                         vSMC: Scalable Monte Carlo
+//----------------------------------------------------------------------------
+// Copyright (c) 2013-2015, Yan Zhou
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//   Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+//
+//   Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS IS
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//============================================================================
+
+#ifndef VSMC_THREAD_WORK_STEAL_HPP
+#define VSMC_THREAD_WORK_STEAL_HPP
+
+#include <vsmc/internal/common.hpp>
+#include <vsmc/thread/blocked_range.hpp>
+#include <vsmc/thread/thread_num.hpp>
+#include <vsmc/thread/thread_pool.hpp>
+#include <vsmc/utility/aligned_memory.hpp>
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+/// \brief Default number of chunks per thread of the work stealing scheduler
+/// \ingroup Config
+#ifndef VSMC_WORK_STEAL_CHUNK
+#define VSMC_WORK_STEAL_CHUNK 64
+#endif
+
+namespace vsmc {
+
+namespace internal {
+
+// Aligned so that deques of different threads are on separate cache lines
+template <typename Range>
+class alignas(64) WorkStealDeque
+{
+    public :
+
+    WorkStealDeque () : size_(0) {}
+
+    bool empty () const {return size_.load(std::memory_order_relaxed) == 0;}
+
+    void push (const Range &range)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        deque_.push_back(range);
+        size_.store(deque_.size(), std::memory_order_relaxed);
+    }
+
+    // The owner takes the newest range, which is likely still in its cache
+    bool pop (Range &range)
+    {
+        if (empty())
+            return false;
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (deque_.size() == 0)
+            return false;
+
+        range = deque_.back();
+        deque_.pop_back();
+        size_.store(deque_.size(), std::memory_order_relaxed);
+
+        return true;
+    }
+
+    // A thief takes the oldest range, which is also the largest one
+    bool steal (Range &range)
+    {
+        if (empty())
+            return false;
+
+        std::unique_lock<std::mutex> lock(mutex_, std::try_to_lock);
+        if (!lock.owns_lock() || deque_.size() == 0)
+            return false;
+
+        range = deque_.front();
+        deque_.pop_front();
+        size_.store(deque_.size(), std::memory_order_relaxed);
+
+        return true;
+    }
+
+    private :
+
+    std::mutex mutex_;
+    std::deque<Range> deque_;
+    std::atomic<std::size_t> size_;
+}; // class WorkStealDeque
+
+template <typename Range, typename WorkType>
+class WorkStealTask
+{
+    public :
+
+    typedef typename Range::const_iterator size_type;
+
+    WorkStealTask (const Range &range, std::vector<WorkType> &work_vec) :
+        work_vec_(work_vec), deque_(work_vec.size()),
+        grainsize_(grainsize(range, work_vec.size())),
+        remain_(range.size()), abort_(false)
+    {
+        std::vector<Range> range_vec(ThreadNum::instance().partition(range));
+        for (std::size_t i = 0; i != range_vec.size(); ++i)
+            deque_[i % work_vec_.size()].push(range_vec[i]);
+    }
+
+    void operator() (std::size_t i)
+    {
+        try {
+            execute(i);
+        } catch (...) {
+            abort_.store(true);
+            throw;
+        }
+    }
+
+    private :
+
+    std::vector<WorkType> &work_vec_;
+    std::vector<WorkStealDeque<Range>,
+        AlignedAllocator<WorkStealDeque<Range>, 64> > deque_;
+    const std::size_t grainsize_;
+    std::atomic<std::size_t> remain_;
+    std::atomic<bool> abort_;
+
+    WorkStealTask (const WorkStealTask<Range, WorkType> &) = delete;
+    WorkStealTask<Range, WorkType> &operator= (
+            const WorkStealTask<Range, WorkType> &) = delete;
+
+    static std::size_t grainsize (const Range &range, std::size_t n)
+    {
+        if (range.grainsize() > 1)
+            return range.grainsize();
+
+        std::size_t g = range.size() / (n * VSMC_WORK_STEAL_CHUNK);
+
+        return g > 1 ? g : 1;
+    }
+
+    // A thread that finds nothing to steal for ThreadPool::spin() polls
+    // returns to the pool, which parks it until the next dispatch. This is
+    // safe since only the owner pushes to a deque, and thus the deque of a
+    // thread that has returned stays empty. The remaining ranges are always
+    // in the deques of threads still working on them.
+    void execute (std::size_t i)
+    {
+        const std::size_t n = work_vec_.size();
+        const std::size_t spin = ThreadPool::instance().spin();
+        WorkType &work = work_vec_[i];
+        Range range;
+        std::size_t idle = 0;
+        while (!abort_.load(std::memory_order_relaxed)) {
+            bool found = deque_[i].pop(range);
+            for (std::size_t k = 1; !found && k != n; ++k)
+                found = deque_[(i + k) % n].steal(range);
+            if (found) {
+                run(i, work, range);
+                idle = 0;
+            } else if (remain_.load(std::memory_order_acquire) == 0) {
+                break;
+            } else if (++idle > spin) {
+                break;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    // Lazy binary splitting: A range larger than the grain size is split
+    // only when the owner's deque is empty and thus there is nothing else
+    // for the other threads to steal. Otherwise it is consumed by grains.
+    void run (std::size_t i, WorkType &work, const Range &range)
+    {
+        size_type begin = range.begin();
+        size_type end = range.end();
+        const size_type grain = static_cast<size_type>(grainsize_);
+        while (end - begin > grain) {
+            if (deque_[i].empty()) {
+                size_type mid = begin + (end - begin) / 2;
+                deque_[i].push(Range(mid, end));
+                end = mid;
+            } else {
+                work(Range(begin, begin + grain));
+                remain_.fetch_sub(static_cast<std::size_t>(grain),
+                        std::memory_order_release);
+                begin += grain;
+            }
+        }
+        work(Range(begin, end));
+        remain_.fetch_sub(static_cast<std::size_t>(end - begin),
+                std::memory_order_release);
+    }
+}; // class WorkStealTask
+
+} // namespace vsmc::internal
+
+/// \brief Parallel for using a work stealing scheduler
+/// \ingroup Thread
+///
+/// \details
+/// Same as `parallel_for` except that the range is dynamically scheduled
+/// among the threads of ThreadPool. The range is first partitioned equally
+/// among the threads, each keeping its own deque of subranges. A thread whose
+/// deque is empty steals the oldest, and thus the largest, subrange from
+/// other threads. A subrange larger than the grain size is split in halves
+/// only when needed to feed the thieves. The grain size is
+/// `range.grainsize()` if it is larger than one, otherwise it is
+/// `N / (VSMC_WORK_STEAL_CHUNK * thread_num)` (at least one), where `N` is
+/// the size of the range. This is suitable when the cost of `work` is uneven
+/// across the range. A thread that finds nothing to steal for
+/// `ThreadPool::spin()` polls stops stealing and is parked by the pool.
+///
+/// Requirement: Range
+/// ~~~{.cpp}
+/// Range range;
+/// Range(range.begin(), range.end());
+/// ~~~
+template <typename Range, typename WorkType>
+inline void parallel_for_steal (const Range &range, WorkType &&work)
+{
+    typedef typename cxx11::decay<WorkType>::type work_type;
+
+    if (range.size() == 0)
+        return;
+
+    std::vector<work_type> work_vec(
+            ThreadNum::instance().thread_num(), work);
+    internal::WorkStealTask<Range, work_type> task(range, work_vec);
+    ThreadPool::instance().run(work_vec.size(), task);
+}
+
+/// \brief Parallel reduce using a work stealing scheduler
+/// \ingroup Thread
+///
+/// \details
+/// Same as `parallel_reduce` except that the range is scheduled in the same
+/// way as `parallel_for_steal`. Each thread accumulates into its own copy of
+/// `work`. The copies are joined into `work` in the order of the threads
+/// after all of them finish.
+template <typename Range, typename WorkType>
+inline void parallel_reduce_steal (const Range &range, WorkType &work)
+{
+    if (range.size() == 0)
+        return;
+
+    std::vector<WorkType> work_vec(
+            ThreadNum::instance().thread_num(), work);
+    internal::WorkStealTask<Range, WorkType> task(range, work_vec);
+    ThreadPool::instance().run(work_vec.size(), task);
+    for (std::size_t i = 0; i != work_vec.size(); ++i) work.join(work_vec[i]);
+}
+
+} // namespace vsmc
+
+#endif // VSMC_THREAD_WORK_STEAL_HPP
@@ -656,6 +656,23 @@ inline void hdf5store (const StateMatrix<Order, Dim, T> &state,
             state.data(), append);
 }
 
+/// \brief Store a StateMatrix with blocked storage in the HDF5 format
+/// \ingroup HDF5IO
+///
+/// \details
+/// The data is stored in the same format as a StateMatrix with column major
+/// storage, without the padding of the tiles
+template <std::size_t Dim, typename T>
+inline void hdf5store (const StateMatrix<Blocked, Dim, T> &state,
+        const std::string &file_name, const std::string &data_name,
+        bool append = false)
+{
+    std::vector<T> data(state.size() * state.dim());
+    state.template read_state_matrix<ColMajor>(data.begin());
+    hdf5store_matrix<ColMajor, T>(state.size(), state.dim(), file_name,
+            data_name, data.begin(), append);
+}
+
 #if VSMC_HAS_CXX11LIB_TUPLE
 
 /// \brief Store a StateTuple in the HDF5 format
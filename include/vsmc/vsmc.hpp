@@ -89,6 +89,10 @@
 /// \ingroup SMP
 /// \brief Parallel samplers using C++11 concurrency
 
+/// \defgroup STEAL Work stealing
+/// \ingroup SMP
+/// \brief Parallel samplers using C++11 concurrency and work stealing
+
 /// \defgroup TBB Intel Threading Building Blocks
 /// \ingroup SMP
 /// \brief Parallel samplers using Intel TBB